@@ -14,6 +14,7 @@
 
 #include "alignedmalloc.h"
 #include "factorial.h"
+#include "placement.h"
 
 #include <typeinfo>
 #include <algorithm>
@@ -24,6 +25,8 @@
 #include <cstdint>
 #include <cassert>
 #include <vector>
+#include <mutex>
+#include <memory_resource>
 #include <immintrin.h>
 
 #if defined(__ANDROID__)
@@ -71,8 +74,9 @@ class FIRFilter {
 public:
 
 	// constructor:
-	FIRFilter(const FloatType* taps, int length)
-		: length(length), signal(nullptr), currentIndex(length - 1), lastPut(0)
+	// (buffers are allocated from memory, if given - eg an Arena, otherwise from the heap)
+	FIRFilter(const FloatType* taps, int length, std::pmr::memory_resource* memory = nullptr)
+		: length(length), signal(nullptr), currentIndex(length - 1), lastPut(0), zeroRun(length), memory(memory)
 	{
 		calcPaddedLength();
 
@@ -105,7 +109,7 @@ public:
 
 	// copy constructor:
 	FIRFilter(const FIRFilter& other)
-		: length(other.length), currentIndex(other.currentIndex), lastPut(other.lastPut)
+		: length(other.length), currentIndex(other.currentIndex), lastPut(other.lastPut), zeroRun(other.zeroRun), memory(other.memory)
 	{
 		calcPaddedLength();
 		allocateBuffers();
@@ -115,7 +119,7 @@ public:
 
 	// move constructor:
 	FIRFilter(FIRFilter&& other) noexcept
-		: length(other.length), signal(other.signal), currentIndex(other.currentIndex), lastPut(other.lastPut)
+		: length(other.length), signal(other.signal), currentIndex(other.currentIndex), lastPut(other.lastPut), zeroRun(other.zeroRun), memory(other.memory)
 	{
 		calcPaddedLength();
 
@@ -128,14 +132,18 @@ public:
 		assertAlignment();
 	}
 
-	// copy assignment:
+	// copy assignment: (buffers stay with this filter's memory resource)
 	FIRFilter& operator= (const FIRFilter& other)
 	{
+		if (this == &other) {
+			return *this;
+		}
+		freeBuffers(); // (while length is still the one they were allocated with)
 		length = other.length;
 		calcPaddedLength();
 		currentIndex = other.currentIndex;
 		lastPut = other.lastPut;
-		freeBuffers();
+		zeroRun = other.zeroRun;
 		allocateBuffers();
 		assertAlignment();
 		copyBuffers(other);
@@ -147,12 +155,14 @@ public:
 	{
 		if(this != &other) // prevent self-assignment
 		{
+			freeBuffers();
+
 			length = other.length;
 			calcPaddedLength();
 			currentIndex = other.currentIndex;
 			lastPut = other.lastPut;
-
-			freeBuffers();
+			zeroRun = other.zeroRun;
+			memory = other.memory; // (buffers are taken over, so they must be returned to where they came from)
 
 			signal = other.signal;
 			for(int i = 0; i < numVecElements; i++) {
@@ -183,6 +193,7 @@ public:
 		// reset indexes:
 		currentIndex = length - 1;
 		lastPut = 0;
+		zeroRun = length;
 
 		// clear signal buffer
 		for (int i = 0; i < paddedLength; ++i) {
@@ -191,10 +202,56 @@ public:
 		}
 	}
 
+	// setPosition() : set indexes as though puts values had been put (of which every Lth was a real sample, and the rest stuffed zeros).
+	// Signal history is not changed. (The order in which get() sums products depends on currentIndex, so a filter which is
+	// positioned this way, and then given the same history, produces bit-identical output to one which has run from the start)
+	void setPosition(int64_t puts, int L)
+	{
+		currentIndex = (length - 1) - static_cast<int>(puts % length);
+		if (puts >= L) {
+			const int64_t lastRealPut = ((puts - 1) / L) * L;
+			lastPut = (length - 1) - static_cast<int>(lastRealPut % length);
+		} else {
+			lastPut = 0;
+		}
+	}
+
+	// getMemoryRegions() : append kernel and signal buffers to regions (for reporting placement)
+	void getMemoryRegions(std::vector<Placement::MemoryRegion>& regions) const
+	{
+		regions.emplace_back(signal, (paddedLength + length) * sizeof(FloatType));
+		for(int i = 0; i < numVecElements; i++) {
+			regions.emplace_back(kernelphases[i], paddedLength * sizeof(FloatType));
+		}
+	}
+
+	// isSilent() : true if the whole history is zero (then get() is zero, and putting zeros changes nothing but the indexes)
+	bool isSilent() const
+	{
+		return zeroRun >= length;
+	}
+
+	// skipZeros() : equivalent of n calls to putZero(), when isSilent(): only the indexes need to move.
+	// (With WRAP_WITH_MEMCPY, the upper half of the buffer, which may still hold older history, is refreshed if a wrap is passed.
+	// lastPut is left alone: only lazyGet() uses it, and the next real sample's put() sets it first)
+	void skipZeros(int64_t n)
+	{
+		assert(isSilent());
+
+#ifdef WRAP_WITH_MEMCPY
+		if (n > currentIndex) {
+			memcpy(signal + length, signal, length * sizeof(FloatType)); // (lower half is all zero)
+		}
+#endif
+
+		currentIndex = (length - 1) - static_cast<int>(((length - 1 - currentIndex) + n) % length);
+	}
+
 	void put(FloatType value)
 	{
 		// Put signal in reverse order.
 		signal[currentIndex] = value;
+		zeroRun = (value == 0.0) ? std::min(zeroRun + 1, length) : 0;
 
 #ifndef WRAP_WITH_MEMCPY
 		signal[currentIndex + length] = value;
@@ -216,6 +273,7 @@ public:
 	void putZero()
 	{
 		signal[currentIndex] = 0.0;
+		zeroRun = std::min(zeroRun + 1, length);
 
 #ifndef WRAP_WITH_MEMCPY
 		signal[currentIndex + length] = 0.0;
@@ -233,8 +291,13 @@ public:
 			--currentIndex;
 	}
 
+	// get() : filter output. When the whole history is zero (eg digital silence), the result is zero without convolving
+	// (which is exactly what convolving would give: every product is zero, and the accumulators start at +0)
 	FloatType get()
 	{
+		if (zeroRun >= length) {
+			return 0.0;
+		}
 
 #ifdef FIR_QUAD_PRECISION
 
@@ -325,6 +388,10 @@ public:
 	FloatType lazyGet(int L)
 	{
 		FloatType output = 0.0;
+		if (zeroRun >= length) {
+			return output;
+		}
+
 		int offset = lastPut - currentIndex;
 		if (offset < 0) { // Wrap condition
 			offset += length;
@@ -343,6 +410,8 @@ private:
 	FloatType* signal; // Double-length signal buffer, to facilitate fast emulation of a circular buffer
 	int currentIndex;
 	int lastPut;
+	int zeroRun; // number of consecutive zeros put (up to length: then the whole history is zero)
+	std::pmr::memory_resource* memory; // (nullptr: heap)
 	int numVecElements{};
 	uintptr_t alignMask{};
 
@@ -369,11 +438,30 @@ private:
 		paddedLength = (length & alignMask) + numVecElements;
 	}
 
+	FloatType* allocate(size_t count)
+	{
+		return static_cast<FloatType*>((memory == nullptr) ?
+			aligned_malloc_huge(count * sizeof(FloatType), ALIGNMENT_SIZE) :
+			memory->allocate(count * sizeof(FloatType), ALIGNMENT_SIZE));
+	}
+
+	void deallocate(FloatType* p, size_t count)
+	{
+		if (p == nullptr) {
+			return;
+		}
+		if (memory == nullptr) {
+			aligned_free(p);
+		} else {
+			memory->deallocate(p, count * sizeof(FloatType), ALIGNMENT_SIZE);
+		}
+	}
+
 	void allocateBuffers()
 	{
-		signal = static_cast<FloatType*>(aligned_malloc((paddedLength + length) * sizeof(FloatType), ALIGNMENT_SIZE));
+		signal = allocate(paddedLength + length);
 		for(int i = 0; i < numVecElements; i++) {
-			kernelphases[i] = static_cast<FloatType*>(aligned_malloc(paddedLength * sizeof(FloatType), ALIGNMENT_SIZE));
+			kernelphases[i] = allocate(paddedLength);
 		}
 	}
 
@@ -395,9 +483,9 @@ private:
 
 	void freeBuffers()
 	{
-		aligned_free(signal);
+		deallocate(signal, paddedLength + length);
 		for(int i = 0; i < numVecElements; i++) {
-			aligned_free(kernelphases[i]);
+			deallocate(kernelphases[i], paddedLength);
 		}
 	}
 
@@ -449,6 +537,9 @@ private:
 template <>
 inline double FIRFilter<double>::get()
 {
+	if (zeroRun >= length) { // (silence - see generic get())
+		return 0.0;
+	}
 	// AVX implementation: Processes four doubles at a time.
 
 	double output = 0.0;
@@ -484,6 +575,9 @@ inline double FIRFilter<double>::get()
 template <>
 inline double FIRFilter<double>::get()
 {
+	if (zeroRun >= length) { // (silence - see generic get())
+		return 0.0;
+	}
 	// SSE Implementation: Processes two doubles at a time.
 
 	double output = 0.0;
@@ -745,20 +839,36 @@ inline std::vector<std::complex<double>> expV(const std::vector<std::complex<dou
 	return output;
 }
 
+// fftwPlannerMutex() : fftw's planner is not thread-safe; plan creation and destruction must be serialized
+// (filters may be designed concurrently, when converters are constructed on different threads)
+inline std::mutex& fftwPlannerMutex()
+{
+	static std::mutex m;
+	return m;
+}
+
 // fftV() : FFT of vector of Complex doubles
 inline std::vector<std::complex<double>> fftV(std::vector<std::complex<double>> input)
 {
 	std::vector<std::complex<double>> output(input.size(), 0); // output vector
 
 	// create, execute, destroy plan:
-	fftw_plan p = fftw_plan_dft_1d(static_cast<int>(input.size()),
-								   reinterpret_cast<fftw_complex*>(&input[0]),
-								   reinterpret_cast<fftw_complex*>(&output[0]),
-								   FFTW_FORWARD,
-								   FFTW_ESTIMATE);
+	fftw_plan p;
+	{
+		std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+		p = fftw_plan_dft_1d(static_cast<int>(input.size()),
+							 reinterpret_cast<fftw_complex*>(&input[0]),
+							 reinterpret_cast<fftw_complex*>(&output[0]),
+							 FFTW_FORWARD,
+							 FFTW_ESTIMATE);
+	}
 
 	fftw_execute(p);
-	fftw_destroy_plan(p);
+
+	{
+		std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+		fftw_destroy_plan(p);
+	}
 
 	return output;
 }
@@ -769,14 +879,22 @@ inline std::vector<std::complex<double>> ifftV(std::vector<std::complex<double>>
 	std::vector<std::complex<double>> output(input.size(), 0); // output vector
 
 	// create, execute, destroy plan:
-	fftw_plan p = fftw_plan_dft_1d(static_cast<int>(input.size()),
-								   reinterpret_cast<fftw_complex*>(&input[0]),
-								   reinterpret_cast<fftw_complex*>(&output[0]),
-								   FFTW_BACKWARD,
-								   FFTW_ESTIMATE);
+	fftw_plan p;
+	{
+		std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+		p = fftw_plan_dft_1d(static_cast<int>(input.size()),
+							 reinterpret_cast<fftw_complex*>(&input[0]),
+							 reinterpret_cast<fftw_complex*>(&output[0]),
+							 FFTW_BACKWARD,
+							 FFTW_ESTIMATE);
+	}
 
 	fftw_execute(p);
-	fftw_destroy_plan(p);
+
+	{
+		std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+		fftw_destroy_plan(p);
+	}
 
 	// scale output:
 	double reciprocalSize = 1.0 / input.size();
@@ -20,16 +20,53 @@
 #include "mpxdecode.h"
 #include "stereoimager.h"
 #include "fadeeffect.h"
+#include "limitereffect.h"
 #include "effectchain.h"
 #include "dsf.h"
 #include "dff.h"
+#include "spillbuffer.h"
+#include "mappedpcm.h"
+#include "pcmwriter.h"
+#include "simdops.h"
+#include "outputcache.h"
+#include "incremental.h"
+#include "shard.h"
+#include "threadbudget.h"
+#include "placement.h"
+#include "arena.h"
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <iostream>
 #include <vector>
+#include <memory>
 #include <iomanip>
+#include <sstream>
+#include <limits>
 #include <regex>
+#include <filesystem>
+#include <future>
+
+#if defined (__APPLE__)
+#include <sys/sysctl.h>
+#elif !defined (_WIN32) && !defined (_WIN64)
+#include <unistd.h>
+#endif
+
+#if !defined (_WIN32) && !defined (_WIN64)
+// (for server mode)
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////////////
 // This program uses the following libraries:
@@ -310,6 +347,174 @@ bool convert_IQFile_Double(ConversionInfo& ci)
 	return convert<IQFile, double>(ci);
 }
 
+bool convert_MappedPcm_Float(ConversionInfo& ci)
+{
+	return convert<MappedPcmReader, float>(ci);
+}
+
+bool convert_MappedPcm_Double(ConversionInfo& ci)
+{
+	return convert<MappedPcmReader, double>(ci);
+}
+
+// getPeakChunkValue() : get the peak input level from the PEAK chunk in the input file's header (if present).
+// Only trusted for floating-point files, since libsndfile maintains the PEAK chunk for those formats.
+template<typename FileReader>
+bool getPeakChunkValue(FileReader& infile, double& peak)
+{
+	(void)infile;
+	(void)peak;
+	return false;
+}
+
+bool getPeakChunkValue(SndfileHandle& infile, double& peak)
+{
+	const int subFormat = infile.format() & SF_FORMAT_SUBMASK;
+	if (subFormat != SF_FORMAT_FLOAT && subFormat != SF_FORMAT_DOUBLE) {
+		return false;
+	}
+
+	std::vector<double> channelPeaks(static_cast<size_t>(infile.channels()), 0.0);
+	if (infile.command(SFC_GET_MAX_ALL_CHANNELS, channelPeaks.data(), static_cast<int>(sizeof(double) * channelPeaks.size())) != SF_TRUE) {
+		return false;
+	}
+
+	peak = 0.0;
+	for (double p : channelPeaks) {
+		peak = std::max(peak, std::abs(p));
+	}
+	return true;
+}
+
+bool getPeakChunkValue(MappedPcmReader& infile, double& peak)
+{
+	return getPeakChunkValue(infile.sndfile(), peak);
+}
+
+// scanPeaksMapped() : find peak input sample by scanning a memory-map of the input file (uncompressed PCM only).
+// In multi-threaded mode, disjoint regions of the file are scanned concurrently.
+template<typename FileReader, typename FloatType>
+bool scanPeaksMapped(FileReader& infile, const ConversionInfo& ci, FloatType& peak, sf_count_t& peakPosition)
+{
+	(void)infile;
+	(void)ci;
+	(void)peak;
+	(void)peakPosition;
+	return false;
+}
+
+// scanMappedFilePeaks() : peak scan of an already-mapped file (see scanPeaksMapped())
+template<typename FloatType>
+bool scanMappedFilePeaks(const MappedPcmFile& mapped, const ConversionInfo& ci, FloatType& peak, sf_count_t& peakPosition)
+{
+	// divide file into regions:
+	const int64_t totalSamples = mapped.samples();
+	constexpr int64_t minRegionSize = 1 << 20;
+	const ThreadTokens tokens(ci.bMultiThreaded ? ThreadBudget::instance().maxThreads() - 1 : 0);
+	const int maxThreads = 1 + tokens.count();
+	const int nRegions = static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(maxThreads, totalSamples / minRegionSize)));
+	const int64_t regionSize = (totalSamples + nRegions - 1) / nRegions;
+
+	mapped.adviseSequential();
+	std::vector<FloatType> regionPeaks(static_cast<size_t>(nRegions), 0.0);
+	auto scanRegion = [&](int region) {
+		int64_t first = region * regionSize;
+		regionPeaks[region] = mapped.maxAbs<FloatType>(first, std::max<int64_t>(0, std::min(regionSize, totalSamples - first)));
+	};
+
+	if (nRegions == 1) {
+		scanRegion(0);
+	} else {
+		ctpl::thread_pool threadPool(nRegions);
+		std::vector<std::future<void>> results;
+		for (int region = 0; region < nRegions; region++) {
+			results.push_back(threadPool.push([&, region](int) { scanRegion(region); }));
+		}
+		for (auto& result : results) {
+			result.get();
+		}
+	}
+
+	// locate (first occurrence of) the peak:
+	const auto it = std::max_element(regionPeaks.begin(), regionPeaks.end());
+	peak = *it;
+	peakPosition = 0;
+	if (peak > 0.0) {
+		const int64_t first = std::distance(regionPeaks.begin(), it) * regionSize;
+		peakPosition = std::max<int64_t>(0, mapped.find(peak, first, std::min(regionSize, totalSamples - first)));
+	}
+	return true;
+}
+
+template<typename FloatType>
+bool scanPeaksMapped(SndfileHandle& infile, const ConversionInfo& ci, FloatType& peak, sf_count_t& peakPosition)
+{
+	if (ci.bRawInput) {
+		return false;
+	}
+
+	MappedPcmFile mapped(ci.inputFilename);
+	if (!MappedPcmReader::isConsistent(mapped, infile)) {
+		return false;
+	}
+	return scanMappedFilePeaks(mapped, ci, peak, peakPosition);
+}
+
+template<typename FloatType>
+bool scanPeaksMapped(MappedPcmReader& infile, const ConversionInfo& ci, FloatType& peak, sf_count_t& peakPosition)
+{
+	return infile.isMapped() && scanMappedFilePeaks(infile.mappedFile(), ci, peak, peakPosition);
+}
+
+// readPlanar() : read count samples from infile, and de-interleave them into separate channel buffers.
+// Returns number of samples read. (interleaved is used as a staging buffer, if required)
+template<typename FileReader, typename FloatType>
+sf_count_t readPlanar(FileReader& infile, FloatType* interleaved, FloatType* const* planar, int nChannels, sf_count_t count)
+{
+	const sf_count_t samplesRead = infile.read(interleaved, count);
+	SimdOps::deinterleave(interleaved, planar, nChannels, static_cast<size_t>(samplesRead / nChannels));
+	return samplesRead;
+}
+
+template<typename FloatType>
+sf_count_t readPlanar(MappedPcmReader& infile, FloatType* interleaved, FloatType* const* planar, int nChannels, sf_count_t count)
+{
+	(void)interleaved;
+	return infile.readPlanar(planar, count / nChannels) * nChannels;
+}
+
+// quantizeToInt() : fused gain, dither, quantization and peak detection, for integer output formats.
+// Reads count samples from in (every inStride-th element), and writes them to out (every outStride-th element) as left-justified ints (for sf_write_int()), and returns the peak (normalized).
+// Without dither, scaling and rounding are the same as libsndfile's float-to-int conversion.
+template<typename FloatType>
+FloatType quantizeToInt(int32_t* out, const FloatType* in, size_t count, size_t inStride, size_t outStride, FloatType gain, int bits, Ditherer<FloatType>* ditherer)
+{
+	if (ditherer == nullptr && inStride == 1 && outStride == 1) { // (contiguous: vectorised)
+		return SimdOps::quantize(in, out, count, gain, bits);
+	}
+
+	const auto shift = static_cast<uint32_t>(32 - bits);
+	const auto maxSignalMagnitude = static_cast<FloatType>((1 << (bits - 1)) - 1);
+	FloatType peak = 0.0;
+
+	if (ditherer != nullptr) {
+		long peakInt = 0;
+		for (size_t f = 0; f < count; ++f) {
+			long q = ditherer->ditherToInt(gain * in[f * inStride]);
+			peakInt = std::max(peakInt, std::abs(q));
+			out[f * outStride] = static_cast<int32_t>(static_cast<uint32_t>(q) << shift);
+		}
+		peak = static_cast<FloatType>(1.0 / maxSignalMagnitude) * static_cast<FloatType>(peakInt);
+	} else {
+		for (size_t f = 0; f < count; ++f) {
+			FloatType smpl = gain * in[f * inStride];
+			peak = std::max(peak, std::abs(smpl));
+			out[f * outStride] = static_cast<int32_t>(static_cast<uint32_t>(std::lrint(maxSignalMagnitude * smpl)) << shift);
+		}
+	}
+	return peak;
+}
+
 // convert()
 
 /* Note: type 'FileReader' MUST implement the following methods:
@@ -332,6 +537,9 @@ bool convert(ConversionInfo& ci)
 	// pointer for temp file;
 	SndfileHandle* tmpSndfileHandle = nullptr;
 
+	// raw spill buffer (used instead of temp file when ci.bSpill is set):
+	std::unique_ptr<SpillBuffer<FloatType>> spillBuffer;
+
 	// filename for temp file;
 	std::string tmpFilename;
 
@@ -406,7 +614,7 @@ bool convert(ConversionInfo& ci)
 	// read input file properties:
     const int nChannels = static_cast<int>(infile.channels());
 	ci.inputSampleRate = infile.samplerate();
-    const sf_count_t inputFrames = infile.frames();
+    const sf_count_t inputFrames = ci.bStreamInput ? 0 : infile.frames(); // (length of stdin is unknown)
     const sf_count_t inputSampleCount = inputFrames * nChannels;
     const double inputDuration = 1000.0 * inputFrames / ci.inputSampleRate; // ms
 
@@ -414,21 +622,64 @@ bool convert(ConversionInfo& ci)
 	Fraction fraction = getFractionFromSamplerates(ci.inputSampleRate, ci.outputSampleRate);
 
 
+	// determine block size (number of frames processed at a time), and how much memory each channel's converter needs:
+	// (measured by constructing one converter with a zero-capacity arena - filter designs are cached, so this costs little)
+	const bool autoBlockSize = (ci.blockSize <= 0);
+	size_t blockSize = static_cast<size_t>(std::max(0, ci.blockSize));
+	size_t converterBytes = 0;
+	size_t outputChannelBufferSize = 0;
+	{
+		ConversionInfo probeCi = ci;
+		probeCi.bShowStages = false;
+		Arena probeArena(0);
+		Converter<FloatType> probe(probeCi, &probeArena);
+		if (autoBlockSize) {
+			blockSize = probe.getAutoBlockSize(nChannels, getL2CacheSize());
+			probe.setBlockSize(blockSize);
+		}
+		converterBytes = probeArena.used();
+		outputChannelBufferSize = probe.getMaxOutputSize(blockSize);
+	}
+
 	// set buffer sizes:
-    const auto inputChannelBufferSize = static_cast<size_t>(BUFFERSIZE);
-    const auto inputBlockSize = static_cast<size_t>(BUFFERSIZE * nChannels);
-    const auto outputChannelBufferSize = static_cast<size_t>(1 + std::ceil(BUFFERSIZE * static_cast<double>(fraction.numerator) / static_cast<double>(fraction.denominator)));
-    const auto outputBlockSize = static_cast<size_t>(nChannels * (1 + outputChannelBufferSize));
-
-	// allocate buffers:
-	std::vector<FloatType> inputBlock(inputBlockSize, 0);		// input buffer for storing interleaved samples from input file
-	std::vector<FloatType> outputBlock(outputBlockSize, 0);		// output buffer for storing interleaved samples to be saved to output file
-	std::vector<std::vector<FloatType>> inputChannelBuffers;	// input buffer for each channel to store deinterleaved samples
-	std::vector<std::vector<FloatType>> outputChannelBuffers;	// output buffer for each channel to store converted deinterleaved samples
+    const auto inputChannelBufferSize = blockSize;
+    const auto inputBlockSize = blockSize * nChannels;
+    const auto outputBlockSize = outputChannelBufferSize * nChannels;
+
+	// allocate all the buffers of the conversion from one arena (see arena.h): each channel's converter and channel buffers
+	// together, in their own page-aligned region of it, followed by the interleaved blocks, and the (per-pass) output processing buffers
+	constexpr size_t arenaPageSize = 4096;
+	constexpr size_t arenaPadding = 64; // (alignment allowance, per buffer)
+	auto alignToPage = [](size_t bytes) { return (bytes + arenaPageSize - 1) & ~(arenaPageSize - 1); };
+	const size_t channelBytes = alignToPage(converterBytes + (inputChannelBufferSize + outputChannelBufferSize) * sizeof(FloatType) + 2 * arenaPadding);
+	const size_t passBytes = std::max(outputBlockSize, inputBlockSize) * sizeof(int32_t) + 4 * (outputBlockSize * sizeof(FloatType) + arenaPadding); // (int output block; effects and post-limiter buffer)
+	Arena arena(nChannels * channelBytes + (inputBlockSize + outputBlockSize) * sizeof(FloatType) + 2 * arenaPadding + passBytes);
+
+	std::vector<Converter<FloatType>> converters;
+	std::vector<std::pmr::vector<FloatType>> inputChannelBuffers;	// input buffer for each channel to store deinterleaved samples
+	std::vector<std::pmr::vector<FloatType>> outputChannelBuffers;	// output buffer for each channel to store converted deinterleaved samples
+	std::vector<FloatType*> inputChannelPointers;				// (for deinterleaving)
+	std::vector<const FloatType*> outputChannelPointers;		// (for interleaving)
+	std::vector<std::pair<size_t, size_t>> channelRegions;		// (first and end offsets of each channel's region of arena)
+	converters.reserve(static_cast<size_t>(nChannels));
+	inputChannelBuffers.reserve(static_cast<size_t>(nChannels));
+	outputChannelBuffers.reserve(static_cast<size_t>(nChannels));
 	for (int n = 0; n < nChannels; n++) {
-		inputChannelBuffers.emplace_back(std::vector<FloatType>(inputChannelBufferSize, 0));
-		outputChannelBuffers.emplace_back(std::vector<FloatType>(outputChannelBufferSize, 0));
+		const size_t first = arena.alignTo(arenaPageSize);
+		converters.emplace_back(ci, &arena);
+		if (autoBlockSize) {
+			converters.back().setBlockSize(blockSize);
+		}
+		inputChannelBuffers.emplace_back(inputChannelBufferSize, 0, &arena);
+		outputChannelBuffers.emplace_back(outputChannelBufferSize, 0, &arena);
+		inputChannelPointers.push_back(inputChannelBuffers.back().data());
+		outputChannelPointers.push_back(outputChannelBuffers.back().data());
+		channelRegions.emplace_back(first, arena.alignTo(arenaPageSize));
 	}
+	ci.blockSize = static_cast<int>(blockSize);
+
+	std::pmr::vector<FloatType> inputBlock(inputBlockSize, 0, &arena);		// input buffer for storing interleaved samples from input file
+	std::pmr::vector<FloatType> outputBlock(outputBlockSize, 0, &arena);	// output buffer for storing interleaved samples to be saved to output file
 
     const int inputFileFormat = infile.format();
 	if (inputFileFormat != DFF_FORMAT && inputFileFormat != DSF_FORMAT) { // this block only relevant to libsndfile ...
@@ -464,13 +715,34 @@ bool convert(ConversionInfo& ci)
 
 	std::cout << "source file channels: " << nChannels << std::endl;
 	std::cout << "input sample rate: " << ci.inputSampleRate << "\noutput sample rate: " << ci.outputSampleRate << std::endl;
+	std::cout << "block size: " << ci.blockSize << (autoBlockSize ? " (auto)" : "") << std::endl;
 
 	FloatType peakInputSample;
 	sf_count_t peakInputPosition = 0LL;
 	sf_count_t samplesRead = 0LL;
 	sf_count_t totalSamplesRead = 0LL;
 
-	if (ci.bEnablePeakDetection) {
+	double peakChunkValue;
+	if (ci.bEnablePeakDetection && ci.inputPeak > 0.0) { // already measured (eg shared by several output targets)
+		peakInputSample = static_cast<FloatType>(ci.inputPeak);
+		std::cout << "Peak input sample: " << fixedToString(peakInputSample) << " (" << fixedToString(20 * log10(peakInputSample)) << " dBFS) (previously measured)" << std::endl;
+	}
+
+	else if (ci.bEnablePeakDetection && !ci.bIgnorePeakChunk && getPeakChunkValue(infile, peakChunkValue)) {
+		peakInputSample = static_cast<FloatType>(peakChunkValue);
+		std::cout << "Peak input sample: " << fixedToString(peakInputSample) << " (" << fixedToString(20 * log10(peakInputSample)) << " dBFS) (from PEAK chunk)" << std::endl;
+		ci.inputPeak = peakChunkValue;
+	}
+
+	else if (ci.bEnablePeakDetection && !ci.bStreamInput && scanPeaksMapped(infile, ci, peakInputSample, peakInputPosition)) {
+		std::cout << "Scanning input file for peaks ...Done\n";
+		std::cout << "Peak input sample: " << fixedToString(peakInputSample) << " (" << fixedToString(20 * log10(peakInputSample)) << " dBFS) at ";
+		printSamplePosAsTime(peakInputPosition, ci.inputSampleRate);
+		std::cout << std::endl;
+		ci.inputPeak = peakInputSample;
+	}
+
+	else if (ci.bEnablePeakDetection && !ci.bStreamInput) {
 		peakInputSample = 0.0;
 		std::cout << "Scanning input file for peaks ...";
 
@@ -486,10 +758,16 @@ bool convert(ConversionInfo& ci)
 		} while (samplesRead > 0);
 
 		std::cout << "Done\n";
-		std::cout << "Peak input sample: " << std::fixed << peakInputSample << " (" << 20 * log10(peakInputSample) << " dBFS) at ";
+		std::cout << "Peak input sample: " << fixedToString(peakInputSample) << " (" << fixedToString(20 * log10(peakInputSample)) << " dBFS) at ";
 		printSamplePosAsTime(peakInputPosition, ci.inputSampleRate);
 		std::cout << std::endl;
 		infile.seek(0, SEEK_SET); // rewind back to start of file
+		ci.inputPeak = peakInputSample;
+	}
+
+	else if (ci.bStreamInput && ci.bNormalize) { // can't scan stdin
+		peakInputSample = 1.0;
+		std::cout << "Warning: can't scan stdin for peaks - normalizing relative to full scale" << std::endl;
 	}
 
 	else { // no peak detection
@@ -499,25 +777,24 @@ bool convert(ConversionInfo& ci)
 	}
 
 	if (ci.bNormalize) { // echo Normalization settings to user
-        const auto prec = std::cout.precision();
-		std::cout << "Normalizing to " << std::setprecision(2) << ci.limit << std::endl;
-		std::cout.precision(prec);
+		std::cout << "Normalizing to " << fixedToString(ci.limit, 2) << std::endl;
 	}
 
 	// echo filter settings to user:
 	double targetNyquist = std::min(ci.inputSampleRate, ci.outputSampleRate) / 2.0;
 	double ft = (ci.lpfCutoff / 100.0) * targetNyquist;
-    const auto prec = std::cout.precision();
-	std::cout << "LPF transition frequency: " << std::fixed << std::setprecision(2) << ft << " Hz (" << 100 * ft / targetNyquist << " %)" << std::endl;
-	std::cout.precision(prec);
+	std::cout << "LPF transition frequency: " << fixedToString(ft, 2) << " Hz (" << fixedToString(100 * ft / targetNyquist, 2) << " %)" << std::endl;
 	if (ci.bMinPhase) {
 		std::cout << "Using Minimum-Phase LPF" << std::endl;
 	}
 
 	// echo conversion ratio to user:
 	const FloatType resamplingFactor = static_cast<FloatType>(ci.outputSampleRate) / ci.inputSampleRate;
-	std::cout << "Conversion ratio: " << resamplingFactor
+	std::cout << "Conversion ratio: " << fixedToString(resamplingFactor)
 			  << " (" << fraction.numerator << ":" << fraction.denominator << ")" << std::endl;
+	if (ci.bAsrc) {
+		std::cout << "Asynchronous conversion, input clock drift: " << ci.asrcDrift << " ppm" << std::endl;
+	}
 
 	// if the outputFormat is zero, it means "No change to file format"
 	// if output file format has changed, use outputFormat. Otherwise, use same format as infile:
@@ -528,8 +805,26 @@ bool convert(ConversionInfo& ci)
 		outputFileFormat |= (inputFileFormat & SF_FORMAT_SUBMASK); // may not be valid subformat for new file format.
 	}
 
-	// for wav files, determine whether to switch to rf64 mode:
-	if ((outputFileFormat & SF_FORMAT_TYPEMASK) == SF_FORMAT_WAV || (outputFileFormat & SF_FORMAT_TYPEMASK) == SF_FORMAT_WAVEX) {
+	// when streaming from stdin, the input's subformat wasn't known in advance. If it isn't valid for the output format, use the default one:
+	if (ci.bStreamInput) {
+		SF_INFO sfinfo;
+		memset(&sfinfo, 0, sizeof(sfinfo));
+		sfinfo.channels = nChannels;
+		sfinfo.samplerate = ci.outputSampleRate;
+		sfinfo.format = outputFileFormat;
+		SF_FORMAT_INFO formatInfo;
+		formatInfo.format = outputFileFormat & SF_FORMAT_TYPEMASK;
+		if (!sf_format_check(&sfinfo) && sf_command(nullptr, SFC_GET_FORMAT_INFO, &formatInfo, sizeof(formatInfo)) == 0) {
+			auto it = defaultSubFormats.find(formatInfo.extension);
+			if (it != defaultSubFormats.end()) {
+				std::cout << "Output subformat defaulting to " << it->second << std::endl;
+				outputFileFormat = (outputFileFormat & ~SF_FORMAT_SUBMASK) | subFormats.at(it->second);
+			}
+		}
+	}
+
+	// for wav files, determine whether to switch to rf64 mode (not applicable to stdout, where the wav header doesn't specify a length):
+	if (!ci.bStreamOutput && ((outputFileFormat & SF_FORMAT_TYPEMASK) == SF_FORMAT_WAV || (outputFileFormat & SF_FORMAT_TYPEMASK) == SF_FORMAT_WAVEX)) {
 		if (ci.bRf64 ||
 				checkWarnOutputSize(inputSampleCount, getSfBytesPerSample(outputFileFormat), fraction.numerator, fraction.denominator)) {
 			std::cout << "Switching to rf64 format !" << std::endl;
@@ -572,9 +867,7 @@ bool convert(ConversionInfo& ci)
 
 	// confirm dithering options for user:
 	if (ci.bDither) {
-		auto prec = std::cout.precision();
-		std::cout << "Generating " << std::setprecision(2) << ci.ditherAmount << " bits of " << ditherProfileList[ci.ditherProfileID].name << " dither for " << outputSignalBits << "-bit output format";
-		std::cout.precision(prec);
+		std::cout << "Generating " << fixedToString(ci.ditherAmount, 2) << " bits of " << ditherProfileList[ci.ditherProfileID].name << " dither for " << outputSignalBits << "-bit output format";
 		if (ci.bAutoBlankingEnabled)
 			std::cout << ", with auto-blanking";
 		std::cout << std::endl;
@@ -589,40 +882,54 @@ bool convert(ConversionInfo& ci)
 		ditherers.emplace_back(outputSignalBits, ci.ditherAmount, ci.bAutoBlankingEnabled, n + seed, static_cast<DitherProfileID>(ci.ditherProfileID));
 	}
 
-	// make a vector of Resamplers
-	std::vector<Converter<FloatType>> converters;
-	converters.reserve(static_cast<size_t>(nChannels));
-	for (int n = 0; n < nChannels; n++) {
-		converters.emplace_back(ci);
-	}
-
 	// Calculate initial gain:
 	FloatType gain = static_cast<FloatType>(ci.gain) * static_cast<FloatType>(converters[0].getGain()) *
 			static_cast<FloatType>(ci.bNormalize ? fraction.numerator * (ci.limit / static_cast<double>(peakInputSample)) : fraction.numerator * ci.limit);
 
 	// todo: more testing with very low bit depths (eg 4 bits)
+	FloatType ditherCompensation = 1.0;
 	if (ci.bDither) { // allow headroom for dithering:
-		FloatType ditherCompensation =
+		ditherCompensation =
 				(pow(2, outputSignalBits - 1) - pow(2, ci.ditherAmount - 1)) / pow(2, outputSignalBits - 1); // eg 32767/32768 = 0.999969 (-0.00027 dB)
 		gain *= ditherCompensation;
 	}
 
     const int groupDelay = static_cast<int>(converters[0].getGroupDelay());
-	const auto tailSize = nChannels * std::ceil(std::max<size_t>(0, groupDelay) / resamplingFactor);
+	const bool transcode = converters[0].isBypassed(); // (same input and output rates: see transcodeBlock())
+	const auto tailSize = static_cast<sf_count_t>(nChannels * std::ceil(std::max<size_t>(0, groupDelay) / resamplingFactor));
 
 	FloatType peakOutputSample;
 	bool bClippingDetected;
 	RaiiTimer timer(inputDuration);
-	int clippingProtectionAttempts = 0;
+	int clippingProtectionAttempts = 0; // (complete passes which clipped)
+	bool bPassAborted = false; // (--earlyAbort: pass was abandoned when clipping was detected. Aborted passes don't count as attempts)
+	const FloatType scannedInputPeak = ci.bEnablePeakDetection ? peakInputSample : 0.0; // (used for predicting output peak after an early abort)
+
+	bool placementDone = false; // (--pinThreads / --showPlacement: place channel memory and report once, on first pass)
 
 	do { // clipping detection loop (repeats if clipping detected AND not using a temp file)
+		const ArenaScope passScope(arena); // (buffers allocated for this pass only)
 
-		infile.seek(0, SEEK_SET);
+		if (!ci.bStreamInput) {
+			infile.seek(0, SEEK_SET);
+		}
 		peakInputSample = 0.0;
 		bClippingDetected = false;
+
+		// early abort is only possible when another pass is allowed to follow this one.
+		// An aborted pass only predicts the output peak, so it doesn't use up an attempt: the complete passes which follow
+		// (at most maxClippingProtectionAttempts of them, as without early abort) measure the actual peak, and re-run if it clips.
+		// The pass which follows an aborted pass always runs to completion, so that the peak it measures (at the predicted gain)
+		// is authoritative: any re-run is then based on that, just as without early abort
+		const bool earlyAbort = ci.bEarlyAbort && !ci.bTmpFile && !ci.disableClippingProtection && !bPassAborted &&
+				(clippingProtectionAttempts + 1 < maxClippingProtectionAttempts);
+		bPassAborted = false;
 		std::unique_ptr<SndfileHandle> outFile;
+		std::unique_ptr<PcmFileWriter> nativeOutFile; // (used instead of outFile, if ci.bNativeWriter is set and output format is supported)
 		std::unique_ptr<CsvFile> csvFile;
 
+		OutputCache::detachOutput(ci.outputFilename);
+
 		if (ci.csvOutput) { // csv output
 			csvFile.reset(new CsvFile(ci.outputFilename));
 			csvFile->setNumChannels(nChannels);
@@ -667,6 +974,15 @@ bool convert(ConversionInfo& ci)
 			}
 		}
 
+		else if ((ci.bNativeWriter || ci.bStreamOutput) && PcmFileWriter::isSupported(outputFileFormat)) { // native output (always used for stdout)
+			const auto expectedFrames = static_cast<int64_t>(inputFrames * ci.outputSampleRate / ci.inputSampleRate);
+			nativeOutFile.reset(new PcmFileWriter(ci.outputFilename, outputFileFormat, nChannels, ci.outputSampleRate, expectedFrames, !ci.bNoPeakChunk));
+			if (nativeOutFile->error()) {
+				std::cout << "Error: Couldn't Open Output File (" << nativeOutFile->strError() << ")" << std::endl;
+				return false;
+			}
+		}
+
 		else { // libSndFile output
 
 			try {
@@ -701,10 +1017,7 @@ bool convert(ConversionInfo& ci)
 				// if the minor (sub) format of outputFileFormat is vorbis, and user has requested a specific quality level, set quality level:
 				if (((outputFileFormat & SF_FORMAT_VORBIS) == SF_FORMAT_VORBIS) && ci.bSetVorbisQuality) {
 
-					auto prec = std::cout.precision();
-					std::cout.precision(1);
-					std::cout << "setting vorbis quality level to " << ci.vorbisQuality << std::endl;
-					std::cout.precision(prec);
+					std::cout << "setting vorbis quality level to " << fixedToString(ci.vorbisQuality, 1) << std::endl;
 
 					double cl = (1.0 - ci.vorbisQuality) / 11.0; // Normalize from (-1 to 10), to (1.0 to 0) ... why is it backwards ?
 					outFile->command(SFC_SET_COMPRESSION_LEVEL, &cl, sizeof(cl));
@@ -719,26 +1032,35 @@ bool convert(ConversionInfo& ci)
 
 		// conditionally open a temp file:
 		if (ci.bTmpFile) {
-			tmpSndfileHandle = getTempFile<FloatType>(inputFileFormat, nChannels, ci, tmpFilename);
-			if (tmpSndfileHandle == nullptr) {
-				ci.bTmpFile = false;
+			if (ci.bSpill) {
+				spillBuffer.reset(new SpillBuffer<FloatType>(nChannels, static_cast<size_t>(ci.spillRamLimit) << 20));
+			} else {
+				tmpSndfileHandle = getTempFile<FloatType>(inputFileFormat, nChannels, ci, tmpFilename);
+				if (tmpSndfileHandle == nullptr) {
+					ci.bTmpFile = false;
+				}
 			}
 		} // ends opening of temp file
 
 		// echo conversion mode to user (multi-stage/single-stage, multi-threaded/single-threaded)
         const std::string stageness(ci.bMultiStage ? "multi-stage" : "single-stage");
         const std::string threadedness(ci.bMultiThreaded ? ", multi-threaded" : "");
-		std::cout << "Converting (" << stageness << threadedness << ") ..." << std::endl;
+		std::cout << "Converting (" << (transcode ? std::string("transcode - same sample rate") : stageness) << threadedness << ") ..." << std::endl;
+		if (ci.bMultiThreaded) {
+			std::cout << "Thread budget: " << ThreadBudget::instance().describe() << std::endl;
+		}
 
 		peakOutputSample = 0.0;
 		totalSamplesRead = 0;
-        const sf_count_t incrementalProgressThreshold = (ci.progressUpdates > 0 ) ? inputSampleCount / ci.progressUpdates : inputSampleCount + 1;
+        const sf_count_t incrementalProgressThreshold = (ci.progressUpdates > 0 && inputSampleCount > 0) ? inputSampleCount / ci.progressUpdates : std::numeric_limits<sf_count_t>::max();
 		sf_count_t nextProgressThreshold = incrementalProgressThreshold;
 
-		int outStartOffset = std::min(groupDelay * nChannels, static_cast<int>(outputBlockSize) - nChannels);
+		sf_count_t outStartOffset = static_cast<sf_count_t>(groupDelay) * nChannels; // (output samples still to be dropped, for group delay compensation)
+		sf_count_t tailRemaining = tailSize; // (zero samples still to be fed in after end of input, to flush out the group delay)
 
 		// initialise output (post-conversion) processing
 		EffectChain<FloatType> outputChain;
+		outputChain.setMemoryResource(&arena);
 		outputChain.setOutputBufferSize(outputBlockSize);
 		outputChain.setChannelCount(nChannels);
 		outputChain.setTakeOwnership(true);
@@ -767,103 +1089,323 @@ bool convert(ConversionInfo& ci)
 			outputChain.add(fadeEffect);
 		}
 
+		// lookahead limiter (single-pass alternative to clipping protection).
+		// Must be last in the chain. In limiter mode, dithering is done after the chain.
+		LimiterEffect<FloatType>* limiter = nullptr;
+		if (ci.bLimiter) {
+			limiter = new LimiterEffect<FloatType>;
+			limiter->setSampleRate(ci.outputSampleRate);
+			limiter->setThreshold(ci.limit * ditherCompensation);
+			limiter->setLookahead(ci.limiterLookahead / 1000.0);
+			limiter->setRelease(ci.limiterRelease / 1000.0);
+			limiter->setTruePeak(ci.bLimiterTruePeak);
+			std::cout << "limiter: lookahead " << ci.limiterLookahead << " ms, release " << ci.limiterRelease << " ms"
+					  << (ci.bLimiterTruePeak ? ", true-peak detection" : "") << std::endl;
+			outputChain.add(limiter);
+		}
+
+		sf_count_t limiterLatencySamples = (limiter != nullptr) ? limiter->getLatency() * nChannels : 0; // to be dropped from start of output
+		FloatType limitedPeak = 0.0;
+		std::pmr::vector<FloatType> postBuffer((limiter != nullptr && ci.bDither) ? outputBlockSize : 0, &arena);
+
         const bool hasOutputFX = !outputChain.empty();
+
+		// writeOutFile() : write (float or int) samples to output file. Returns false (after reporting the error) if not all samples were written
+		auto writeOutFile = [&](const auto* data, sf_count_t count) -> bool {
+			const sf_count_t written = nativeOutFile ? nativeOutFile->write(data, count) : outFile->write(data, count);
+			if (written != count) {
+				std::cout << "Error: couldn't write to output file (" << (nativeOutFile ? nativeOutFile->strError() : outFile->strError()) << ")" << std::endl;
+				return false;
+			}
+			return true;
+		};
+
+		// integer output formats : gain, dither, quantization and peak detection are done in a single pass (see quantizeToInt()),
+		// and the result is written directly as ints (when there is no further float processing to be done)
+		const int intOutputBits = (getIntegerPcmBits(outputFileFormat) == outputSignalBits && !ci.csvOutput) ? outputSignalBits : 0;
+		const bool intOutput = intOutputBits != 0 && !ci.bTmpFile && !hasOutputFX;
+		std::pmr::vector<int32_t> intOutputBlock(intOutputBits != 0 ? std::max<size_t>(outputBlockSize, inputBlockSize) : 0, &arena);
+
+		// finishOutput() : final output processing (limiter latency compensation and dither), then write to temp file or outfile
+		auto finishOutput = [&](const FloatType* data, sf_count_t count) -> bool {
+			if (limiter != nullptr) {
+				sf_count_t skip = std::min(limiterLatencySamples, count);
+				data += skip;
+				count -= skip;
+				limiterLatencySamples -= skip;
+				if (ci.bDither) {
+					for (sf_count_t s = 0; s < count; s += nChannels) {
+						for (int ch = 0; ch < nChannels; ++ch) {
+							// (noise-shaped dither may exceed the limiter threshold by a few LSBs)
+							FloatType smpl = ditherers[ch].dither(data[s + ch]);
+							postBuffer[s + ch] = std::max(static_cast<FloatType>(-ci.limit), std::min(smpl, static_cast<FloatType>(ci.limit)));
+						}
+					}
+					data = postBuffer.data();
+				}
+				for (sf_count_t s = 0; s < count; ++s) {
+					limitedPeak = std::max(limitedPeak, std::abs(data[s]));
+				}
+			}
+
+			if (ci.bTmpFile) {
+				if (spillBuffer) {
+					if (!spillBuffer->write(data, count)) {
+						std::cout << "Error: couldn't write to spill buffer" << std::endl;
+						return false;
+					}
+				} else if (tmpSndfileHandle->write(data, count) != count) {
+					std::cout << "Error: couldn't write to temp file (" << tmpSndfileHandle->strError() << ")" << std::endl;
+					return false;
+				}
+			} else {
+				if (ci.csvOutput) {
+					csvFile->write(data, count);
+				} else if (!writeOutFile(data, count)) {
+					return false;
+				}
+			}
+			return true;
+		};
 		// ---
 
 
-		// construct thread pool
-		ctpl::thread_pool threadPool(nChannels);
+		// construct thread pool (channels are shared among this thread and as many pool threads as the thread budget allows - see threadbudget.h)
+		const int maxChannelThreads = multiThreaded ? std::min(nChannels, ThreadBudget::instance().maxThreads()) : 1;
+		ctpl::thread_pool threadPool(std::max(1, maxChannelThreads - 1));
 		struct Result {
-			size_t outBlockindex;
+			size_t outputFrames;
 			FloatType peak;
 		};
-		std::vector<std::future<Result>> results(nChannels);
+		std::vector<Result> results(nChannels);
+		std::vector<std::future<void>> groupResults(nChannels);
+
+		// CPU / NUMA placement (see placement.h): each channel has a home group (ch % maxChannelThreads), and with --pinThreads,
+		// whichever thread runs a group is pinned to that group's CPU, so each channel always runs on the same CPU (and node) -
+		// except under a jobserver, when fewer groups are run in a block, and channels of the missing groups are shared out among the rest.
+		const Placement::AffinityGuard affinityGuard; // (this thread is unpinned again after the conversion)
+		const std::vector<int> workerCpus = ci.bPinThreads ? Placement::getWorkerCpus() : std::vector<int>{};
+		auto pinGroup = [&workerCpus](int group) {
+			if (!workerCpus.empty()) {
+				Placement::pinThread(workerCpus[group % workerCpus.size()]);
+			}
+		};
+
+		if (!placementDone && (ci.bPinThreads || ci.bShowPlacement)) {
+			placementDone = true;
+			std::vector<int> channelCpu(nChannels, -1);
+			std::vector<int> channelNode(nChannels, -1);
+			auto placeGroup = [&](int group) {
+				pinGroup(group);
+				for (int ch = group; ch < nChannels; ch += maxChannelThreads) {
+					if (!workerCpus.empty()) { // move the pages of the channel's region of the arena to the node of its CPU
+						const auto region = arena.region(channelRegions[ch].first, channelRegions[ch].second);
+						Placement::bindToNode(region.first, region.second, Placement::getCpuNode(workerCpus[group % workerCpus.size()]));
+					}
+					Placement::getCurrentCpu(channelCpu[ch], channelNode[ch]);
+				}
+			};
+			for (int group = 1; group < maxChannelThreads; group++) {
+				groupResults[group] = threadPool.push([&placeGroup, group](int) { placeGroup(group); });
+			}
+			placeGroup(0);
+			for (int group = 1; group < maxChannelThreads; group++) {
+				groupResults[group].get();
+			}
+
+			// report:
+			const int numNodes = Placement::getNumNodes();
+			std::cout << "Placement (" << numNodes << " NUMA node" << (numNodes == 1 ? "" : "s") << (workerCpus.empty() ? ", threads not pinned" : ", threads pinned") << "):" << std::endl;
+			std::cout << "Arena: " << (arena.capacity() + 1023) / 1024 << " KiB, " << (channelBytes + 1023) / 1024 << " KiB per channel";
+			if (arena.overflowCount() > 0) {
+				std::cout << " (" << arena.overflowCount() << " allocations didn't fit, and were made separately)";
+			}
+			std::cout << std::endl;
+			for (int ch = 0; ch < nChannels; ch++) {
+				auto regions = converters[ch].getMemoryRegions();
+				regions.emplace_back(inputChannelBuffers[ch].data(), inputChannelBuffers[ch].size() * sizeof(FloatType));
+				regions.emplace_back(outputChannelBuffers[ch].data(), outputChannelBuffers[ch].size() * sizeof(FloatType));
+				std::vector<size_t> pageCounts;
+				size_t bytes = 0;
+				for (const auto& region : regions) {
+					Placement::getPageNodes(region.first, region.second, pageCounts, numNodes);
+					bytes += region.second;
+				}
+				std::cout << "Channel " << ch << ": thread on CPU " << channelCpu[ch] << " (node " << channelNode[ch] << "), "
+						  << (bytes + 1023) / 1024 << " KiB of filter state and buffers in pages on";
+				for (int node = 0; node <= numNodes; node++) {
+					if (pageCounts[node] > 0) {
+						std::cout << ((node < numNodes) ? " node " + std::to_string(node) : std::string(" (no node)")) << ": " << pageCounts[node];
+					}
+				}
+				std::cout << std::endl;
+			}
+		}
+
+
 
+		// same-rate conversions (bit-depth / format changes, gain, dither) don't need de-interleaving, converters or re-interleaving:
+		// samples go straight from the interleaved input block to the interleaved output block.
+		// Without dither, a whole block is done in one (vectorised) loop. With dither, channels are done separately (each has its own ditherer),
+		// reading and writing every nChannels-th sample, and are run in threads like ordinary conversions (see processChannel())
+		const bool transcodeDither = transcode && ci.bDither && (intOutput || (!ci.bTmpFile && limiter == nullptr));
 
+		// transcodeBlock() : gain, quantization and peak detection of count interleaved samples (no dither). Returns the peak
+		auto transcodeBlock = [&](size_t count) -> FloatType {
+			if (intOutput) {
+				return quantizeToInt<FloatType>(intOutputBlock.data(), inputBlock.data(), count, 1, 1, gain, intOutputBits, nullptr);
+			}
+			const FloatType* in = inputBlock.data();
+			FloatType* out = outputBlock.data();
+			for (size_t s = 0; s < count; ++s) {
+				out[s] = gain * in[s];
+			}
+			return SimdOps::maxAbs(out, count);
+		};
+
+		// transcodeChannel() : gain, dither, quantization and peak detection of one channel's frames (with dither). Returns the peak
+		auto transcodeChannel = [&](int ch, size_t frames) -> FloatType {
+			const FloatType* in = inputBlock.data() + ch;
+			if (intOutput) {
+				return quantizeToInt(intOutputBlock.data() + ch, in, frames, nChannels, nChannels, gain, intOutputBits, &ditherers[ch]);
+			}
+			FloatType* out = outputBlock.data() + ch;
+			FloatType peak = 0.0;
+			for (size_t f = 0, s = 0; f < frames; ++f, s += nChannels) {
+				out[s] = ditherers[ch].dither(gain * in[s]);
+				peak = std::max(peak, std::abs(out[s]));
+			}
+			return peak;
+		};
 
 		bool eof = false;
 		do { // central conversion loop (the heart of the matter ...)
 
-			// Grab a block of interleaved samples from file:
-			samplesRead = infile.read(inputBlock.data(), inputBlockSize);
+			// Grab a block of samples from file, de-interleaved into channel buffers (or left interleaved, when transcoding):
+			samplesRead = transcode ?
+						infile.read(inputBlock.data(), inputBlockSize) :
+						readPlanar(infile, inputBlock.data(), inputChannelPointers.data(), nChannels, inputBlockSize);
 
 			if (samplesRead == 0) {
-				eof = true;
-				samplesRead = std::min<size_t>(tailSize, inputBlockSize);
-				std::fill_n(inputBlock.begin(), samplesRead, static_cast<FloatType>(0.0));
+				samplesRead = std::min<sf_count_t>(tailRemaining, inputBlockSize);
+				tailRemaining -= samplesRead;
+				eof = (tailRemaining == 0);
+				if (transcode) {
+					std::fill_n(inputBlock.begin(), samplesRead, static_cast<FloatType>(0.0));
+				} else {
+					for (auto& buffer : inputChannelBuffers) {
+						std::fill_n(buffer.begin(), samplesRead / nChannels, static_cast<FloatType>(0.0));
+					}
+				}
 			}
 
 			totalSamplesRead += samplesRead;
+			const auto i = static_cast<size_t>(samplesRead / nChannels);
 
-			// de-interleave into channel buffers
-			size_t i = 0;
-			for (size_t s = 0; s < samplesRead; s += nChannels) {
-				for (int ch = 0; ch < nChannels; ++ch) {
-					inputChannelBuffers[ch][i] = inputBlock[s + ch];
+			if (earlyAbort) { // track input peak (for predicting output peak)
+				if (transcode) {
+					peakInputSample = std::max(peakInputSample, SimdOps::maxAbs(inputBlock.data(), static_cast<size_t>(samplesRead)));
+				} else {
+					for (const auto& buffer : inputChannelBuffers) {
+						peakInputSample = std::max(peakInputSample, SimdOps::maxAbs(buffer.data(), i));
+					}
 				}
-				++i;
 			}
 
-			size_t outputBlockIndex = 0;
+			size_t outputFrames = 0;
 
-			for (int ch = 0; ch < nChannels; ++ch) { // run convert stage for each channel (concurrently)
+			// each channel task only touches its own (planar) buffers; interleaving is done after all channels have finished
+			auto processChannel = [&](int ch) {
+				if (transcode) {
+					return Result{i, transcodeChannel(ch, i)};
+				}
 
-				auto processingFunc = [&, ch](int) {
-					FloatType* iBuf = inputChannelBuffers[ch].data();
-					FloatType* oBuf = outputChannelBuffers[ch].data();
-					size_t o = 0;
-					FloatType localPeak = 0.0;
-					size_t localOutputBlockIndex = 0;
-					converters[ch].convert(oBuf, o, iBuf, i);
+				FloatType* iBuf = inputChannelBuffers[ch].data();
+				FloatType* oBuf = outputChannelBuffers[ch].data();
+				size_t o = 0;
+				FloatType localPeak = 0.0;
+				converters[ch].convert(oBuf, o, iBuf, i);
+
+				// gain, dither (in-place)
+				// note: disable dither for temp files (dithering to be done in post), and in limiter mode (dithering done after limiter)
+				if (intOutput) { // straight to (interleaved) int output block
+					localPeak = quantizeToInt(intOutputBlock.data() + ch, oBuf, o, 1, nChannels, gain, intOutputBits, ci.bDither ? &ditherers[ch] : nullptr);
+				} else if (ci.bDither && !ci.bTmpFile && limiter == nullptr) {
 					for (size_t f = 0; f < o; ++f) {
-						// note: disable dither for temp files (dithering to be done in post)
-						FloatType outputSample = (ci.bDither && !ci.bTmpFile) ? ditherers[ch].dither(gain * oBuf[f]) : gain * oBuf[f]; // gain, dither
-						localPeak = std::max(localPeak, std::abs(outputSample)); // peak
-						outputBlock[localOutputBlockIndex + ch] = outputSample; // interleave
-						localOutputBlockIndex += nChannels;
+						oBuf[f] = ditherers[ch].dither(gain * oBuf[f]);
+						localPeak = std::max(localPeak, std::abs(oBuf[f])); // peak
 					}
-					Result res{};
-					res.outBlockindex = localOutputBlockIndex;
-					res.peak = localPeak;
-					return res;
-				};
-
-				if (multiThreaded) {
-					results[ch] = threadPool.push(processingFunc);
 				} else {
-					Result res = processingFunc(0);
-					peakOutputSample = std::max(peakOutputSample, res.peak);
-					outputBlockIndex = res.outBlockindex;
+					for (size_t f = 0; f < o; ++f) {
+						oBuf[f] *= gain;
+						localPeak = std::max(localPeak, std::abs(oBuf[f])); // peak
+					}
 				}
-			}
 
-			if (multiThreaded) { // collect results:
-				for (int ch = 0; ch < nChannels; ++ch) {
-					Result res = results[ch].get();
+				Result res{};
+				res.outputFrames = o;
+				res.peak = localPeak;
+				return res;
+			};
+
+			if (transcode && !transcodeDither) {
+				peakOutputSample = std::max(peakOutputSample, transcodeBlock(i * nChannels));
+				outputFrames = i;
+			} else {
+				// run convert stage for each channel (concurrently, in as many groups of channels as there are threads available for this block)
+				const ThreadTokens tokens(maxChannelThreads - 1);
+				const int nGroups = 1 + tokens.count();
+				auto processGroup = [&](int group) {
+					pinGroup(group);
+					for (int ch = 0; ch < nChannels; ch++) {
+						if ((ch % maxChannelThreads) % nGroups == group) {
+							results[ch] = processChannel(ch);
+						}
+					}
+				};
+				for (int group = 1; group < nGroups; group++) {
+					groupResults[group] = threadPool.push([&processGroup, group](int) { processGroup(group); });
+				}
+				processGroup(0);
+				for (int group = 1; group < nGroups; group++) {
+					groupResults[group].get();
+				}
+				for (const auto& res : results) {
 					peakOutputSample = std::max(peakOutputSample, res.peak);
-					outputBlockIndex = res.outBlockindex;
+					outputFrames = res.outputFrames;
+				}
+
+				// interleave channel buffers into output block
+				if (!intOutput && !transcode) {
+					SimdOps::interleave(outputChannelPointers.data(), outputBlock.data(), nChannels, outputFrames);
 				}
 			}
+			const size_t outputBlockIndex = outputFrames * nChannels;
 
-			// process output (with Group Delay Compensation):
-			sf_count_t outputSampleCount = outputBlockIndex - outStartOffset;
-			const FloatType* outputData = hasOutputFX ?
-						outputChain.process(outputBlock.data(), outputSampleCount) + outStartOffset :
-						outputBlock.data() + outStartOffset;
+			// early abort: stop this pass as soon as clipping is detected, instead of converting (and writing) the rest of the file
+			if (earlyAbort && peakOutputSample > ci.limit) {
+				bPassAborted = true;
+				break;
+			}
 
-			// write out to either temp file or outfile
-			if (ci.bTmpFile) {
-				tmpSndfileHandle->write(outputData, outputSampleCount);
+			// process output (with Group Delay Compensation, which may span several blocks):
+			const auto skip = std::min<sf_count_t>(outStartOffset, outputBlockIndex);
+			const sf_count_t outputSampleCount = outputBlockIndex - skip;
+			outStartOffset -= skip;
+			if (intOutput) {
+				if (!writeOutFile(intOutputBlock.data() + skip, outputSampleCount)) {
+					return false;
+				}
 			} else {
-				if (ci.csvOutput) {
-					csvFile->write(outputData, outputSampleCount);
-				} else {
-					outFile->write(outputData, outputSampleCount);
+				const FloatType* outputData = hasOutputFX ?
+							outputChain.process(outputBlock.data() + skip, static_cast<int>(outputSampleCount)) :
+							outputBlock.data() + skip;
+
+				if (!finishOutput(outputData, outputSampleCount)) {
+					return false;
 				}
 			}
 
-			outStartOffset = 0; // reset after first use
-
 			// conditionally send progress update:
 			if (totalSamplesRead > nextProgressThreshold) {
 				int progressPercentage = std::min(static_cast<int>(99), static_cast<int>(100 * totalSamplesRead / inputSampleCount));
@@ -873,14 +1415,49 @@ bool convert(ConversionInfo& ci)
 
 		} while (!eof); // ends central conversion loop
 
-		if (ci.bTmpFile) {
+		if (limiter != nullptr) {
+			// flush limiter's delay line:
+			std::fill(outputBlock.begin(), outputBlock.end(), 0.0);
+			const auto flushBlockSize = static_cast<sf_count_t>((outputBlockSize / nChannels) * nChannels);
+			for (sf_count_t remaining = limiter->getLatency() * nChannels; remaining > 0; remaining -= flushBlockSize) {
+				auto count = std::min(remaining, flushBlockSize);
+				if (!finishOutput(outputChain.process(outputBlock.data(), static_cast<int>(count)), count)) {
+					return false;
+				}
+			}
+
+			// report gain reduction:
+			const double outputFrames = static_cast<double>(inputFrames) * ci.outputSampleRate / ci.inputSampleRate;
+			std::cout << "\nLimiter: maximum gain reduction " << fixedToString(limiter->getMaxGainReduction(), 2) << " dB, applied to "
+					  << limiter->getLimitedFrames() << " frames";
+			if (outputFrames > 0) {
+				std::cout << " (" << fixedToString(100.0 * limiter->getLimitedFrames() / outputFrames, 2) << "%)";
+			}
+			std::cout << std::endl;
+			peakOutputSample = limitedPeak;
+		}
+
+		if (bPassAborted) {
+			std::cout << "\nClipping detected at ";
+			printSamplePosAsTime(totalSamplesRead / nChannels, ci.inputSampleRate);
+			std::cout << " - aborting pass" << std::endl;
+
+			// predict peak for whole file, assuming output peaks scale with input peaks:
+			if (ci.bEnablePeakDetection && peakInputSample > 0.0 && scannedInputPeak > peakInputSample) {
+				peakOutputSample *= scannedInputPeak / peakInputSample;
+				std::cout << "Predicted peak output sample: " << fixedToString(peakOutputSample) << " (" << fixedToString(20 * log10(peakOutputSample)) << " dBFS)" << std::endl;
+			}
+			peakOutputSample *= static_cast<FloatType>(earlyAbortHeadroom); // (so that a rounding error in the prediction doesn't make the next pass clip)
+		} else if (ci.bTmpFile) {
 			gain = 1.0; // output file must start with unity gain relative to temp file
+			if (spillBuffer && ci.bShowTempFile) {
+				std::cout << "Spill buffer: " << spillBuffer->size() * sizeof(FloatType) / (1 << 20) << " MB "
+						  << (spillBuffer->isSpilled() ? "(spilled to temp file)" : "(in RAM)") << std::endl;
+			}
 		} else {
 			// notify user:
 			std::cout << "Done" << std::endl;
-			auto prec = std::cout.precision();
-			std::cout << "Peak output sample: " << std::setprecision(6) << peakOutputSample << " (" << 20 * log10(peakOutputSample) << " dBFS)" << std::endl;
-			std::cout.precision(prec);
+			std::cout << "Peak output sample: " << fixedToString(peakOutputSample) << " (" << fixedToString(20 * log10(peakOutputSample)) << " dBFS)" << std::endl;
 		}
 
 		do {
@@ -895,10 +1472,10 @@ bool convert(ConversionInfo& ci)
 
                 // echo gain adjustment to user - use slightly different message if using temp file:
 				if (ci.bTmpFile) {
-					std::cout << "Adjusting gain by " << 20 * log10(gainAdjustment) << " dB" << std::endl;
+					std::cout << "Adjusting gain by " << fixedToString(20 * log10(gainAdjustment)) << " dB" << std::endl;
 				}
 				else {
-					std::cout << "Re-doing with " << 20 * log10(gainAdjustment) << " dB gain adjustment" << std::endl;
+					std::cout << "Re-doing with " << fixedToString(20 * log10(gainAdjustment)) << " dB gain adjustment" << std::endl;
 				}
 
 				// reset the ditherers
@@ -925,31 +1502,54 @@ bool convert(ConversionInfo& ci)
 				totalSamplesRead = 0;
 				nextProgressThreshold = incrementalProgressThreshold;
 
-				tmpSndfileHandle->seek(0, SEEK_SET);
-				if (!ci.csvOutput) {
+				if (spillBuffer) {
+					spillBuffer->rewind();
+				} else {
+					tmpSndfileHandle->seek(0, SEEK_SET);
+				}
+				if (nativeOutFile) {
+					nativeOutFile->seek(0, SEEK_SET);
+				} else if (!ci.csvOutput) {
 					outFile->seek(0, SEEK_SET);
 				}
 
 				do { // Grab a block of interleaved samples from temp file:
-					samplesRead = tmpSndfileHandle->read(inputBlock.data(), inputBlockSize);
+					const FloatType* tmpData = inputBlock.data();
+					if (spillBuffer) {
+						samplesRead = spillBuffer->read(tmpData, inputBlockSize); // zero-copy
+					} else {
+						samplesRead = tmpSndfileHandle->read(inputBlock.data(), inputBlockSize);
+					}
 					totalSamplesRead += samplesRead;
 
-					// de-interleave into channels, apply gain, add dither, and save to output buffer
-					size_t i = 0;
-					for (int s = 0; s < samplesRead; s += nChannels) {
+					if (intOutputBits != 0) {
+						// apply gain, add dither, and quantize each channel straight into int output buffer
+						const auto frames = static_cast<size_t>(samplesRead / nChannels);
 						for (int ch = 0; ch < nChannels; ++ch) {
-							FloatType smpl = ci.bDither ? ditherers[ch].dither(gain * inputBlock[i]) :
-														  gain * inputBlock[i];
-							peakOutputSample = std::max(std::abs(smpl), peakOutputSample);
-							outBuf[i++] = smpl;
+							peakOutputSample = std::max(peakOutputSample,
+								quantizeToInt(intOutputBlock.data() + ch, tmpData + ch, frames, nChannels, nChannels, gain, intOutputBits, ci.bDither ? &ditherers[ch] : nullptr));
+						}
+						if (!writeOutFile(intOutputBlock.data(), samplesRead)) {
+							return false;
 						}
-					}
-
-					// write output buffer to outfile
-					if (ci.csvOutput) {
-						csvFile->write(outBuf.data(), i);
 					} else {
-						outFile->write(outBuf.data(), i);
+						// de-interleave into channels, apply gain, add dither, and save to output buffer
+						size_t i = 0;
+						for (int s = 0; s < samplesRead; s += nChannels) {
+							for (int ch = 0; ch < nChannels; ++ch) {
+								FloatType smpl = ci.bDither ? ditherers[ch].dither(gain * tmpData[i]) :
+															  gain * tmpData[i];
+								peakOutputSample = std::max(std::abs(smpl), peakOutputSample);
+								outBuf[i++] = smpl;
+							}
+						}
+
+						// write output buffer to outfile
+						if (ci.csvOutput) {
+							csvFile->write(outBuf.data(), i);
+						} else if (!writeOutFile(outBuf.data(), i)) {
+							return false;
+						}
 					}
 
 					// conditionally send progress update:
@@ -963,15 +1563,14 @@ bool convert(ConversionInfo& ci)
 				} while (samplesRead > 0);
 
 				std::cout << "Done" << std::endl;
-				auto prec = std::cout.precision();
-				std::cout << "Peak output sample: " << std::setprecision(6) << peakOutputSample << " (" << 20 * log10(peakOutputSample) << " dBFS)" << std::endl;
-				std::cout.precision(prec);
+				std::cout << "Peak output sample: " << fixedToString(peakOutputSample) << " (" << fixedToString(20 * log10(peakOutputSample)) << " dBFS)" << std::endl;
 
 			} // ends if (ci.bTmpFile)
 
 			bClippingDetected = peakOutputSample > ci.limit;
-			if (bClippingDetected)
+			if (bClippingDetected && !bPassAborted) {
 				clippingProtectionAttempts++;
+			}
 
 			// explanation of 'while' loops:
 			// 1. when clipping is detected and temp file is in use, go back to re-adjusting gain, resetting ditherers etc and repeat
@@ -979,6 +1578,12 @@ bool convert(ConversionInfo& ci)
 			// (This whole control structure might be better served with good old gotos ...)
 
 		} while (ci.bTmpFile && !ci.disableClippingProtection && bClippingDetected && clippingProtectionAttempts < maxClippingProtectionAttempts); // if using temp file, do another round if clipping detected
+
+		// close native output file here, rather than in its destructor, so that errors finishing the file aren't missed
+		if (nativeOutFile && !nativeOutFile->close()) {
+			std::cout << "Error: couldn't write to output file (" << nativeOutFile->strError() << ")" << std::endl;
+			return false;
+		}
 	} while (!ci.bTmpFile && !ci.disableClippingProtection && bClippingDetected && clippingProtectionAttempts < maxClippingProtectionAttempts); // if NOT using temp file, do another round if clipping detected
 
 	// clean-up temp file:
@@ -1203,6 +1808,37 @@ int getSfBytesPerSample(int format)
 	}
 }
 
+// getIntegerPcmBits() : return the bit depth of formats which can be written as (left-justified) ints with sf_write_int(),
+// using libsndfile's generic PCM codec (so the result is identical to writing floats). Returns 0 for all other formats.
+int getIntegerPcmBits(int format)
+{
+	switch (format & SF_FORMAT_TYPEMASK) {
+	case SF_FORMAT_WAV:
+	case SF_FORMAT_WAVEX:
+	case SF_FORMAT_AIFF:
+	case SF_FORMAT_W64:
+	case SF_FORMAT_RF64:
+	case SF_FORMAT_CAF:
+	case SF_FORMAT_AU:
+	case SF_FORMAT_RAW:
+		break;
+	default:
+		return 0;
+	}
+
+	switch (format & SF_FORMAT_SUBMASK) {
+	case SF_FORMAT_PCM_S8:
+	case SF_FORMAT_PCM_U8:
+		return 8;
+	case SF_FORMAT_PCM_16:
+		return 16;
+	case SF_FORMAT_PCM_24:
+		return 24;
+	default:
+		return 0;
+	}
+}
+
 bool checkWarnOutputSize(sf_count_t inputSamples, int bytesPerSample, int numerator, int denominator)
 {
 	sf_count_t outputDataSize = inputSamples * bytesPerSample * numerator / denominator;
@@ -1215,6 +1851,15 @@ bool checkWarnOutputSize(sf_count_t inputSamples, int bytesPerSample, int numera
 	return false;
 }
 
+// fixedToString() : value in fixed-point notation, with given number of decimal places.
+// (Formatted in a local stream: std::cout's format state is shared by conversions running concurrently, so it is never changed)
+std::string fixedToString(double value, int decimals)
+{
+	std::ostringstream s;
+	s << std::fixed << std::setprecision(decimals) << value;
+	return s.str();
+}
+
 template<typename IntType>
 std::string fmtNumberWithCommas(IntType n)
 {
@@ -1233,9 +1878,7 @@ void printSamplePosAsTime(sf_count_t samplePos, unsigned int sampleRate)
 	auto h = static_cast<int>(seconds / 3600);
 	auto m = static_cast<int>((seconds - (h * 3600)) / 60);
 	double s = seconds - (h * 3600) - (m * 60);
-	std::ios::fmtflags f(std::cout.flags());
-	std::cout << std::setprecision(0) << h << ":" << m << ":" << std::setprecision(6) << s;
-	std::cout.flags(f);
+	std::cout << h << ":" << m << ":" << fixedToString(s);
 }
 
 bool testSetMetaData(DsfFile& outfile)
@@ -1276,6 +1919,11 @@ bool getMetaData(MetaData& metadata, const IQFile& f)
 	return true;
 }
 
+bool getMetaData(MetaData& metadata, MappedPcmReader& f)
+{
+	return getMetaData(metadata, f.sndfile());
+}
+
 #ifndef USE_QUADMATH
 
 void generateExpSweep(const std::string& filename, int sampleRate, int format, double duration, int nOctaves, double amplitude_dB)
@@ -1324,6 +1972,36 @@ void generateExpSweep(const std::string& filename, int sampleRate, int format, d
 
 #endif
 
+// getL2CacheSize() : returns size of L2 cache (in bytes), or 256kB if it can't be determined
+size_t getL2CacheSize() {
+	size_t size = 0;
+#if defined (_WIN32) || defined (_WIN64)
+	DWORD bufferSize = 0;
+	GetLogicalProcessorInformation(nullptr, &bufferSize);
+	std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(bufferSize / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+	if (!info.empty() && GetLogicalProcessorInformation(info.data(), &bufferSize)) {
+		for (const auto& i : info) {
+			if (i.Relationship == RelationCache && i.Cache.Level == 2) {
+				size = i.Cache.Size;
+				break;
+			}
+		}
+	}
+#elif defined (__APPLE__)
+	uint64_t value = 0;
+	size_t length = sizeof(value);
+	if (sysctlbyname("hw.l2cachesize", &value, &length, nullptr, 0) == 0) {
+		size = static_cast<size_t>(value);
+	}
+#elif defined (_SC_LEVEL2_CACHE_SIZE)
+	const long value = sysconf(_SC_LEVEL2_CACHE_SIZE);
+	if (value > 0) {
+		size = static_cast<size_t>(value);
+	}
+#endif
+	return (size != 0) ? size : 256 * 1024;
+}
+
 bool checkSSE2() {
 #if defined (_MSC_VER) || defined (__INTEL_COMPILER)
 	bool bSSE2ok = false;
@@ -1431,49 +2109,10 @@ void showCompiler()
 }
 
 
-int runCommand(int argc, char** argv)
+// setOutputFileFormat() : determine the output file format (ci.outputFormat), from the output file extension and requested bit format,
+// relative to the format of the input file
+void setOutputFileFormat(ConversionInfo& ci)
 {
-	// test for global options
-	if (parseGlobalOptions(argc, argv)) {
-		return EXIT_SUCCESS;
-	}
-
-	// ConversionInfo instance to hold parameters
-	ConversionInfo ci;
-
-	// get path/name of this app
-#ifdef __APPLE__
-	char pathBuf[PROC_PIDPATHINFO_MAXSIZE];
-	pid_t pid = getpid();
-	if (proc_pidpath(pid, pathBuf, sizeof(pathBuf)) == 0) {
-		ci.appName.assign(pathBuf);
-	}
-#else
-	ci.appName = argv[0];
-#endif
-
-	ci.overSamplingFactor = 1;
-
-	// get conversion parameters
-	ci.fromCmdLineArgs(argc, argv);
-	if (ci.bBadParams) {
-		std::cout << strUsage << std::endl;
-		return EXIT_FAILURE;
-	}
-
-	// query build version AND cpu
-	if (!showBuildVersion()) {
-		return EXIT_FAILURE; // can't continue (CPU / build mismatch)
-	}
-
-	// echo filenames to user
-	std::cout << "Input file: " << ci.inputFilename << std::endl;
-	std::cout << "Output file: " << ci.outputFilename << std::endl;
-
-	if (ci.disableClippingProtection) {
-		std::cout << "clipping protection disabled " << std::endl;
-	}
-
 	// Isolate the file extensions
 	std::string inFileExt;
 	std::string outFileExt;
@@ -1486,6 +2125,15 @@ int runCommand(int argc, char** argv)
 		outFileExt = ci.outputFilename.substr(ci.outputFilename.find_last_of('.') + 1);
 	}
 
+	// stdin / stdout have no file extension. stdout is either wav or raw:
+	if (ci.bStreamInput && ci.bRawInput) {
+		inFileExt = "raw";
+	}
+
+	if (ci.bStreamOutput) {
+		outFileExt = ci.bRawOutput ? "raw" : "wav";
+	}
+
 	// detect dsf or dff format
 	ci.dsfInput = (inFileExt == "dsf");
 	ci.dffInput = (inFileExt == "dff");
@@ -1495,6 +2143,14 @@ int runCommand(int argc, char** argv)
 
 	if (ci.csvOutput) {
 		std::cout << "Outputting to csv format" << std::endl;
+	} else if (ci.bStreamInput && !ci.bRawInput) { // format of stdin can't be inspected in advance
+		if (!ci.outBitFormat.empty()) {
+			ci.outputFormat = determineOutputFormat(outFileExt, ci.outBitFormat);
+		}
+		SF_FORMAT_INFO formatInfo;
+		if (!ci.outputFormat && getMajorFormatFromFileExt(&formatInfo, outFileExt)) {
+			ci.outputFormat = formatInfo.format; // (subformat is taken from input, once it is open)
+		}
 	} else {
 		if (!ci.outBitFormat.empty()) {  // new output bit format requested
 			ci.outputFormat = determineOutputFormat(outFileExt, ci.outBitFormat);
@@ -1530,7 +2186,631 @@ int runCommand(int argc, char** argv)
 			}
 		}
 	}
+}
+
+// SegmentMap : correspondence between input and output frames of a conversion, for converting a segment of a longer input.
+// A segment converted with the converter positioned at the segment's start (see Converter::setPosition()) produces output which,
+// once the filters have filled, is bit-identical to the corresponding part of the output of a conversion of the whole input.
+class SegmentMap
+{
+public:
+	SegmentMap(const ConversionInfo& ci, int inputSampleRate, int64_t inputFrames) : inputFrames(inputFrames), probe(probeInfo(ci, inputSampleRate))
+	{
+		span = probe.getInputSpan();
+		groupDelay = static_cast<int>(probe.getGroupDelay());
+	}
+
+	int64_t span; // number of input frames contributing to each output frame
+	int64_t groupDelay; // number of output frames dropped from start of output (for group delay compensation)
+	const int64_t inputFrames;
+
+	// outputFrame() : first output frame which depends on input at or after inputPosition
+	int64_t outputFrame(int64_t inputPosition)
+	{
+		return probe.setPosition(std::max<int64_t>(0, std::min(inputPosition, inputFrames))) - groupDelay;
+	}
+
+	// segmentStart() : output frame corresponding to the first frame of output of a segment starting at input frame first
+	int64_t segmentStart(int64_t first)
+	{
+		return outputFrame(first) + groupDelay; // (both conversions drop groupDelay frames from the start)
+	}
+
+	// validStart() : first output frame of a segment starting at first which is identical to the output of a whole conversion (filters have filled)
+	int64_t validStart(int64_t first)
+	{
+		return (first == 0) ? 0 : outputFrame(first + span) + 1;
+	}
+
+	// validEnd() : end of the output frames of a segment ending at end which are identical to the output of a whole conversion
+	// (ie before segment's own end-of-input flush - unless segment ends with input)
+	int64_t validEnd(int64_t end)
+	{
+		return outputFrame(end) - 1;
+	}
+
+private:
+	Converter<double> probe;
+
+	static ConversionInfo probeInfo(const ConversionInfo& ci, int inputSampleRate)
+	{
+		ConversionInfo probeCi = ci;
+		probeCi.inputSampleRate = inputSampleRate;
+		probeCi.bShowStages = false;
+		return probeCi;
+	}
+};
+
+// convertSegment() : copy input frames [first, end) of (mapped) input to segmentInput (as an exact copy of the input samples, in the same format),
+// and convert it according to segmentCi (to segmentCi.outputFilename), with the converter positioned as for conversion of the whole input
+static bool convertSegment(ConversionInfo segmentCi, const MappedPcmFile& input, int64_t first, int64_t end, const std::string& segmentInput)
+{
+	{
+		SndfileHandle inputInfo(segmentCi.inputFilename);
+		SndfileHandle segmentFile(segmentInput, SFM_WRITE, inputInfo.format(), inputInfo.channels(), inputInfo.samplerate());
+		segmentFile.command(SFC_SET_ADD_PEAK_CHUNK, nullptr, SF_FALSE); // (peaks aren't tracked by writeRaw(): a PEAK chunk would say 0.0)
+		const auto bytes = static_cast<sf_count_t>((end - first) * input.bytesPerFrame());
+		if (inputInfo.error() != SF_ERR_NO_ERROR || segmentFile.error() != SF_ERR_NO_ERROR ||
+				segmentFile.writeRaw(input.data() + first * input.bytesPerFrame(), bytes) != bytes) {
+			std::cout << "Error: couldn't write " << segmentInput << std::endl;
+			return false;
+		}
+	}
+
+	segmentCi.inputFilename = segmentInput;
+	segmentCi.inputPosition = first;
+	segmentCi.bIncremental = false;
+	segmentCi.shardCount = 0;
+	segmentCi.cacheDir.clear();
+	segmentCi.bShowStages = false;
+	return convertFileUncached(segmentCi) == EXIT_SUCCESS;
+}
+
+// copyFrames() : copy count frames from infile to outfile, without altering sample values
+// (integer formats are read and written as integers; floating-point formats as doubles). Returns peak sample magnitude (or -1.0 on error)
+static double copyFrames(SndfileHandle& infile, SndfileHandle& outfile, int64_t count)
+{
+	const int nChannels = infile.channels();
+	const int subFormat = infile.format() & SF_FORMAT_SUBMASK;
+	const bool isFloat = (subFormat == SF_FORMAT_FLOAT || subFormat == SF_FORMAT_DOUBLE);
+	const sf_count_t blockFrames = 65536;
+	std::vector<double> doubles(isFloat ? blockFrames * nChannels : 0);
+	std::vector<int> ints(isFloat ? 0 : blockFrames * nChannels);
+	double peak = 0.0;
+	for (int64_t done = 0; done < count;) {
+		const sf_count_t frames = std::min<sf_count_t>(blockFrames, count - done);
+		if (isFloat) {
+			if (infile.readf(doubles.data(), frames) != frames || outfile.writef(doubles.data(), frames) != frames) {
+				return -1.0;
+			}
+			for (sf_count_t i = 0; i < frames * nChannels; i++) {
+				peak = std::max(peak, std::abs(doubles[i]));
+			}
+		} else {
+			if (infile.readf(ints.data(), frames) != frames || outfile.writef(ints.data(), frames) != frames) {
+				return -1.0;
+			}
+			for (sf_count_t i = 0; i < frames * nChannels; i++) {
+				peak = std::max(peak, std::abs(static_cast<double>(ints[i])) / 2147483648.0);
+			}
+		}
+		done += frames;
+	}
+	return peak;
+}
+
+// getIncrementalRestriction() : reason why incremental conversion (--incremental) can't be used for ci (empty if it can).
+// Patching a region of output requires the output samples to depend only on nearby input samples,
+// so whole-file or time-varying processing (normalization, dither, limiter, fades, asrc) rules it out.
+static std::string getIncrementalRestriction(const ConversionInfo& ci)
+{
+	if (ci.bStreamInput || ci.bStreamOutput) {
+		return "streaming";
+	}
+	if (ci.dsfInput || ci.dffInput || ci.bRawInput || ci.bDemodulateIQ) {
+		return "input type";
+	}
+	if (ci.csvOutput || ci.bRawOutput) {
+		return "output type";
+	}
+	if (ci.bNormalize || ci.bDither || ci.bLimiter || ci.bFadeIn || ci.bFadeOut || ci.bAsrc) {
+		return "options depend on whole file";
+	}
+	return {};
+}
+
+// updatePeakChunk() : if filename has a PEAK chunk, recalculate the peak of each channel from its samples, and rewrite the chunk
+// (needed after samples have been patched in place). Returns false if the chunk couldn't be rewritten
+static bool updatePeakChunk(const std::string& filename)
+{
+	int64_t offset;
+	std::vector<char> body;
+	{
+		MappedPcmFile file(filename);
+		if (!file.isValid()) {
+			return false;
+		}
+		offset = file.peakChunkOffset();
+		if (offset < 0) {
+			return true;
+		}
+
+		const auto channels = static_cast<size_t>(file.channels());
+		std::vector<double> peaks(channels, 0.0);
+		std::vector<int64_t> positions(channels, 0);
+		const int64_t blockFrames = 65536;
+		std::vector<double> buffer(static_cast<size_t>(blockFrames) * channels);
+		for (int64_t first = 0; first < file.frames(); first += blockFrames) {
+			const auto frames = static_cast<size_t>(std::min(blockFrames, file.frames() - first));
+			file.decode(first * static_cast<int64_t>(channels), frames * channels, buffer.data());
+			for (size_t i = 0; i < frames; i++) {
+				for (size_t ch = 0; ch < channels; ch++) {
+					const double v = std::abs(buffer[i * channels + ch]);
+					if (v > peaks[ch]) {
+						peaks[ch] = v;
+						positions[ch] = first + static_cast<int64_t>(i);
+					}
+				}
+			}
+		}
+
+		const bool bigEndian = file.headerIsBigEndian();
+		auto put32 = [&body, bigEndian](uint32_t value) {
+			for (int b = 0; b < 4; b++) {
+				body.push_back(static_cast<char>(value >> (bigEndian ? 24 - 8 * b : 8 * b)));
+			}
+		};
+		put32(1); // version
+		put32(static_cast<uint32_t>(std::time(nullptr)));
+		for (size_t ch = 0; ch < channels; ch++) {
+			const auto value = static_cast<float>(peaks[ch]);
+			uint32_t u;
+			std::memcpy(&u, &value, 4);
+			put32(u);
+			put32(static_cast<uint32_t>(positions[ch]));
+		}
+	} // (unmap before writing)
+
+	std::fstream output(filename, std::ios::in | std::ios::out | std::ios::binary);
+	output.seekp(offset);
+	output.write(body.data(), static_cast<std::streamsize>(body.size()));
+	output.close();
+	return !output.fail();
+}
+
+// patchRegions() : re-convert the changed regions of input (plus margins for the filters to fill and settle),
+// verify that the re-converted output matches the previous output exactly in the margins on either side of each change
+// (the seams), and then patch the re-converted parts into the previous output. Returns false (leaving output untouched)
+// if anything doesn't match, or can't be done.
+static bool patchRegions(const ConversionInfo& ci, const MappedPcmFile& input, std::vector<std::pair<int64_t, int64_t>> regions)
+{
+	SndfileHandle inputInfo(ci.inputFilename);
+	if (inputInfo.error() != SF_ERR_NO_ERROR) {
+		return false;
+	}
+	SegmentMap map(ci, inputInfo.samplerate(), input.frames());
+	const int64_t inputFrames = input.frames();
+
+	// margin (in input frames) on each side of a change : filters fill over one span, and the seams are checked over another
+	const int64_t verifyFrames = 16;
+	const int64_t margin = 2 * map.span + 256;
+
+	// merge regions which are close together:
+	std::vector<std::pair<int64_t, int64_t>> merged;
+	for (const auto& r : regions) {
+		if (!merged.empty() && r.first - merged.back().second < 2 * margin) {
+			merged.back().second = r.second;
+		} else {
+			merged.push_back(r);
+		}
+	}
+
+	struct Patch
+	{
+		std::string segmentFilename;
+		int64_t segmentStartFrame; // (output frame corresponding to first frame of segment's output)
+		int64_t first;
+		int64_t end;
+	};
+	std::vector<Patch> patches;
+	std::vector<std::string> tempFiles;
+	auto cleanUp = [&tempFiles]() {
+		for (const auto& f : tempFiles) {
+			std::remove(f.c_str());
+		}
+	};
+
+	auto previousFile = std::make_unique<MappedPcmFile>(ci.outputFilename);
+	const MappedPcmFile& previous = *previousFile;
+	if (!previous.isValid()) {
+		return false;
+	}
+	const int64_t bytesPerFrame = previous.bytesPerFrame();
+	const std::string inputExt = ci.inputFilename.substr(ci.inputFilename.find_last_of('.') + 1);
+	const std::string outputExt = ci.outputFilename.substr(ci.outputFilename.find_last_of('.') + 1);
+
+	for (size_t r = 0; r < merged.size(); r++) {
+		const int64_t a = merged[r].first;
+		const int64_t b = merged[r].second;
+		const int64_t s = std::max<int64_t>(0, a - margin);
+		const int64_t e = std::min(inputFrames, b + margin);
+
+		// output frames:
+		const int64_t segmentStart = map.segmentStart(s);
+		const int64_t validStart = map.validStart(s);
+		const int64_t validEnd = map.validEnd(e);
+		const int64_t changedStart = std::max(validStart, map.outputFrame(a) - 1);
+		const int64_t changedEnd = std::max(changedStart, std::min(validEnd, map.outputFrame(b + map.span) + 1));
+		const int64_t patchEnd = (e == inputFrames) ? previous.frames() : changedEnd; // (segment ending with input also re-creates the final flush)
+		if ((s != 0 && changedStart - validStart < verifyFrames) || (e != inputFrames && validEnd - changedEnd < verifyFrames)) {
+			std::cout << "Incremental: margins too small" << std::endl;
+			cleanUp();
+			return false;
+		}
+
+		// convert segment:
+		const std::string segmentInput = ci.outputFilename + ".seg" + std::to_string(r) + "-in." + inputExt;
+		const std::string segmentOutput = ci.outputFilename + ".seg" + std::to_string(r) + "-out." + outputExt;
+		tempFiles.push_back(segmentInput);
+		tempFiles.push_back(segmentOutput);
+		std::cout << "Re-converting input frames " << s << " - " << e << " (changed: " << a << " - " << b << ")" << std::endl;
+		ConversionInfo segmentCi = ci;
+		segmentCi.outputFilename = segmentOutput;
+		segmentCi.inputPeak = 0.0;
+		if (!convertSegment(segmentCi, input, s, e, segmentInput)) {
+			cleanUp();
+			return false;
+		}
+		// verify seams:
+		MappedPcmFile segment(segmentOutput);
+		if (!segment.isValid() || segment.bytesPerFrame() != bytesPerFrame || segment.sampleFormat() != previous.sampleFormat() || segment.isBigEndian() != previous.isBigEndian() ||
+			segmentStart + segment.frames() < std::max(validEnd, patchEnd) || validEnd > previous.frames()) {
+			std::cout << "Incremental: re-converted output doesn't match format of previous output" << std::endl;
+			cleanUp();
+			return false;
+		}
+		auto matches = [&](int64_t first, int64_t end) {
+			return std::memcmp(segment.data() + (first - segmentStart) * bytesPerFrame, previous.data() + first * bytesPerFrame, static_cast<size_t>((end - first) * bytesPerFrame)) == 0;
+		};
+		if (!matches(validStart, changedStart) || (changedEnd < validEnd && !matches(changedEnd, validEnd))) {
+			std::cout << "Incremental: seam verification failed (output frames " << validStart << " - " << changedStart << ", " << changedEnd << " - " << validEnd << ")" << std::endl;
+			cleanUp();
+			return false;
+		}
+		std::cout << "Seams verified (bit-exact): output frames " << validStart << " - " << changedStart << " and " << changedEnd << " - " << validEnd << std::endl;
+		patches.push_back({segmentOutput, segmentStart, changedStart, patchEnd});
+	}
+
+	// patch previous output:
+	const int64_t dataOffset = previous.offset();
+	const int64_t previousFrames = previous.frames();
+	previousFile.reset(); // (unmap before writing)
+	std::fstream output(ci.outputFilename, std::ios::in | std::ios::out | std::ios::binary);
+	int64_t patchedFrames = 0;
+	for (const auto& patch : patches) {
+		MappedPcmFile segment(patch.segmentFilename);
+		output.seekp(dataOffset + patch.first * bytesPerFrame);
+		output.write(reinterpret_cast<const char*>(segment.data() + (patch.first - patch.segmentStartFrame) * bytesPerFrame), (patch.end - patch.first) * bytesPerFrame);
+		patchedFrames += patch.end - patch.first;
+	}
+	output.close();
+	cleanUp();
+	if (!output || !updatePeakChunk(ci.outputFilename)) {
+		std::cout << "Error: couldn't write to " << ci.outputFilename << std::endl;
+		return false;
+	}
+	std::cout << "Patched " << patchedFrames << " of " << previousFrames << " output frames" << std::endl;
+	return true;
+}
+
+// convertIncremental() : convert, re-using the previous output as far as possible (--incremental)
+// The first conversion is done in full, and records block hashes of the input alongside the output (see IncrementalState).
+// Subsequent conversions (with the same options) re-convert only the regions of input which have changed, and patch them into the output.
+static int convertIncremental(ConversionInfo& ci)
+{
+	const std::string restriction = getIncrementalRestriction(ci);
+	MappedPcmFile input(restriction.empty() ? ci.inputFilename : std::string());
+	if (!restriction.empty() || !input.isValid()) {
+		std::cout << "Incremental conversion not available (" << (restriction.empty() ? "input format" : restriction) << ") : converting whole file" << std::endl;
+		if (!ci.bStreamOutput) {
+			IncrementalState::remove(ci.outputFilename);
+		}
+		return convertFileUncached(ci);
+	}
+
+	IncrementalState state;
+	const std::string key = OutputCache::makeKey(strVersion, "incremental", ci);
+	const bool havePrevious = state.load(ci.outputFilename);
+	if (havePrevious && state.key == key && state.channels == input.channels() && state.inputFrames == input.frames() && state.outputUnchanged(ci.outputFilename)) {
+		const auto hashes = IncrementalState::hashBlocks(input, state.blockFrames);
+		const auto regions = state.getChangedRegions(hashes);
+		if (regions.empty()) {
+			std::cout << "Incremental: input unchanged - output is up to date" << std::endl;
+			return EXIT_SUCCESS;
+		}
+		int64_t changedFrames = 0;
+		for (const auto& r : regions) {
+			changedFrames += r.second - r.first;
+		}
+		std::cout << "Incremental: " << changedFrames << " of " << input.frames() << " input frames changed, in " << regions.size() << " region" << (regions.size() == 1 ? "" : "s") << std::endl;
+		if (changedFrames < input.frames() / 2 && patchRegions(ci, input, regions)) {
+			state.blockHashes = hashes;
+			if (state.setOutput(ci.outputFilename)) {
+				state.save(ci.outputFilename);
+			}
+			return EXIT_SUCCESS;
+		}
+		std::cout << "Incremental: converting whole file" << std::endl;
+	} else if (havePrevious) {
+		std::cout << "Incremental: previous output doesn't correspond to this input / options : converting whole file" << std::endl;
+	}
+
+	IncrementalState::remove(ci.outputFilename);
+	const int result = convertFileUncached(ci);
+	if (result == EXIT_SUCCESS) {
+		if (MappedPcmFile(ci.outputFilename).isValid()) {
+			state = IncrementalState();
+			state.key = key;
+			state.setInput(input);
+			if (state.setOutput(ci.outputFilename)) {
+				state.save(ci.outputFilename);
+			}
+		} else {
+			std::cout << "Incremental: output format can't be patched (incremental conversion needs wav, rf64, w64 or aiff output)" << std::endl;
+		}
+	}
+	return result;
+}
+
+// convertShard() : convert part k of N of the input (--shard k/N) to a shard file, to be combined with the other parts by --merge.
+// Each part is converted from its own range of input (plus pre-roll and post-roll, for the filters to fill), with the converter
+// positioned as for the whole input, so that the merged output is identical to the output of a conversion of the whole input,
+// except that dither is seeded differently for each part (seed derived from --seed), and clipping protection is disabled
+// (since the parts must all have the same gain).
+static int convertShard(ConversionInfo& ci)
+{
+	const int k = ci.shardIndex;
+	const int n = ci.shardCount;
+	if (ci.bStreamInput || ci.bStreamOutput || ci.dsfInput || ci.dffInput || ci.bRawInput || ci.bDemodulateIQ || ci.csvOutput || ci.bRawOutput) {
+		std::cout << "Error: --shard isn't available for this input / output type" << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (ci.bLimiter || ci.bFadeIn || ci.bFadeOut || ci.bAsrc) {
+		std::cout << "Error: --shard can't be used with --limiter, --fade-in, --fade-out or --asrc" << std::endl;
+		return EXIT_FAILURE;
+	}
+	MappedPcmFile input(ci.inputFilename);
+	SndfileHandle inputInfo(ci.inputFilename);
+	if (!input.isValid() || inputInfo.error() != SF_ERR_NO_ERROR) {
+		std::cout << "Error: --shard requires wav, rf64, w64 or aiff input" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// ranges of input and output:
+	SegmentMap map(ci, inputInfo.samplerate(), input.frames());
+	const int64_t inputFrames = input.frames();
+	const int64_t a = inputFrames * (k - 1) / n;
+	const int64_t b = inputFrames * k / n;
+	const int64_t preRoll = 2 * map.span + 1024; // (also warms up noise-shaping)
+	const int64_t s = std::max<int64_t>(0, a - preRoll);
+	const int64_t e = std::min(inputFrames, b + preRoll);
+	const int64_t outputStart = (k == 1) ? 0 : map.outputFrame(a);
+	int64_t outputEnd = map.outputFrame(b); // (last part: end of output)
+	std::cout << "Shard " << k << " of " << n << ": input frames " << a << " - " << b << " (converting " << s << " - " << e << ")" << std::endl;
+
+	ConversionInfo segmentCi = ci;
+	if (!ci.disableClippingProtection) {
+		std::cout << "Clipping protection disabled for shards (use -n to leave headroom)" << std::endl;
+		segmentCi.disableClippingProtection = true;
+	}
+	if (ci.bNormalize && ci.inputPeak == 0.0) { // (normalize all parts according to peak of whole input)
+		segmentCi.inputPeak = input.maxAbs<double>(0, input.samples());
+	}
+	if (ci.bDither) {
+		if (ci.bUseSeed) {
+			segmentCi.seed = static_cast<int>(static_cast<uint32_t>(ci.seed) + 0x9e3779b9u * static_cast<uint32_t>(k));
+			std::cout << "Shard dither seed: " << segmentCi.seed << std::endl;
+		} else {
+			std::cout << "Warning: dither without --seed : shards won't be reproducible" << std::endl;
+		}
+	}
+
+	// convert segment, and copy this part's output to shard file:
+	const std::string inputExt = ci.inputFilename.substr(ci.inputFilename.find_last_of('.') + 1);
+	const std::string outputExt = ci.outputFilename.substr(ci.outputFilename.find_last_of('.') + 1);
+	const std::string segmentInput = ci.outputFilename + ".seg-in." + inputExt;
+	const std::string segmentOutput = ci.outputFilename + ".seg-out." + outputExt;
+	segmentCi.outputFilename = segmentOutput;
+	bool ok = convertSegment(segmentCi, input, s, e, segmentInput);
+	std::remove(segmentInput.c_str());
+	if (ok) {
+		SndfileHandle segment(segmentOutput);
+		const int64_t segmentStart = map.segmentStart(s);
+		if (k == n) {
+			outputEnd = segmentStart + segment.frames();
+		}
+		ok = segment.error() == SF_ERR_NO_ERROR && outputStart >= map.validStart(s) && (k == n || outputEnd <= map.validEnd(e)) &&
+				outputEnd <= segmentStart + segment.frames() && segment.seek(outputStart - segmentStart, SEEK_SET) >= 0;
+		if (ok) {
+			OutputCache::detachOutput(ci.outputFilename);
+			SndfileHandle shard(ci.outputFilename, SFM_WRITE, segment.format(), segment.channels(), segment.samplerate());
+			if (ci.bNoPeakChunk) {
+				shard.command(SFC_SET_ADD_PEAK_CHUNK, nullptr, SF_FALSE);
+			}
+			MetaData m;
+			if (ci.bWriteMetaData && getMetaData(m, inputInfo)) {
+				setMetaData(m, shard);
+			}
+			ok = shard.error() == SF_ERR_NO_ERROR && copyFrames(segment, shard, outputEnd - outputStart) >= 0.0;
+		}
+	}
+	std::remove(segmentOutput.c_str());
+	if (!ok) {
+		std::cout << "Error: couldn't convert shard " << k << " of " << n << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	ShardInfo info;
+	info.key = OutputCache::makeKey(strVersion, "shard " + std::to_string(inputFrames), ci);
+	info.index = k;
+	info.count = n;
+	info.outputStart = outputStart;
+	info.outputFrames = outputEnd - outputStart;
+	if (!info.save(ci.outputFilename)) {
+		std::cout << "Error: couldn't write " << ShardInfo::infoFilename(ci.outputFilename) << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "Shard " << k << " of " << n << " written: output frames " << outputStart << " - " << outputEnd << std::endl;
+	return EXIT_SUCCESS;
+}
+
+// mergeShards() : combine the shard files of all N parts of a sharded conversion (in any order) into outputFilename (--merge).
+// Samples are copied exactly; the header (including PEAK chunk, for floating-point formats) is written for the whole output
+int mergeShards(const std::vector<std::string>& shardFilenames, const std::string& outputFilename, bool noPeakChunk, bool writeMetaData)
+{
+	if (shardFilenames.empty() || outputFilename.empty()) {
+		std::cout << "Error: usage: --merge <shard files> -o <outputfile>" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// check that shards are all parts of the same conversion, and together cover the whole output:
+	std::vector<std::pair<ShardInfo, std::string>> shards;
+	for (const auto& filename : shardFilenames) {
+		ShardInfo info;
+		if (!info.load(filename)) {
+			std::cout << "Error: " << filename << " is not a shard (missing or invalid " << ShardInfo::infoFilename(filename) << ")" << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (!shards.empty() && (info.key != shards.front().first.key || info.count != shards.front().first.count)) {
+			std::cout << "Error: " << filename << " is not part of the same conversion as " << shards.front().second << std::endl;
+			return EXIT_FAILURE;
+		}
+		shards.emplace_back(info, filename);
+	}
+	std::sort(shards.begin(), shards.end(), [](const auto& x, const auto& y) {
+		return x.first.index < y.first.index;
+	});
+	const int n = shards.front().first.count;
+	int64_t totalFrames = 0;
+	for (int i = 0; i < n; i++) {
+		if (i >= static_cast<int>(shards.size()) || shards[i].first.index != i + 1) {
+			std::cout << "Error: shard " << (i + 1) << " of " << n << (i < static_cast<int>(shards.size()) && shards[i].first.index == i ? " given more than once" : " missing") << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (shards[i].first.outputStart != totalFrames) {
+			std::cout << "Error: shards " << i << " and " << (i + 1) << " are not contiguous" << std::endl;
+			return EXIT_FAILURE;
+		}
+		totalFrames += shards[i].first.outputFrames;
+	}
+	if (static_cast<int>(shards.size()) != n) {
+		std::cout << "Error: more than " << n << " shards given" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<std::unique_ptr<SndfileHandle>> inputs;
+	for (const auto& shard : shards) {
+		inputs.emplace_back(new SndfileHandle(shard.second));
+		const SndfileHandle& f = *inputs.back();
+		const SndfileHandle& first = *inputs.front();
+		if (f.error() != SF_ERR_NO_ERROR || f.frames() != shard.first.outputFrames || f.channels() != first.channels() ||
+				f.samplerate() != first.samplerate() || (f.format() & SF_FORMAT_SUBMASK) != (first.format() & SF_FORMAT_SUBMASK)) {
+			std::cout << "Error: " << shard.second << " doesn't match its shard description, or the other shards" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// output format : as shards (switching wav to rf64, if necessary):
+	SndfileHandle& first = *inputs.front();
+	int outputFormat = first.format();
+	const int majorFormat = outputFormat & SF_FORMAT_TYPEMASK;
+	if ((majorFormat == SF_FORMAT_WAV || majorFormat == SF_FORMAT_WAVEX || majorFormat == SF_FORMAT_RF64) &&
+			checkWarnOutputSize(totalFrames * first.channels(), getSfBytesPerSample(outputFormat), 1, 1)) {
+		std::cout << "Switching to rf64 format !" << std::endl;
+		outputFormat = (outputFormat & ~SF_FORMAT_TYPEMASK) | SF_FORMAT_RF64;
+	} else if (majorFormat == SF_FORMAT_RF64) {
+		outputFormat = (outputFormat & ~SF_FORMAT_TYPEMASK) | SF_FORMAT_WAV;
+	}
+
+	std::cout << "Merging " << n << " shards (" << totalFrames << " frames) into " << outputFilename << std::endl;
+	double peak = 0.0;
+	{
+		OutputCache::detachOutput(outputFilename);
+		SndfileHandle output(outputFilename, SFM_WRITE, outputFormat, first.channels(), first.samplerate());
+		if (output.error() != SF_ERR_NO_ERROR) {
+			std::cout << "Error: Couldn't Open Output File (" << output.strError() << ")" << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (noPeakChunk) {
+			output.command(SFC_SET_ADD_PEAK_CHUNK, nullptr, SF_FALSE);
+		}
+		MetaData m;
+		if (writeMetaData && getMetaData(m, first)) {
+			setMetaData(m, output);
+		}
+		for (size_t i = 0; i < inputs.size(); i++) {
+			const double shardPeak = copyFrames(*inputs[i], output, shards[i].first.outputFrames);
+			if (shardPeak < 0.0) {
+				std::cout << "Error: couldn't copy " << shards[i].second << std::endl;
+				return EXIT_FAILURE;
+			}
+			peak = std::max(peak, shardPeak);
+		}
+	}
+	std::cout << "Peak output sample: " << fixedToString(peak) << " (" << fixedToString(20 * std::log10(peak)) << " dBFS)" << std::endl;
+	return EXIT_SUCCESS;
+}
+
+// convertFile() : perform conversion, sharded, incremental, or using output cache (if enabled)
+int convertFile(ConversionInfo& ci)
+{
+	if (ci.shardCount > 0) {
+		return convertShard(ci);
+	}
+
+	if (ci.bIncremental) {
+		return convertIncremental(ci);
+	}
+
+	if (ci.cacheDir.empty()) {
+		return convertFileUncached(ci);
+	}
+
+	if (ci.bStreamInput || ci.bStreamOutput) {
+		std::cout << "Output cache not used when streaming" << std::endl;
+		return convertFileUncached(ci);
+	}
+
+	if (ci.bDither && !ci.bUseSeed) {
+		std::cout << "Output cache not used: dither without --seed gives a different result each time" << std::endl;
+		return convertFileUncached(ci);
+	}
+
+	OutputCache cache(ci.cacheDir);
+	const std::string inputHash = cache.getInputHash(ci.inputFilename);
+	if (inputHash.empty()) {
+		return convertFileUncached(ci); // (let conversion report the problem with the input file)
+	}
+
+	const std::string key = OutputCache::makeKey(strVersion, inputHash, ci);
+	bool linked = false;
+	if (cache.fetch(key, ci.outputFilename, ci.bCacheLink, linked)) {
+		std::cout << "Output cache hit: " << key << (linked ? " (linked)" : " (copied)") << std::endl;
+		return EXIT_SUCCESS;
+	}
+
+	std::cout << "Output cache miss: " << key << std::endl;
+	const int result = convertFileUncached(ci);
+	if (result == EXIT_SUCCESS && !cache.store(key, ci.outputFilename)) {
+		std::cout << "Warning: couldn't store output in cache " << ci.cacheDir << std::endl;
+	}
+	return result;
+}
 
+// convertFileUncached() : choose appropriate convert() function, and perform the conversion described by ci
+// (whose output format has been set by setOutputFileFormat()). Returns exit code
+int convertFileUncached(ConversionInfo& ci)
+{
 	try {
 
 		if (ci.bUseDoublePrecision) {
@@ -1584,6 +2864,10 @@ int runCommand(int argc, char** argv)
 				return convert_IQFile_Double(ci) ? EXIT_SUCCESS : EXIT_FAILURE;
 			}
 
+			if (ci.bMmapInput) {
+				return convert_MappedPcm_Double(ci) ? EXIT_SUCCESS : EXIT_FAILURE;
+			}
+
 			return convert_SndfileHandle_Double(ci) ? EXIT_SUCCESS : EXIT_FAILURE;
 
 		} // if (ci.bUseDoublePrecision)
@@ -1608,6 +2892,10 @@ int runCommand(int argc, char** argv)
 			return convert_IQFile_Float(ci) ? EXIT_SUCCESS : EXIT_FAILURE;
 		}
 
+		if (ci.bMmapInput) {
+			return convert_MappedPcm_Float(ci) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+
 		return convert_SndfileHandle_Float(ci) ? EXIT_SUCCESS : EXIT_FAILURE;
 
 	} //ends try block
@@ -1618,6 +2906,683 @@ int runCommand(int argc, char** argv)
 	}
 }
 
+// getIntermediateConversionInfo() : parameters for rendering an intermediate (shared) file for a multi-target conversion:
+// unity gain, no post-processing, 64-bit floating-point output
+ConversionInfo getIntermediateConversionInfo(const ConversionInfo& target, const std::string& outputFilename, int outputSampleRate)
+{
+	ConversionInfo ci = target;
+	ci.outputFilename = outputFilename;
+	ci.outputSampleRate = outputSampleRate;
+	ci.outputFormat = SF_FORMAT_WAV | SF_FORMAT_DOUBLE;
+	ci.outBitFormat = "64f";
+	ci.csvOutput = false;
+	ci.gain = 1.0;
+	ci.limit = 1.0;
+	ci.bNormalize = false;
+	ci.bDither = false;
+	ci.quantize = false;
+	ci.bLimiter = false;
+	ci.disableClippingProtection = true;
+	ci.bEarlyAbort = false;
+	ci.bTmpFile = false;
+	ci.bFadeIn = false;
+	ci.bFadeOut = false;
+	ci.bAdjustStereoWidth = false;
+	ci.bAsrc = false;
+	ci.bShowStages = false;
+	ci.cacheDir.clear();
+	return ci;
+}
+
+// runFanOut() : convert one input file to several output targets (each with its own sample rate and format), sharing work between them:
+// 1. input which can't be memory-mapped (eg compressed formats) is decoded only once, to a temp file
+// 2. the input peak is measured only once
+// 3. targets at (or below) input rate / 2^k share their first stage(s) of decimation,
+//    which is rendered once, to an intermediate file at input rate / 2^k (k is chosen so that at least two targets benefit)
+// 4. the targets are then converted concurrently, each from the most-decimated source available to it.
+// Temp / intermediate files are 64-bit floating-point, and are removed when all targets are done.
+int runFanOut(const std::vector<std::vector<std::string>>& targetArgs)
+{
+	// get parameters of each target:
+	std::vector<ConversionInfo> targets(targetArgs.size());
+	for (size_t t = 0; t < targets.size(); t++) {
+		std::vector<char*> argv;
+		for (const auto& arg : targetArgs[t]) {
+			argv.push_back(const_cast<char*>(arg.c_str()));
+		}
+		ConversionInfo& ci = targets[t];
+		ci.appName = argv[0];
+		ci.overSamplingFactor = 1;
+		ci.fromCmdLineArgs(static_cast<int>(argv.size()), argv.data());
+		if (ci.bBadParams) {
+			std::cout << strUsage << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (ci.bStreamInput || ci.bStreamOutput || ci.bDemodulateIQ) {
+			std::cout << "Error: multiple output targets require named input and output files, and can't be used with --demodulateIQ" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	const ConversionInfo& first = targets[0];
+	std::cout << "Input file: " << first.inputFilename << std::endl;
+	for (auto& ci : targets) {
+		std::cout << "Output file: " << ci.outputFilename << " (" << ci.outputSampleRate << " Hz)" << std::endl;
+		setOutputFileFormat(ci); // (output formats are determined relative to the original input)
+	}
+
+	// get input sample rate and format:
+	const bool dsdInput = first.dsfInput || first.dffInput;
+	int inputRate = 0;
+	int inputFormat = 0;
+	if (first.dsfInput) {
+		DsfFile infile(first.inputFilename, Dsf_read, 0, 0, 0);
+		inputRate = infile.error() ? 0 : static_cast<int>(infile.samplerate());
+	} else if (first.dffInput) {
+		DffFile infile(first.inputFilename, Dff_read, 0, 0, 0);
+		inputRate = infile.error() ? 0 : static_cast<int>(infile.samplerate());
+	} else if (first.bRawInput) {
+		auto it = subFormats.find(first.rawInputBitFormat);
+		inputRate = first.rawInputSampleRate;
+		inputFormat = SF_FORMAT_RAW | ((it != subFormats.end()) ? it->second : SF_FORMAT_PCM_16);
+	} else {
+		SndfileHandle infile(first.inputFilename, SFM_READ);
+		inputRate = infile.error() ? 0 : infile.samplerate();
+		inputFormat = infile.format();
+	}
+
+	if (inputRate <= 0) {
+		std::cout << "Error: Couldn't Open Input File" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	for (auto& ci : targets) { // (unchanged format must now be explicit, since the target may be converted from an intermediate file)
+		if (ci.outputFormat == 0) {
+			ci.outputFormat = inputFormat;
+		}
+	}
+
+	// plan the tree of shared stages: level k is an intermediate file at (inputRate / 2^k), which is shared by all targets
+	// whose rates are reached from it by further decimation by a power of two (including none).
+	// Each target is converted from the deepest level shared with at least one other target.
+	// (targets in a different rate family, eg 44.1kHz from a 96kHz master, are converted directly, since that is cleaner than going via 48kHz)
+	std::vector<int> targetLevel(targets.size(), 0);
+	for (int k = 1; k < 30 && (inputRate % (1 << k)) == 0; k++) {
+		const int rate = inputRate >> k;
+		std::vector<size_t> members;
+		for (size_t t = 0; t < targets.size(); t++) {
+			const ConversionInfo& ci = targets[t];
+			const int r = ci.outputSampleRate;
+			const bool eligible = !ci.bSingleStage && !ci.bAsrc && ci.maxStages > 1;
+			if (eligible && r > 0 && rate % r == 0 && ((rate / r) & (rate / r - 1)) == 0) {
+				members.push_back(t);
+			}
+		}
+		if (members.size() < 2) {
+			break; // (deeper levels can only have fewer members)
+		}
+		for (size_t t : members) {
+			targetLevel[t] = k;
+		}
+	}
+
+	std::vector<int> levels(targetLevel.begin(), targetLevel.end());
+	levels.erase(std::remove(levels.begin(), levels.end(), 0), levels.end());
+	std::sort(levels.begin(), levels.end());
+	levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+
+	std::vector<std::string> tempFiles;
+	auto makeTempFilename = [&first, &tempFiles](const std::string& description) {
+		tempFiles.push_back(first.outputFilename + "." + description + ".tmp.wav");
+		return tempFiles.back();
+	};
+
+	auto cleanUp = [&tempFiles]() {
+		for (const auto& filename : tempFiles) {
+			std::remove(filename.c_str());
+		}
+	};
+
+	// decode input once, if it would otherwise be decoded more than once:
+	std::string source = first.inputFilename;
+	double inputPeak = 0.0;
+	const int directReaders = static_cast<int>(std::count(targetLevel.begin(), targetLevel.end(), 0)) + (levels.empty() ? 0 : 1);
+	const bool mappable = !dsdInput && !first.bRawInput && first.bMmapInput && MappedPcmFile(first.inputFilename).isValid();
+	if (!dsdInput && !mappable && directReaders >= 2) {
+		std::cout << "\nDecoding input (once, for all targets) ..." << std::endl;
+		ConversionInfo ci = getIntermediateConversionInfo(first, makeTempFilename("decoded"), inputRate);
+		if (convertFile(ci) != EXIT_SUCCESS) {
+			cleanUp();
+			return EXIT_FAILURE;
+		}
+		source = ci.outputFilename;
+		inputPeak = ci.inputPeak;
+	}
+
+	// render shared stages (each level from the one above it):
+	std::map<int, std::string> levelSources{{0, source}};
+	std::string levelSource = source;
+	int levelSourceRate = inputRate;
+	for (int level : levels) {
+		const int rate = inputRate >> level;
+		std::cout << "\nRendering shared stage (" << levelSourceRate << " Hz -> " << rate << " Hz) for";
+		bool targetAtRate = false;
+		double ft = 0.0; // (highest transition frequency of targets using this stage)
+		for (size_t t = 0; t < targets.size(); t++) {
+			if (targetLevel[t] >= level) {
+				std::cout << " " << targets[t].outputSampleRate;
+				targetAtRate |= (targets[t].outputSampleRate == rate);
+				ft = std::max(ft, targets[t].lpfCutoff / 100.0 * targets[t].outputSampleRate / 2.0);
+			}
+		}
+		std::cout << " Hz targets ..." << std::endl;
+
+		ConversionInfo ci = getIntermediateConversionInfo(first, makeTempFilename(std::to_string(rate)), rate);
+		ci.inputFilename = levelSource;
+		ci.inputPeak = inputPeak;
+		if (levelSource != first.inputFilename) {
+			ci.dsfInput = false;
+			ci.dffInput = false;
+			ci.bRawInput = false;
+		}
+
+		// a target at this rate gets exactly the filter it would have had anyway.
+		// Otherwise, the passband must accommodate the highest target, and (as for the first stage of a multi-stage conversion - see Converter::initMultistage())
+		// the stop band may start at the nyquist frequency of this rate (scaled by the same 'stretch' as the final filter)
+		if (!targetAtRate) {
+			const double nyquist = rate / 2.0;
+			const double stopFreq = nyquist * (first.lpfCutoff + first.lpfTransitionWidth) / 100.0;
+			ci.lpfMode = custom;
+			ci.lpfTransitionWidth = 100.0 * (stopFreq - ft) / nyquist / 2.0;
+			ci.lpfCutoff = 100.0 - ci.lpfTransitionWidth;
+		}
+
+		if (convertFile(ci) != EXIT_SUCCESS) {
+			cleanUp();
+			return EXIT_FAILURE;
+		}
+		if (inputPeak == 0.0) {
+			inputPeak = ci.inputPeak;
+		}
+		levelSource = ci.outputFilename;
+		levelSourceRate = rate;
+		levelSources[level] = levelSource;
+	}
+
+	// otherwise, measure input peak once (instead of each target scanning the input):
+	if (inputPeak == 0.0 && mappable) {
+		MappedPcmReader infile(first.inputFilename);
+		double peak = 0.0;
+		sf_count_t peakPosition = 0;
+		if ((!first.bIgnorePeakChunk && getPeakChunkValue(infile, peak)) || scanPeaksMapped(infile, first, peak, peakPosition)) {
+			inputPeak = peak;
+		}
+	}
+
+	// point each target at its source:
+	for (size_t t = 0; t < targets.size(); t++) {
+		ConversionInfo& ci = targets[t];
+		ci.inputPeak = inputPeak;
+		const std::string& s = levelSources[targetLevel[t]];
+		if (s != ci.inputFilename) {
+			ci.inputFilename = s;
+			ci.cacheDir.clear(); // (output cache is keyed on the original input)
+			ci.dsfInput = false;
+			ci.dffInput = false;
+			ci.bRawInput = false;
+		}
+	}
+
+	// convert all targets concurrently (messages from each target are collected, and shown when all are done):
+	std::cout << "\nConverting " << targets.size() << " targets ..." << std::endl;
+	std::vector<std::string> logs(targets.size());
+	std::vector<int> results(targets.size(), EXIT_FAILURE);
+	{
+		ThreadCoutBuffer coutBuffer(std::cout.rdbuf());
+		CoutRedirect coutRedirect(&coutBuffer);
+		const auto progressFunc = OutputManager::getProgressFunc();
+		OutputManager::setProgressFunc([](int) {});
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < targets.size(); t++) {
+			threads.emplace_back([&, t]() {
+				coutBuffer.capture(&logs[t]);
+				results[t] = convertFile(targets[t]);
+				std::cout.flush();
+				coutBuffer.capture(nullptr);
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		OutputManager::setProgressFunc(progressFunc);
+	}
+
+	cleanUp();
+
+	bool ok = true;
+	for (size_t t = 0; t < targets.size(); t++) {
+		std::cout << "\n[" << targets[t].outputFilename << "]\n" << logs[t];
+		ok &= (results[t] == EXIT_SUCCESS);
+	}
+
+	std::cout << std::endl;
+	for (size_t t = 0; t < targets.size(); t++) {
+		std::cout << targets[t].outputFilename << ": " << (results[t] == EXIT_SUCCESS ? "ok" : "FAILED") << std::endl;
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// runBatch() : convert many files in one process (see getBatchJobs()).
+// Jobs are scheduled largest (input file) first, on a pool of worker threads (--batchJobs N, default: one per hardware thread).
+// Startup work (cpu checks, argument parsing of common options) is done once,
+// and filter coefficients designed for one job are re-used by all later jobs which need the same filters.
+// Messages from each job are collected, and shown as each job finishes.
+int runBatch(const std::vector<std::vector<std::string>>& jobArgs, int workers)
+{
+	if (jobArgs.empty()) {
+		std::cout << "Error: batch contains no jobs" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// get parameters of each job:
+	std::vector<ConversionInfo> jobs(jobArgs.size());
+	for (size_t j = 0; j < jobs.size(); j++) {
+		std::vector<char*> argv;
+		for (const auto& arg : jobArgs[j]) {
+			argv.push_back(const_cast<char*>(arg.c_str()));
+		}
+		ConversionInfo& ci = jobs[j];
+		ci.appName = argv[0];
+		ci.overSamplingFactor = 1;
+		ci.fromCmdLineArgs(static_cast<int>(argv.size()), argv.data());
+		if (ci.bBadParams || ci.bStreamInput || ci.bStreamOutput) {
+			std::cout << "Error: bad parameters in batch job " << j + 1 << ":";
+			for (size_t a = 1; a < jobArgs[j].size(); a++) {
+				std::cout << " " << jobArgs[j][a];
+			}
+			std::cout << "\n(each job requires named input and output files)" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// largest first:
+	std::vector<std::pair<uintmax_t, size_t>> order;
+	for (size_t j = 0; j < jobs.size(); j++) {
+		std::error_code ec;
+		const auto size = std::filesystem::file_size(jobs[j].inputFilename, ec);
+		order.emplace_back(ec ? 0 : size, j);
+	}
+	std::stable_sort(order.begin(), order.end(), [](const std::pair<uintmax_t, size_t>& a, const std::pair<uintmax_t, size_t>& b) {
+		return a.first > b.first;
+	});
+
+	std::unique_ptr<ThreadTokens> jobSlots;
+	if (workers <= 0) {
+		workers = std::min(ThreadBudget::instance().maxThreads(), static_cast<int>(jobs.size()));
+		if (ThreadBudget::instance().jobserverMode() != 0) { // under make -j : one worker for each job slot obtained from make
+			jobSlots.reset(new ThreadTokens(workers - 1));
+			workers = 1 + jobSlots->count();
+		}
+	}
+	workers = std::min(workers, static_cast<int>(jobs.size()));
+	std::cout << "Batch: " << jobs.size() << " jobs, " << workers << " worker thread" << (workers == 1 ? "" : "s") << std::endl;
+
+	std::vector<int> results(jobs.size(), EXIT_FAILURE);
+	{
+		ThreadCoutBuffer coutBuffer(std::cout.rdbuf());
+		CoutRedirect coutRedirect(&coutBuffer);
+		const auto progressFunc = OutputManager::getProgressFunc();
+		OutputManager::setProgressFunc([](int) {});
+		std::mutex printMutex;
+		size_t finished = 0;
+		ctpl::thread_pool threadPool(workers);
+		std::vector<std::future<void>> futures;
+		for (const auto& o : order) {
+			const size_t j = o.second;
+			futures.push_back(threadPool.push([&, j](int) {
+				std::string log;
+				coutBuffer.capture(&log);
+				ConversionInfo& ci = jobs[j];
+				std::cout << "Input file: " << ci.inputFilename << std::endl;
+				std::cout << "Output file: " << ci.outputFilename << std::endl;
+				setOutputFileFormat(ci);
+				results[j] = convertFile(ci);
+				std::cout.flush();
+				coutBuffer.capture(nullptr);
+
+				std::lock_guard<std::mutex> lock(printMutex);
+				std::cout << "\n[" << ++finished << "/" << jobs.size() << "] " << ci.outputFilename << (results[j] == EXIT_SUCCESS ? "" : " (FAILED)") << "\n" << log << std::flush;
+			}));
+		}
+		for (auto& f : futures) {
+			f.get();
+		}
+		OutputManager::setProgressFunc(progressFunc);
+	}
+
+	size_t failures = 0;
+	for (size_t j = 0; j < jobs.size(); j++) {
+		if (results[j] != EXIT_SUCCESS) {
+			if (failures++ == 0) {
+				std::cout << "\nFailed jobs:" << std::endl;
+			}
+			std::cout << jobs[j].inputFilename << " -> " << jobs[j].outputFilename << std::endl;
+		}
+	}
+	std::cout << "\nBatch complete: " << jobs.size() - failures << " ok, " << failures << " failed" << std::endl;
+	return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// getDefaultServerSocket() : path of server's socket, if not specified: $RESAMPLER_SOCKET, or resampler.sock in $XDG_RUNTIME_DIR (or /tmp)
+std::string getDefaultServerSocket()
+{
+	const char* socketPath = std::getenv("RESAMPLER_SOCKET");
+	if (socketPath != nullptr && *socketPath != '\0') {
+		return socketPath;
+	}
+	const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+	return std::string((runtimeDir != nullptr && *runtimeDir != '\0') ? runtimeDir : "/tmp") + "/resampler.sock";
+}
+
+#if !defined (_WIN32) && !defined (_WIN64)
+
+static volatile std::sig_atomic_t serverSignalled = 0;
+static constexpr int serverRequestTimeout = 10;				// (seconds allowed for a client to send its request)
+static constexpr size_t maxServerRequestLength = 1 << 20;
+
+// serveRequest() : read one request from a client, perform it, and stream all messages (including progress) back to the client.
+// The response ends with a zero byte, followed by the exit code (in decimal).
+// Clients which don't send a complete request in time (or send too much) are disconnected, so that they can't tie up a worker
+static void serveRequest(int fd, const std::string& appName, ThreadCoutBuffer& coutBuffer, std::atomic<bool>& stopRequested)
+{
+	// read request (one line):
+	timeval timeout{serverRequestTimeout, 0};
+	::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	std::string request;
+	bool dropped = false;
+	for (char c;;) {
+		const auto n = ::recv(fd, &c, 1, 0);
+		if (n == 1 && c != '\n') {
+			if (request.size() == maxServerRequestLength) {
+				dropped = true;
+				break;
+			}
+			request += c;
+		} else if (n < 0 && errno == EINTR) {
+			continue;
+		} else {
+			dropped = (n < 0); // (timed out, or error)
+			break;
+		}
+	}
+	if (dropped) {
+		::close(fd);
+		std::cout << ("request dropped (incomplete after " + std::to_string(serverRequestTimeout) + " s, or too long)\n") << std::flush;
+		return;
+	}
+
+	bool connected = true;
+	auto send = [fd, &connected](const char* s, std::streamsize n) {
+		while (connected && n > 0) {
+			const auto sent = ::send(fd, s, static_cast<size_t>(n), 0);
+			if (sent <= 0) {
+				connected = false; // (client has gone: discard remaining messages)
+				break;
+			}
+			s += sent;
+			n -= sent;
+		}
+	};
+
+	coutBuffer.capture(send);
+	int result = EXIT_FAILURE;
+	std::vector<std::string> args;
+	std::string cwd;
+	if (!getRequestArgs(request, args, cwd)) {
+		std::cout << "Error: couldn't parse request" << std::endl;
+	} else {
+		// relative filenames are relative to the client's working directory:
+		if (!cwd.empty()) {
+			for (size_t a = 0; a + 1 < args.size(); a++) {
+				const std::string option = sanitize(args[a]);
+				if ((option == "-i" || option == "-o") && args[a + 1] != "-" && std::filesystem::path(args[a + 1]).is_relative()) {
+					args[a + 1] = (std::filesystem::path(cwd) / args[a + 1]).string();
+				}
+			}
+		}
+
+		args.insert(args.begin(), appName);
+		std::vector<char*> argv;
+		for (const auto& arg : args) {
+			argv.push_back(const_cast<char*>(arg.c_str()));
+		}
+		const int argc = static_cast<int>(argv.size());
+
+		if (getCmdlineParam(argv.data(), argv.data() + argc, "--stopServer")) {
+			std::cout << "server stopping" << std::endl;
+			stopRequested = true;
+			result = EXIT_SUCCESS;
+		} else if (parseGlobalOptions(argc, argv.data())) {
+			result = EXIT_SUCCESS;
+		} else if (getCmdlineParam(argv.data(), argv.data() + argc, "--batch") || !getOutputTargets(argc, argv.data()).empty()) {
+			std::cout << "Error: --batch and multiple output targets aren't available via the server (send each conversion as a separate request)" << std::endl;
+		} else {
+			ConversionInfo ci;
+			ci.appName = appName;
+			ci.overSamplingFactor = 1;
+			ci.fromCmdLineArgs(argc, argv.data());
+			if (ci.bBadParams) {
+				std::cout << strUsage << std::endl;
+			} else if (ci.bStreamInput || ci.bStreamOutput) {
+				std::cout << "Error: the server requires named input and output files (not stdin / stdout)" << std::endl;
+			} else {
+				std::cout << "Input file: " << ci.inputFilename << std::endl;
+				std::cout << "Output file: " << ci.outputFilename << std::endl;
+				if (ci.disableClippingProtection) {
+					std::cout << "clipping protection disabled " << std::endl;
+				}
+				setOutputFileFormat(ci);
+				result = convertFile(ci);
+			}
+		}
+	}
+	std::cout.flush();
+	coutBuffer.capture(nullptr);
+
+	const std::string trailer = std::string(1, '\0') + std::to_string(result);
+	send(trailer.data(), static_cast<std::streamsize>(trailer.size()));
+	::close(fd);
+
+	std::cout << ("request: " + request + (result == EXIT_SUCCESS ? " : ok\n" : " : FAILED\n")) << std::flush;
+}
+
+// runServer() : listen for conversion requests on a unix domain socket, and perform them on a pool of worker threads (see serveRequest()).
+// Startup work (cpu checks etc) is done once, and designed filters remain available to subsequent requests.
+// Runs until SIGINT / SIGTERM, or a request containing --stopServer
+int runServer(const std::string& appName, const std::string& socketPath, int workers)
+{
+	sockaddr_un address{};
+	if (socketPath.size() >= sizeof(address.sun_path)) {
+		std::cout << "Error: socket path too long: " << socketPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+	const int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFd < 0) {
+		std::cout << "Error: couldn't create socket" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// remove stale socket (unless another server is using it):
+	if (::connect(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+		std::cout << "Error: a server is already listening on " << socketPath << std::endl;
+		::close(listenFd);
+		return EXIT_FAILURE;
+	}
+	::close(listenFd);
+	::unlink(socketPath.c_str());
+
+	const int serverFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	const mode_t oldMask = ::umask(077); // (only this user may connect)
+	const bool bound = (serverFd >= 0) && ::bind(serverFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+	::umask(oldMask);
+	if (!bound || ::listen(serverFd, 64) != 0) {
+		std::cout << "Error: couldn't listen on " << socketPath << std::endl;
+		if (serverFd >= 0) {
+			::close(serverFd);
+		}
+		return EXIT_FAILURE;
+	}
+
+	if (workers <= 0) {
+		workers = ThreadBudget::instance().maxThreads();
+	}
+
+	std::signal(SIGPIPE, SIG_IGN);
+	std::signal(SIGINT, [](int) { serverSignalled = 1; });
+	std::signal(SIGTERM, [](int) { serverSignalled = 1; });
+
+	std::cout << "Server listening on " << socketPath << " (" << workers << " worker thread" << (workers == 1 ? "" : "s") << ")" << std::endl;
+
+	std::atomic<bool> stopRequested{false};
+	{
+		ThreadCoutBuffer coutBuffer(std::cout.rdbuf());
+		CoutRedirect coutRedirect(&coutBuffer);
+		ctpl::thread_pool threadPool(workers);
+		while (!stopRequested && !serverSignalled) {
+			pollfd p{serverFd, POLLIN, 0};
+			if (::poll(&p, 1, 250) <= 0) {
+				continue;
+			}
+			const int fd = ::accept(serverFd, nullptr, nullptr);
+			if (fd >= 0) {
+				threadPool.push([fd, &appName, &coutBuffer, &stopRequested](int) {
+					serveRequest(fd, appName, coutBuffer, stopRequested);
+				});
+			}
+		}
+		std::cout << "Server stopping (waiting for requests in progress) ..." << std::endl;
+		::close(serverFd);
+		::unlink(socketPath.c_str());
+		threadPool.stop(true);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+#else
+
+int runServer(const std::string& appName, const std::string& socketPath, int workers)
+{
+	(void)appName;
+	(void)socketPath;
+	(void)workers;
+	std::cout << "Error: server mode is not available on this platform" << std::endl;
+	return EXIT_FAILURE;
+}
+
+#endif
+
+int runCommand(int argc, char** argv)
+{
+	// test for global options
+	if (parseGlobalOptions(argc, argv)) {
+		return EXIT_SUCCESS;
+	}
+
+	// server (--server [socket path]) :
+	if (getCmdlineParam(argv, argv + argc, "--server")) {
+		if (!showBuildVersion()) {
+			return EXIT_FAILURE;
+		}
+		std::string socketPath;
+		getCmdlineParam(argv, argv + argc, "--server", socketPath);
+		if (socketPath.empty() || socketPath[0] == '-') {
+			socketPath = getDefaultServerSocket();
+		}
+		std::string workers;
+		getCmdlineParam(argv, argv + argc, "--serverJobs", workers);
+		return runServer(argv[0], socketPath, std::atoi(workers.c_str()));
+	}
+
+	// batch (--batch manifest | --batch "pattern" -o outdir) :
+	if (getCmdlineParam(argv, argv + argc, "--batch")) {
+		if (!showBuildVersion()) {
+			return EXIT_FAILURE;
+		}
+		std::string workers;
+		getCmdlineParam(argv, argv + argc, "--batchJobs", workers);
+		return runBatch(getBatchJobs(argc, argv), std::atoi(workers.c_str()));
+	}
+
+	// merge shards (--merge shard1 shard2 ... -o output) :
+	if (getCmdlineParam(argv, argv + argc, "--merge")) {
+		if (!showBuildVersion()) {
+			return EXIT_FAILURE;
+		}
+		std::string outputFilename;
+		getCmdlineParam(argv, argv + argc, "-o", outputFilename);
+		return mergeShards(getMergeInputs(argc, argv), outputFilename,
+						   getCmdlineParam(argv, argv + argc, "--noPeakChunk"), !getCmdlineParam(argv, argv + argc, "--noMetadata"));
+	}
+
+	// several output targets (-o ... -o ...) :
+	const auto targetArgs = getOutputTargets(argc, argv);
+	if (!targetArgs.empty()) {
+		if (!showBuildVersion()) {
+			return EXIT_FAILURE;
+		}
+		return runFanOut(targetArgs);
+	}
+
+	// when streaming to stdout, send all messages to stderr:
+	std::string outputFilename;
+	const bool toStdout = getCmdlineParam(argv, argv + argc, "-o", outputFilename) && outputFilename == "-";
+	CoutRedirect coutRedirect(toStdout ? std::cerr.rdbuf() : std::cout.rdbuf());
+
+	// ConversionInfo instance to hold parameters
+	ConversionInfo ci;
+
+	// get path/name of this app
+#ifdef __APPLE__
+	char pathBuf[PROC_PIDPATHINFO_MAXSIZE];
+	pid_t pid = getpid();
+	if (proc_pidpath(pid, pathBuf, sizeof(pathBuf)) == 0) {
+		ci.appName.assign(pathBuf);
+	}
+#else
+	ci.appName = argv[0];
+#endif
+
+	ci.overSamplingFactor = 1;
+
+	// get conversion parameters
+	ci.fromCmdLineArgs(argc, argv);
+	if (ci.bBadParams) {
+		std::cout << strUsage << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// query build version AND cpu
+	if (!showBuildVersion()) {
+		return EXIT_FAILURE; // can't continue (CPU / build mismatch)
+	}
+
+	// echo filenames to user
+	std::cout << "Input file: " << (ci.bStreamInput ? "(stdin)" : ci.inputFilename) << std::endl;
+	std::cout << "Output file: " << (ci.bStreamOutput ? "(stdout)" : ci.outputFilename) << std::endl;
+
+	if (ci.disableClippingProtection) {
+		std::cout << "clipping protection disabled " << std::endl;
+	}
+
+	setOutputFileFormat(ci);
+	return convertFile(ci);
+}
+
 std::function<void(int)> OutputManager::progressFunc = [](int percentComplete) {
 	std::cout << percentComplete << "%"
 			 #ifndef COMPILING_ON_ANDROID
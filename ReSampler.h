@@ -34,6 +34,8 @@
 #include <iostream>
 #include <map>
 #include <functional>
+#include <mutex>
+#include <thread>
 
 namespace ReSampler {
 
@@ -54,18 +56,29 @@ const std::string strExtraOptions(
 		"--flacCompression <compressionlevel>\n"
 		"--vorbisQuality <quality>\n"
 		"--noClippingProtection\n"
+		"--earlyAbort\n"
+		"--limiter [<lookahead ms>] [--limiter-release <ms>] [--truePeak]\n"
 		"--relaxedLPF\n"
 		"--steepLPF\n"
 		"--lpf-cutoff <percentage> [--lpf-transition <percentage>]\n"
 		"--mt\n"
+		"--pinThreads\n"
+		"--showPlacement\n"
 		"--rf64\n"
 		"--noPeakChunk\n"
+		"--ignorePeakChunk\n"
+		"--noMmap\n"
+		"--nativeWriter\n"
 		"--noMetadata\n"
 		"--singleStage\n"
 		"--multiStage\n"
 		"--maxStages\n"
 		"--showStages\n"
+		"--blockSize <frames|auto>\n"
+		"--maxFilterLength <taps>\n"
+		"--asrc [<drift ppm>]\n"
 		"--rawInput <samplerate> <bitformat> [numChannels]\n"
+		"--raw-output\n"
 		"--progress-updates <0..100>\n"
 
 		#if defined (_WIN32) || defined (_WIN64)
@@ -74,14 +87,22 @@ const std::string strExtraOptions(
 
 		"--showTempFile\n"
 		"--noTempFile\n"
+		"--spill [<max RAM in MB>]\n"
         "--demodulateIQ [<AM|LSB|USB|NFM|WFM>]\n"
         "--stereoWidth <amount>\n"
 		"--fade-in <time in seconds>\n"
 		"--fade-out <time in seconds>\n"
+		"--batch <manifest|\"pattern\"> [--batchJobs <n>]\n"
+		"--server [<socket path>] [--serverJobs <n>]\n"
+		"--cache <dir> [--cacheLink]\n"
+		"--incremental\n"
+		"--shard <k/N>\n"
+		"--merge <shard files> -o <outputfile>\n"
 		);
 
-static constexpr size_t BUFFERSIZE = 32768; // buffer size for file reads
+static constexpr size_t BUFFERSIZE = 32768; // default block size (number of frames processed at a time) - see --blockSize
 static constexpr double clippingTrim = 1.0 - (1.0 / (1 << 23));
+static constexpr double earlyAbortHeadroom = 1.0 + 1.0e-5; // (--earlyAbort: margin added to the output peak predicted by an aborted pass)
 static constexpr int maxClippingProtectionAttempts = 3;
 
 // map of commandline subformats to libsndfile subformats:
@@ -181,7 +202,84 @@ public:
 	static void callProgressFunc(int percentComplete);
 };
 
+// CoutRedirect : redirects std::cout to another stream buffer, for the lifetime of the CoutRedirect object
+class CoutRedirect {
+public:
+	explicit CoutRedirect(std::streambuf* target) : original(std::cout.rdbuf(target)) {}
+	~CoutRedirect() { std::cout.rdbuf(original); }
+	CoutRedirect(const CoutRedirect&) = delete;
+	CoutRedirect& operator=(const CoutRedirect&) = delete;
+
+private:
+	std::streambuf* original;
+};
+
+// ThreadCoutBuffer : stream buffer which collects the output of each capturing thread separately (see capture()),
+// and passes the output of all other threads through to another stream buffer. (used to keep messages from concurrent conversions apart)
+class ThreadCoutBuffer : public std::streambuf {
+public:
+	using Sink = std::function<void(const char*, std::streamsize)>;
+
+	explicit ThreadCoutBuffer(std::streambuf* passThrough) : passThrough(passThrough) {}
+
+	// capture() : append the calling thread's output to log (nullptr: stop capturing)
+	void capture(std::string* log)
+	{
+		if (log == nullptr) {
+			capture(Sink());
+		} else {
+			capture([log](const char* s, std::streamsize n) { log->append(s, static_cast<size_t>(n)); });
+		}
+	}
+
+	// capture() : send the calling thread's output to sink, as it is written (empty: stop capturing)
+	void capture(Sink sink)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!sink) {
+			sinks.erase(std::this_thread::get_id());
+		} else {
+			sinks[std::this_thread::get_id()] = std::move(sink);
+		}
+	}
+
+protected:
+	int overflow(int c) override
+	{
+		if (traits_type::eq_int_type(c, traits_type::eof())) {
+			return traits_type::not_eof(c);
+		}
+		const char ch = traits_type::to_char_type(c);
+		return (xsputn(&ch, 1) == 1) ? c : traits_type::eof();
+	}
+
+	std::streamsize xsputn(const char* s, std::streamsize n) override
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		auto it = sinks.find(std::this_thread::get_id());
+		if (it == sinks.end()) {
+			return passThrough->sputn(s, n);
+		}
+		Sink sink = it->second; // (only the calling thread can change its own sink)
+		lock.unlock();
+		sink(s, n);
+		return n;
+	}
+
+	int sync() override
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return passThrough->pubsync();
+	}
+
+private:
+	std::streambuf* passThrough;
+	std::mutex mutex;
+	std::map<std::thread::id, Sink> sinks;
+};
+
 bool getMajorFormatFromFileExt(SF_FORMAT_INFO *info, const std::string& ext);
+size_t getL2CacheSize();
 bool checkSSE2();
 bool checkAVX();
 bool showBuildVersion();
@@ -198,14 +296,18 @@ bool convert_SndfileHandle_Float(ConversionInfo & ci);
 bool convert_SndfileHandle_Double(ConversionInfo & ci);
 bool convert_IQFile_Float(ConversionInfo & ci);
 bool convert_IQFile_Double(ConversionInfo & ci);
+bool convert_MappedPcm_Float(ConversionInfo & ci);
+bool convert_MappedPcm_Double(ConversionInfo & ci);
 template<typename FileReader, typename FloatType> bool convert(ConversionInfo & ci);
 template<typename FloatType>
 SndfileHandle* getTempFile(int inputFileFormat, int nChannels, const ConversionInfo& ci, std::string& tmpFilename);
 void showDitherProfiles();
 int getSfBytesPerSample(int format);
+int getIntegerPcmBits(int format);
 bool checkWarnOutputSize(sf_count_t inputSamples, int bytesPerSample, int numerator, int denominator);
 template<typename IntType> std::string fmtNumberWithCommas(IntType n);
 void printSamplePosAsTime(sf_count_t samplePos, unsigned int sampleRate);
+std::string fixedToString(double value, int decimals = 6);
 
 void generateExpSweep(const std::string & filename,
 					  int sampleRate = 96000, // samplerate of generated file
@@ -216,8 +318,17 @@ void generateExpSweep(const std::string & filename,
 		);
 
 bool getMetaData(MetaData& metadata, SndfileHandle &infile);
+bool getPeakChunkValue(SndfileHandle& infile, double& peak);
 bool setMetaData(const MetaData& metadata, SndfileHandle& outfile);
 void showCompiler();
+void setOutputFileFormat(ConversionInfo& ci);
+int convertFile(ConversionInfo& ci);
+int convertFileUncached(ConversionInfo& ci);
+int runFanOut(const std::vector<std::vector<std::string>>& targetArgs);
+int runBatch(const std::vector<std::vector<std::string>>& jobArgs, int workers);
+std::string getDefaultServerSocket();
+int runServer(const std::string& appName, const std::string& socketPath, int workers);
+int mergeShards(const std::vector<std::string>& shardFilenames, const std::string& outputFilename, bool noPeakChunk, bool writeMetaData);
 int runCommand(int argc, char** argv);
 
 template <typename InputIterator>
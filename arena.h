@@ -0,0 +1,160 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// arena.h : bump allocator for the buffers of one conversion
+
+// Arena is a std::pmr::memory_resource which hands out consecutive (aligned) pieces of one block of memory, allocated up front.
+// Deallocation does nothing (the block is freed with the arena), except that rewind() makes the space after a mark() available again.
+// Allocations which don't fit in the block are passed on to the upstream resource (and returned to it on deallocation),
+// while used() keeps counting as if the block had been big enough: so an Arena with zero capacity measures how big a block
+// a given sequence of allocations needs.
+
+#ifndef ARENA_H
+#define ARENA_H 1
+
+#include "alignedmalloc.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace ReSampler {
+
+class Arena : public std::pmr::memory_resource
+{
+public:
+	static constexpr size_t blockAlignment = 4096; // (largest alignment served from the block)
+
+	explicit Arena(size_t capacity, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+		: upstream(upstream)
+	{
+		if (capacity > 0) {
+			block = static_cast<char*>(aligned_malloc_huge(capacity, blockAlignment));
+			blockCapacity = (block == nullptr) ? 0 : capacity;
+		}
+	}
+
+	~Arena() override
+	{
+		aligned_free(block);
+	}
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// used() : bytes of block taken so far (including alignment padding, and allocations which didn't fit)
+	size_t used() const
+	{
+		return top;
+	}
+
+	size_t capacity() const
+	{
+		return blockCapacity;
+	}
+
+	// overflowCount() : number of allocations passed on to upstream resource
+	size_t overflowCount() const
+	{
+		return overflows;
+	}
+
+	// alignTo() : start next allocation on a multiple of alignment (eg page boundary). Returns offset of next allocation
+	size_t alignTo(size_t alignment)
+	{
+		top = alignUp(top, alignment);
+		return top;
+	}
+
+	// region() : the part of block from offset first to offset end (clipped to capacity)
+	std::pair<void*, size_t> region(size_t first, size_t end) const
+	{
+		first = std::min(first, blockCapacity);
+		end = std::min(end, blockCapacity);
+		return {block + first, end > first ? end - first : 0};
+	}
+
+	size_t mark() const
+	{
+		return top;
+	}
+
+	// rewind() : make space allocated since mark m available again (everything allocated since then must no longer be in use)
+	void rewind(size_t m)
+	{
+		top = m;
+	}
+
+private:
+	std::pmr::memory_resource* upstream;
+	char* block{nullptr};
+	size_t blockCapacity{0};
+	size_t top{0};
+	size_t overflows{0};
+
+	static size_t alignUp(size_t offset, size_t alignment)
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	bool owns(const void* p) const
+	{
+		return block != nullptr && static_cast<const char*>(p) >= block && static_cast<const char*>(p) < block + blockCapacity;
+	}
+
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		const size_t first = alignUp(top, alignment);
+		top = first + bytes;
+		if (alignment <= blockAlignment && top <= blockCapacity) {
+			return block + first;
+		}
+		overflows++;
+		return upstream->allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override
+	{
+		if (!owns(p)) {
+			upstream->deallocate(p, bytes, alignment);
+		}
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+};
+
+// ArenaScope : rewinds arena on destruction to where it was on construction (for allocations which only last for a scope)
+class ArenaScope
+{
+public:
+	explicit ArenaScope(Arena& arena) : arena(arena), m(arena.mark())
+	{}
+
+	~ArenaScope()
+	{
+		arena.rewind(m);
+	}
+
+	ArenaScope(const ArenaScope&) = delete;
+	ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+	Arena& arena;
+	size_t m;
+};
+
+} // namespace ReSampler
+
+#endif // ARENA_H
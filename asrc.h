@@ -0,0 +1,260 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// asrc.h : asynchronous sample rate conversion (ASRC) - conversion at a continuously variable ratio,
+// for sources whose clock drifts relative to the destination's clock.
+
+// AsrcEngine : converts one channel at a ratio which may be adjusted at any time (by a ratio correction, close to 1.0).
+// Interpolation uses a polyphase windowed-sinc filter bank, with linear interpolation between adjacent phases,
+// so the cost is the same for every output sample (2 x filterLength multiply/accumulates), regardless of ratio.
+// Changes in ratio are smoothed (one-pole), so that the output doesn't contain steps in frequency.
+
+// DriftTracker : estimates the ratio correction, either from the fill level of a buffer between the two clock domains,
+// or from timestamps (frame counts vs time, on each side).
+
+#ifndef ASRC_H
+#define ASRC_H 1
+
+#include "FIRFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace ReSampler {
+
+template<typename FloatType>
+class AsrcEngine
+{
+public:
+	static constexpr int numPhases = 256; // number of filter phases in polyphase bank
+	static constexpr double maxDeviation = 0.01; // ratio correction is limited to +/- 1% (10000 ppm)
+
+	// lpfCutoff and lpfTransitionWidth are percentages of the nyquist frequency of the lower of the two sample rates.
+	// maxFilterLength (if non-zero) limits the number of taps in each phase
+	AsrcEngine(int inputSampleRate, int outputSampleRate, double lpfCutoff = 100.0 * (10.0 / 11.0), double lpfTransitionWidth = 100.0 - 100.0 * (10.0 / 11.0), int maxFilterLength = 0)
+		: outputSampleRate(outputSampleRate),
+		  nominalStep(static_cast<double>(inputSampleRate) / outputSampleRate)
+	{
+		// bandwidth (in cycles per input sample):
+		const double scale = 0.5 * std::min(1.0, 1.0 / nominalStep);
+		const double ft = scale * lpfCutoff / 100.0;
+		const double tw = scale * lpfTransitionWidth / 100.0;
+
+		// kaiser estimate of length for 160dB attenuation:
+		const double attenuation = 160.0;
+		length = static_cast<int>(std::ceil((attenuation - 8.0) / (2.285 * 2.0 * M_PI * tw)));
+		if (maxFilterLength > 0) {
+			length = std::min(length, maxFilterLength);
+		}
+		length = std::max(8, length + (length & 1)); // (even)
+
+		// prototype filter: numPhases x oversampled, centred on (length / 2)
+		const int prototypeLength = length * numPhases + 1;
+		std::vector<double> prototype(prototypeLength, 0.0);
+		makeLPF<double>(prototype.data(), prototypeLength, ft, 1.0 * numPhases);
+		applyKaiserWindow<double>(prototype.data(), prototypeLength, calcKaiserBeta(attenuation));
+
+		// polyphase table: row p holds the coefficients for fractional position p / numPhases,
+		// ordered to match the history (oldest sample first). Row numPhases is the end-point for interpolation
+		table.resize(static_cast<size_t>(numPhases + 1) * length);
+		for (int p = 0; p <= numPhases; p++) {
+			for (int k = 0; k < length; k++) {
+				table[static_cast<size_t>(p) * length + k] = static_cast<FloatType>(numPhases * prototype[static_cast<size_t>(length - 1 - k) * numPhases + p]);
+			}
+		}
+
+		history.resize(2 * static_cast<size_t>(length));
+		targetStep = nominalStep;
+		setSmoothingTime(0.1);
+		reset();
+	}
+
+	// setRatioCorrection() : set correction to conversion ratio (takes effect gradually - see setSmoothingTime()).
+	// correction is the ratio of actual to nominal input sample rate (relative to output clock): eg 1.00005 for input running 50ppm fast
+	void setRatioCorrection(double correction)
+	{
+		correction = std::max(1.0 - maxDeviation, std::min(correction, 1.0 + maxDeviation));
+		targetStep = nominalStep * correction;
+	}
+
+	// setSmoothingTime() : time constant (in seconds) with which ratio changes take effect
+	void setSmoothingTime(double seconds)
+	{
+		smoothing = (seconds > 0.0) ? 1.0 - std::exp(-1.0 / (seconds * outputSampleRate)) : 1.0;
+	}
+
+	// getRatio() : current (effective) conversion ratio (output rate / input rate)
+	double getRatio() const
+	{
+		return 1.0 / step;
+	}
+
+	// convert() : convert inBufferSize input samples, placing the result in outBuffer (which must have room for getMaxOutputSize(inBufferSize) samples)
+	void convert(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize)
+	{
+		size_t i = 0;
+		size_t o = 0;
+		for (;;) {
+			while (frac >= 1.0) {
+				if (i == inBufferSize) {
+					outBufferSize = o;
+					return;
+				}
+				push(inBuffer[i++]);
+				frac -= 1.0;
+			}
+
+			const double phase = frac * numPhases;
+			const int p = static_cast<int>(phase);
+			const FloatType a = static_cast<FloatType>(phase - p);
+			const FloatType* c0 = table.data() + static_cast<size_t>(p) * length;
+			const FloatType* c1 = c0 + length;
+			const FloatType* x = history.data() + index;
+			FloatType y0 = 0.0;
+			FloatType y1 = 0.0;
+			for (int k = 0; k < length; k++) {
+				y0 += c0[k] * x[k];
+				y1 += c1[k] * x[k];
+			}
+			outBuffer[o++] = y0 + a * (y1 - y0);
+
+			step += (targetStep - step) * smoothing;
+			frac += step;
+		}
+	}
+
+	// getMaxOutputSize() : largest number of output samples that convert() can produce from inputSize input samples
+	size_t getMaxOutputSize(size_t inputSize) const
+	{
+		const double minStep = nominalStep * (1.0 - maxDeviation);
+		return static_cast<size_t>(std::ceil((inputSize + 1) / minStep)) + 1;
+	}
+
+	// getLatency() : delay (in output samples) between input and output.
+	// (The initial position is chosen to make this a whole number of samples, so that trimming it aligns output with input exactly)
+	double getLatency() const
+	{
+		return latency;
+	}
+
+	int getFilterLength() const
+	{
+		return length;
+	}
+
+	void reset()
+	{
+		std::fill(history.begin(), history.end(), 0.0);
+		index = 0;
+		step = targetStep; // (ratio correction is retained)
+
+		// first output is at (length / 2) input samples before first input, plus an offset which makes the latency whole:
+		const double delay = length / 2;
+		latency = std::floor(delay / step);
+		frac = 1.0 + delay - latency * step;
+	}
+
+private:
+	int outputSampleRate;
+	double nominalStep; // input samples per output sample, at nominal rates
+	int length; // taps per phase
+	std::vector<FloatType> table; // (numPhases + 1) x length coefficients
+	std::vector<FloatType> history; // last (length) input samples, stored twice, so that they can always be read contiguously
+	size_t index{0}; // position of oldest sample in history
+	double frac{1.0}; // position of next output, relative to newest input sample (>= 1.0: more input needed)
+	double step{1.0}; // current (smoothed) input samples per output sample
+	double targetStep{1.0};
+	double smoothing{1.0};
+	double latency{0.0}; // (output samples)
+
+	void push(FloatType sample)
+	{
+		history[index] = sample;
+		history[index + length] = sample;
+		if (++index == static_cast<size_t>(length)) {
+			index = 0;
+		}
+	}
+};
+
+// DriftTracker : produces a ratio correction for AsrcEngine::setRatioCorrection()
+class DriftTracker
+{
+public:
+	// targetFill : desired fill level of the buffer between the clock domains (in frames)
+	// responseTime : (seconds) how quickly the loop responds to a fill-level error
+	explicit DriftTracker(double targetFill = 0.0, double responseTime = 10.0)
+		: targetFill(targetFill), responseTime(responseTime), smoothedFill(targetFill)
+	{
+	}
+
+	// updateFromFillLevel() : feed the current fill level of the buffer (in frames at sampleRate), once per update period (in seconds).
+	// A rising buffer means the input is running fast (relative to output), so the correction increases.
+	// The fill level is low-pass filtered first (it jumps by a whole block each time a block is written or read).
+	// (proportional-integral loop: the integral term tracks the steady drift, the proportional term corrects the fill level)
+	double updateFromFillLevel(double fillLevel, double period, double sampleRate)
+	{
+		smoothedFill += (fillLevel - smoothedFill) * (1.0 - std::exp(-4.0 * period / responseTime));
+		const double error = (smoothedFill - targetFill) / sampleRate; // (seconds)
+		const double kp = 1.0 / responseTime;
+		const double ki = kp * kp / 4.0; // (critically damped)
+		integral = std::max(-AsrcEngine<double>::maxDeviation, std::min(integral + ki * error * period, AsrcEngine<double>::maxDeviation));
+		correction = 1.0 + integral + kp * error;
+		return correction;
+	}
+
+	// updateFromTimestamps() : feed total frames received on input and consumed on output, with their timestamps (seconds, any common clock).
+	// The correction is the ratio of measured rates, low-pass filtered between updates
+	double updateFromTimestamps(double inputFrames, double inputTime, double outputFrames, double outputTime, double nominalInputRate, double nominalOutputRate)
+	{
+		if (havePrevious && inputTime > prevInputTime && outputTime > prevOutputTime) {
+			const double inputRate = (inputFrames - prevInputFrames) / (inputTime - prevInputTime);
+			const double outputRate = (outputFrames - prevOutputFrames) / (outputTime - prevOutputTime);
+			if (inputRate > 0.0 && outputRate > 0.0) {
+				const double measured = (inputRate / nominalInputRate) / (outputRate / nominalOutputRate);
+				const double alpha = std::min(1.0, (outputTime - prevOutputTime) / responseTime);
+				correction += (measured - correction) * alpha;
+			}
+		}
+		prevInputFrames = inputFrames;
+		prevInputTime = inputTime;
+		prevOutputFrames = outputFrames;
+		prevOutputTime = outputTime;
+		havePrevious = true;
+		return correction;
+	}
+
+	double getCorrection() const
+	{
+		return correction;
+	}
+
+	// getDriftPpm() : current correction, expressed in parts per million
+	double getDriftPpm() const
+	{
+		return (correction - 1.0) * 1e6;
+	}
+
+private:
+	double targetFill;
+	double responseTime;
+	double smoothedFill;
+	double correction{1.0};
+	double integral{0.0};
+	bool havePrevious{false};
+	double prevInputFrames{0.0};
+	double prevInputTime{0.0};
+	double prevOutputFrames{0.0};
+	double prevOutputTime{0.0};
+};
+
+} // namespace ReSampler
+
+#endif // ASRC_H
@@ -2,8 +2,11 @@
 #include "ditherer.h"
 
 #include <iostream>
+#include <fstream>
+#include <filesystem>
 #include <vector>
 #include <algorithm>
+#include <cctype>
 #include <stdexcept>
 
 namespace ReSampler {
@@ -99,6 +102,378 @@ bool getCmdlineParam(char** begin, char** end, const std::string& option)
 	return found;
 }
 
+// getOutputTargets() : split args for a multi-target (fan-out) conversion into a separate set of args for each target.
+// Each -o begins a new target. -r and -b apply to the target whose -o precedes them,
+// or (if they come before the first -o) to all targets which don't specify their own. All other args are common to all targets.
+// Returns an empty vector if there are fewer than two targets.
+std::vector<std::vector<std::string>> getOutputTargets(int argc, char** argv)
+{
+	std::vector<std::string> common;
+	std::vector<std::string> defaults; // -r / -b before first -o
+	std::vector<std::vector<std::string>> targets;
+
+	for (int i = 1; i < argc; i++) {
+		const std::string option = sanitize(argv[i]);
+		const bool hasValue = (i + 1 < argc);
+		if (option == "-o" && hasValue) {
+			targets.push_back({argv[i], argv[i + 1]});
+			i++;
+		} else if ((option == "-r" || option == "-b") && hasValue) {
+			auto& dest = targets.empty() ? defaults : targets.back();
+			dest.emplace_back(argv[i]);
+			dest.emplace_back(argv[++i]);
+		} else {
+			common.emplace_back(argv[i]);
+		}
+	}
+
+	if (targets.size() < 2) {
+		return {};
+	}
+
+	for (auto& target : targets) { // (getCmdlineParam() takes the first occurrence, so target's own -r / -b precede the defaults)
+		target.insert(target.end(), defaults.begin(), defaults.end());
+		target.insert(target.end(), common.begin(), common.end());
+		target.insert(target.begin(), argv[0]);
+	}
+	return targets;
+}
+
+// splitManifestLine() : split a line of a batch manifest (or server request) into tokens, separated by whitespace.
+// Tokens may be enclosed in double quotes (to allow spaces in filenames)
+static std::vector<std::string> splitManifestLine(const std::string& line)
+{
+	std::vector<std::string> tokens;
+	std::string token;
+	bool inToken = false;
+	bool inQuotes = false;
+	for (char c : line) {
+		if (c == '"') {
+			inQuotes = !inQuotes;
+			inToken = true;
+		} else if (!inQuotes && std::isspace(static_cast<unsigned char>(c))) {
+			if (inToken) {
+				tokens.push_back(token);
+				token.clear();
+				inToken = false;
+			}
+		} else {
+			token += c;
+			inToken = true;
+		}
+	}
+	if (inToken) {
+		tokens.push_back(token);
+	}
+	return tokens;
+}
+
+// wildcardMatch() : match name against a pattern containing '*' (any sequence) and '?' (any character)
+static bool wildcardMatch(const char* pattern, const char* name)
+{
+	for (; *pattern != '\0'; pattern++, name++) {
+		if (*pattern == '*') {
+			for (;; name++) {
+				if (wildcardMatch(pattern + 1, name)) {
+					return true;
+				}
+				if (*name == '\0') {
+					return false;
+				}
+			}
+		}
+		if (*name == '\0' || (*pattern != '?' && *pattern != *name)) {
+			return false;
+		}
+	}
+	return *name == '\0';
+}
+
+// getBatchJobs() : get a separate set of args for each job of a batch (--batch), from either:
+// a) a manifest file (or "-" for stdin), in which each line is either "infile outfile [options]", or a complete set of options ("-i infile -o outfile [options]")
+// b) a wildcard pattern for input files (eg "inputs/*.wav"), in which case -o names either an output directory,
+//    or an output pattern, in which '*' is replaced by the name of each input file (without extension) eg "outputs/*.flac"
+// Blank lines and lines beginning with '#' in manifests are ignored.
+// All other args on the command line are common to all jobs (job's own options take precedence).
+std::vector<std::vector<std::string>> getBatchJobs(int argc, char** argv)
+{
+	std::string source;
+	std::string outputSpec;
+	std::vector<std::string> common;
+	for (int i = 1; i < argc; i++) {
+		const std::string option = sanitize(argv[i]);
+		if (option == "--batch" && i + 1 < argc) {
+			source = argv[++i];
+		} else if (option == "-o" && i + 1 < argc) {
+			outputSpec = argv[++i];
+		} else {
+			common.emplace_back(argv[i]);
+		}
+	}
+
+	std::vector<std::vector<std::string>> jobs;
+	auto addJob = [&](std::vector<std::string> args) {
+		args.insert(args.begin(), argv[0]);
+		args.insert(args.end(), common.begin(), common.end());
+		jobs.push_back(std::move(args));
+	};
+
+	if (source.find_first_of("*?") != std::string::npos) {
+		// wildcard pattern:
+		namespace fs = std::filesystem;
+		const fs::path pattern(source);
+		const fs::path dir = pattern.has_parent_path() ? pattern.parent_path() : fs::path(".");
+		const std::string namePattern = pattern.filename().string();
+		std::vector<fs::path> inputs;
+		std::error_code ec;
+		for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+			if (it->is_regular_file(ec) && wildcardMatch(namePattern.c_str(), it->path().filename().string().c_str())) {
+				inputs.push_back(it->path());
+			}
+		}
+		std::sort(inputs.begin(), inputs.end());
+
+		if (outputSpec.empty()) {
+			std::cout << "Error: --batch with a wildcard pattern requires an output directory or pattern (-o)" << std::endl;
+			return {};
+		}
+		const auto star = outputSpec.find('*');
+		if (star == std::string::npos) {
+			fs::create_directories(outputSpec, ec);
+		}
+		for (const auto& input : inputs) {
+			std::string output = (star == std::string::npos) ?
+				(fs::path(outputSpec) / input.filename()).string() :
+				outputSpec.substr(0, star) + input.stem().string() + outputSpec.substr(star + 1);
+			addJob({"-i", input.string(), "-o", output});
+		}
+	} else {
+		// manifest:
+		std::ifstream file;
+		if (source != "-") {
+			file.open(source);
+			if (!file.is_open()) {
+				std::cout << "Error: couldn't open batch manifest " << source << std::endl;
+				return {};
+			}
+		}
+		std::istream& manifest = (source == "-") ? std::cin : file;
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(manifest, line)) {
+			lineNumber++;
+			auto tokens = splitManifestLine(line);
+			if (tokens.empty() || tokens[0][0] == '#') {
+				continue;
+			}
+			if (tokens[0][0] != '-') {
+				if (tokens.size() < 2) {
+					std::cout << "Error: " << source << " line " << lineNumber << ": expected input and output filenames" << std::endl;
+					return {};
+				}
+				tokens.insert(tokens.begin() + 1, "-o");
+				tokens.insert(tokens.begin(), "-i");
+			}
+			addJob(std::move(tokens));
+		}
+	}
+
+	return jobs;
+}
+
+// JSON parsing helpers for getRequestArgs() (just enough JSON for strings, and arrays of strings):
+
+static void skipJsonSpace(const std::string& s, size_t& pos)
+{
+	while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos]))) {
+		pos++;
+	}
+}
+
+static bool parseJsonString(const std::string& s, size_t& pos, std::string& result)
+{
+	skipJsonSpace(s, pos);
+	if (pos >= s.size() || s[pos] != '"') {
+		return false;
+	}
+	result.clear();
+	for (pos++; pos < s.size(); pos++) {
+		char c = s[pos];
+		if (c == '"') {
+			pos++;
+			return true;
+		}
+		if (c == '\\') {
+			if (++pos >= s.size()) {
+				return false;
+			}
+			switch (s[pos]) {
+			case 'b': c = '\b'; break;
+			case 'f': c = '\f'; break;
+			case 'n': c = '\n'; break;
+			case 'r': c = '\r'; break;
+			case 't': c = '\t'; break;
+			case 'u': {
+				if (pos + 4 >= s.size() || !std::all_of(s.begin() + pos + 1, s.begin() + pos + 5, [](char h) { return std::isxdigit(static_cast<unsigned char>(h)) != 0; })) {
+					return false;
+				}
+				const unsigned long u = std::stoul(s.substr(pos + 1, 4), nullptr, 16);
+				pos += 4;
+				if (u < 0x80) { // (encode as utf-8)
+					result += static_cast<char>(u);
+				} else if (u < 0x800) {
+					result += static_cast<char>(0xc0 | (u >> 6));
+					result += static_cast<char>(0x80 | (u & 0x3f));
+				} else {
+					result += static_cast<char>(0xe0 | (u >> 12));
+					result += static_cast<char>(0x80 | ((u >> 6) & 0x3f));
+					result += static_cast<char>(0x80 | (u & 0x3f));
+				}
+				continue;
+			}
+			default: c = s[pos]; break; // (\" \\ \/)
+			}
+		}
+		result += c;
+	}
+	return false;
+}
+
+static bool parseJsonStringArray(const std::string& s, size_t& pos, std::vector<std::string>& result)
+{
+	skipJsonSpace(s, pos);
+	if (pos >= s.size() || s[pos] != '[') {
+		return false;
+	}
+	pos++;
+	skipJsonSpace(s, pos);
+	if (pos < s.size() && s[pos] == ']') {
+		pos++;
+		return true;
+	}
+	for (;;) {
+		std::string item;
+		if (!parseJsonString(s, pos, item)) {
+			return false;
+		}
+		result.push_back(item);
+		skipJsonSpace(s, pos);
+		if (pos < s.size() && s[pos] == ',') {
+			pos++;
+		} else if (pos < s.size() && s[pos] == ']') {
+			pos++;
+			return true;
+		} else {
+			return false;
+		}
+	}
+}
+
+// getRequestArgs() : get args (not including program name) from a request sent to the server (--server), which is either:
+// a) a line of options, in the same syntax as the command line (arguments containing spaces enclosed in double quotes)
+// b) a JSON array of args eg ["-i", "in.wav", "-o", "out.wav", "-r", "44100"]
+// c) a JSON object with an array of args and (optionally) the client's working directory eg {"cwd": "/home/me", "args": ["-i", ...]}
+// Returns false if the request can't be parsed
+bool getRequestArgs(const std::string& request, std::vector<std::string>& args, std::string& cwd)
+{
+	args.clear();
+	cwd.clear();
+	size_t pos = 0;
+	skipJsonSpace(request, pos);
+	if (pos >= request.size()) {
+		return false;
+	}
+
+	if (request[pos] == '[') {
+		return parseJsonStringArray(request, pos, args);
+	}
+
+	if (request[pos] == '{') {
+		pos++;
+		bool haveArgs = false;
+		for (;;) {
+			std::string key;
+			if (!parseJsonString(request, pos, key)) {
+				return false;
+			}
+			skipJsonSpace(request, pos);
+			if (pos >= request.size() || request[pos] != ':') {
+				return false;
+			}
+			pos++;
+			if (key == "args") {
+				if (!parseJsonStringArray(request, pos, args)) {
+					return false;
+				}
+				haveArgs = true;
+			} else if (key == "cwd") {
+				if (!parseJsonString(request, pos, cwd)) {
+					return false;
+				}
+			} else {
+				return false;
+			}
+			skipJsonSpace(request, pos);
+			if (pos < request.size() && request[pos] == ',') {
+				pos++;
+			} else if (pos < request.size() && request[pos] == '}') {
+				return haveArgs;
+			} else {
+				return false;
+			}
+		}
+	}
+
+	args = splitManifestLine(request);
+	return true;
+}
+
+// getMergeInputs() : filenames following --merge (up to the next option)
+std::vector<std::string> getMergeInputs(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; i++) {
+		if (sanitize(argv[i]) == "--merge") {
+			for (int j = i + 1; j < argc && argv[j][0] != '-'; j++) {
+				inputs.emplace_back(argv[j]);
+			}
+			break;
+		}
+	}
+	return inputs;
+}
+
+// getCacheOptions() : canonical form of the options which may affect the output of a conversion (for output cache keys):
+// all args except filenames and options which only affect messages / resource usage, with option names sanitized.
+// (options which can be written in several ways, or in a different order, only cause cache misses, never false hits)
+static std::string getCacheOptions(int argc, char** argv)
+{
+	static const std::vector<std::string> ignoredWithValue {
+		"-i", "-o", "--cache", "--progressupdates", "--batchjobs", "--serverjobs", "--tempdir", "--shard"
+	};
+	static const std::vector<std::string> ignored {
+		"--cachelink", "--incremental", "--mt", "--pinthreads", "--showplacement", "--showstages", "--showtempfile", "--notempfile"
+	};
+
+	std::string result;
+	for (int i = 1; i < argc; i++) {
+		std::string arg(argv[i]);
+		if (!arg.empty() && arg[0] == '-') {
+			arg = sanitize(arg);
+			if (std::find(ignoredWithValue.begin(), ignoredWithValue.end(), arg) != ignoredWithValue.end()) {
+				i++;
+				continue;
+			}
+			if (std::find(ignored.begin(), ignored.end(), arg) != ignored.end()) {
+				continue;
+			}
+		}
+		result += arg;
+		result += '\n';
+	}
+	return result;
+}
+
 std::string ConversionInfo::toCmdLineArgs() {
 	std::vector<std::string> args;
 	std::string result;
@@ -133,6 +508,16 @@ std::string ConversionInfo::toCmdLineArgs() {
 		args.push_back(std::to_string(maxStages));
 	}
 
+	if (maxFilterLength > 0) {
+		args.emplace_back("--maxFilterLength");
+		args.push_back(std::to_string(maxFilterLength));
+	}
+
+	if (bAsrc) {
+		args.emplace_back("--asrc");
+		args.push_back(std::to_string(asrcDrift));
+	}
+
 	for(auto it = args.begin(); it != args.end(); it++) {
 		result.append(*it);
 		if (it != std::prev(args.end()))
@@ -185,6 +570,11 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv)
 	bSetVorbisQuality = true;
 	vorbisQuality = 3;
 	disableClippingProtection = false;
+	bEarlyAbort = false;
+	bLimiter = false;
+	limiterLookahead = 5.0;
+	limiterRelease = 100.0;
+	bLimiterTruePeak = false;
 	lpfMode = normal;
 	lpfCutoff = 100.0 * (10.0 / 11.0);
 	lpfTransitionWidth = 100.0 - lpfCutoff;
@@ -193,7 +583,12 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv)
 	dsfInput = false;
 	dffInput = false;
 	bEnablePeakDetection = true;
+	bIgnorePeakChunk = false;
+	bMmapInput = true;
+	bNativeWriter = false;
 	bMultiThreaded = false;
+	bPinThreads = false;
+	bShowPlacement = false;
 	bRf64 = false;
 	bNoPeakChunk = false;
 	bWriteMetaData = true;
@@ -203,11 +598,27 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv)
 	bShowStages = false;
 	bTmpFile = true;
 	bShowTempFile = false;
+	bSpill = false;
+	spillRamLimit = 1024;
 	overSamplingFactor = 1;
 	progressUpdates = 10;
+	blockSize = 0;
+	maxFilterLength = 0;
+	bAsrc = false;
+	asrcDrift = 0.0;
+	inputPeak = 0.0;
+	cacheDir.clear();
+	cacheOptions.clear();
+	bCacheLink = false;
+	inputPosition = 0;
+	shardIndex = 0;
+	shardCount = 0;
 	bBadParams = false;
 	appName.clear();
 	bRawInput = false;
+	bRawOutput = false;
+	bStreamInput = false;
+	bStreamOutput = false;
 	bDemodulateIQ = false;
 	bAdjustStereoWidth = false;
 	stereoWidth = 1.0;
@@ -226,6 +637,10 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv)
 	getCmdlineParam(argv, argv + argc, "--gain", gain);
 	bUseDoublePrecision = getCmdlineParam(argv, argv + argc, "--doubleprecision");
 	disableClippingProtection = getCmdlineParam(argv, argv + argc, "--noClippingProtection");
+	bEarlyAbort = getCmdlineParam(argv, argv + argc, "--earlyAbort");
+	bLimiter = getCmdlineParam(argv, argv + argc, "--limiter", limiterLookahead);
+	getCmdlineParam(argv, argv + argc, "--limiter-release", limiterRelease);
+	bLimiterTruePeak = getCmdlineParam(argv, argv + argc, "--truePeak");
 	bNormalize = getCmdlineParam(argv, argv + argc, "-n", normalizeAmount);
 	bDither = getCmdlineParam(argv, argv + argc, "--dither", ditherAmount);
 	ditherProfileID = getDefaultNoiseShape(outputSampleRate);
@@ -238,14 +653,40 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv)
 	bSetFlacCompression = getCmdlineParam(argv, argv + argc, "--flacCompression", flacCompressionLevel);
 	bSetVorbisQuality = getCmdlineParam(argv, argv + argc, "--vorbisQuality", vorbisQuality);
 	bMultiThreaded = getCmdlineParam(argv, argv + argc, "--mt");
+	bPinThreads = getCmdlineParam(argv, argv + argc, "--pinThreads");
+	bShowPlacement = getCmdlineParam(argv, argv + argc, "--showPlacement");
 	bRf64 = getCmdlineParam(argv, argv + argc, "--rf64");
 	bNoPeakChunk = getCmdlineParam(argv, argv + argc, "--noPeakChunk");
+	bIgnorePeakChunk = getCmdlineParam(argv, argv + argc, "--ignorePeakChunk");
+	bMmapInput = !getCmdlineParam(argv, argv + argc, "--noMmap");
+	bNativeWriter = getCmdlineParam(argv, argv + argc, "--nativeWriter");
 	bWriteMetaData = !getCmdlineParam(argv, argv + argc, "--noMetadata");
 	getCmdlineParam(argv, argv + argc, "--maxStages", maxStages);
 	bSingleStage = getCmdlineParam(argv, argv + argc, "--singleStage");
 	bMultiStage = getCmdlineParam(argv, argv + argc, "--multiStage");
 	integerWriteScalingStyle = getCmdlineParam(argv, argv + argc, "--pow2clip") ? IntegerWriteScalingStyle::Pow2Clip : IntegerWriteScalingStyle::Pow2Minus1;
 	getCmdlineParam(argv, argv + argc, "--progress-updates", progressUpdates);
+	getCmdlineParam(argv, argv + argc, "--blockSize", blockSize); // (non-numeric, eg "auto": leave as 0)
+	getCmdlineParam(argv, argv + argc, "--maxFilterLength", maxFilterLength);
+	bAsrc = getCmdlineParam(argv, argv + argc, "--asrc", asrcDrift);
+	bIncremental = getCmdlineParam(argv, argv + argc, "--incremental");
+	if (getCmdlineParam(argv, argv + argc, "--cache", cacheDir)) {
+		bCacheLink = getCmdlineParam(argv, argv + argc, "--cacheLink");
+	}
+	std::string shard;
+	if (getCmdlineParam(argv, argv + argc, "--shard", shard)) {
+		const auto slash = shard.find('/');
+		shardIndex = std::atoi(shard.substr(0, slash).c_str());
+		shardCount = (slash == std::string::npos) ? 0 : std::atoi(shard.substr(slash + 1).c_str());
+		if (shardCount < 1 || shardIndex < 1 || shardIndex > shardCount) {
+			std::cout << "Error: --shard expects k/N (part k of N, where 1 <= k <= N)" << std::endl;
+			bBadParams = true;
+			return false;
+		}
+	}
+	if (!cacheDir.empty() || bIncremental || shardCount > 0) {
+		cacheOptions = getCacheOptions(argc, argv);
+	}
 
     bDemodulateIQ = getCmdlineParam(argv, argv + argc, "--demodulateIQ");
 	if (bDemodulateIQ) {
@@ -301,6 +742,11 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv)
 
 	bTmpFile = !getCmdlineParam(argv, argv + argc, "--noTempFile");
 	bShowTempFile = getCmdlineParam(argv, argv + argc, "--showTempFile");
+	if (bLimiter) { // limiter replaces multi-pass clipping protection (and the temp file that goes with it)
+		bTmpFile = false;
+		disableClippingProtection = true;
+	}
+	bSpill = getCmdlineParam(argv, argv + argc, "--spill", spillRamLimit);
 
 	/* resolve conflicts between singleStage and multiStage, according to this table:
 	IN   OUT
@@ -355,6 +801,27 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv)
 		}
 	}
 
+	bRawOutput = getCmdlineParam(argv, argv + argc, "--raw-output");
+
+	// streaming (stdin / stdout): the input can only be read once, and the output can only be written once
+	bStreamInput = (inputFilename == "-");
+	bStreamOutput = (outputFilename == "-");
+	if (bStreamInput || bStreamOutput) {
+		bTmpFile = false;
+		if (!bLimiter && !disableClippingProtection) {
+			std::cout << "Streaming: single pass, clipping protection disabled (use --limiter to prevent clipping)" << std::endl;
+			disableClippingProtection = true;
+		}
+	}
+
+	if (bStreamInput) {
+		bMmapInput = false;
+		if (bFadeOut) {
+			std::cout << "Warning: fade-out not available when streaming from stdin (length unknown)" << std::endl;
+			bFadeOut = false;
+		}
+	}
+
 	double qb = 0.0;
 	quantize = getCmdlineParam(argv, argv + argc, "--quantize-bits", qb);
 	quantizeBits = static_cast<int>(std::floor(qb));
@@ -375,6 +842,14 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv)
 	constrainDouble(lpfCutoff, 1.0, 99.9);
 	constrainDouble(lpfTransitionWidth, 0.1, 400.0);
 	constrainInt(progressUpdates, 0, 100);
+	constrainInt(blockSize, 0, 1 << 20);
+	constrainDouble(asrcDrift, -10000.0, 10000.0);
+	if (maxFilterLength != 0) {
+		constrainInt(maxFilterLength, 15, FILTERSIZE_LIMIT);
+	}
+	constrainInt(spillRamLimit, 0, 1 << 20);
+	constrainDouble(limiterLookahead, 0.1, 100.0);
+	constrainDouble(limiterRelease, 1.0, 5000.0);
 
 	if (bNormalize) {
 		if (normalizeAmount <= 0.0)
@@ -400,6 +875,9 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv)
 		if (inputFilename.empty()) {
 			std::cout << "Error: Input filename not specified" << std::endl;
 			bBadParams = true;
+		} else if (bStreamInput) {
+			std::cout << "Error: Output filename not specified (use -o - for stdout)" << std::endl;
+			bBadParams = true;
 		} else {
 			std::cout << "Output filename not specified" << std::endl;
 			outputFilename = inputFilename;
@@ -414,7 +892,7 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv)
 		}
 	}
 
-	else if (outputFilename == inputFilename) {
+	else if (outputFilename == inputFilename && !bStreamInput) {
 		std::cout << "\nError: Input and Output filenames cannot be the same" << std::endl;
 		bBadParams = true;
 	}
@@ -14,8 +14,10 @@
 // defines the ConversionInfo struct,
 // for holding conversion parameters.
 
+#include <cstdint>
 #include <list>
 #include <string>
+#include <vector>
 #include "csv.h"
 #include "iqdemodulator.h"
 
@@ -54,6 +56,11 @@ struct ConversionInfo
 	bool bSetVorbisQuality;
 	double vorbisQuality;
 	bool disableClippingProtection;
+	bool bEarlyAbort;
+	bool bLimiter;
+	double limiterLookahead; // ms
+	double limiterRelease; // ms
+	bool bLimiterTruePeak;
 	LPFMode lpfMode;
 	double lpfCutoff;
 	double lpfTransitionWidth;
@@ -63,7 +70,12 @@ struct ConversionInfo
 	bool dffInput;
 	bool csvOutput;
 	bool bEnablePeakDetection;
+	bool bIgnorePeakChunk;
+	bool bMmapInput;
+	bool bNativeWriter;
 	bool bMultiThreaded;
+	bool bPinThreads; // pin channel threads to CPUs, and place each channel's filter memory on the NUMA node of its CPU (--pinThreads)
+	bool bShowPlacement; // report CPU / NUMA node placement of channel threads and filter memory (--showPlacement)
 	bool bRf64;
 	bool bNoPeakChunk;
 	bool bWriteMetaData;
@@ -72,6 +84,18 @@ struct ConversionInfo
 	bool bMultiStage;
 	bool bShowStages;
 	int progressUpdates;
+	int blockSize; // number of frames processed at a time (0: auto)
+	int maxFilterLength; // upper limit on length of each stage's FIR filter (0: no limit)
+	bool bAsrc; // use asynchronous (variable-ratio) converter
+	double asrcDrift; // (ppm) input clock drift, relative to nominal input sample rate
+	double inputPeak; // peak input sample, if already known (0: unknown - scan input file)
+	std::string cacheDir; // output cache directory (--cache), empty: no cache
+	std::string cacheOptions; // canonical form of the options which affect the output (part of the cache key, and incremental conversion key)
+	bool bCacheLink; // place cached results by hard link, rather than copying
+	bool bIncremental; // re-convert only the regions of input which have changed since the previous conversion (--incremental)
+	int64_t inputPosition; // position of first input sample, within a longer input (for converting a region - see Converter::setPosition())
+	int shardIndex; // convert part shardIndex (1 ... shardCount) of the input (--shard k/N)
+	int shardCount; // number of parts (0: not sharded)
 	int overSamplingFactor;
 	bool bBadParams;
 
@@ -83,6 +107,8 @@ struct ConversionInfo
 
 	bool bTmpFile;
 	bool bShowTempFile;
+	bool bSpill;
+	int spillRamLimit; // MB
 	bool quantize;
 	int quantizeBits;
 	IntegerWriteScalingStyle integerWriteScalingStyle;
@@ -90,6 +116,9 @@ struct ConversionInfo
 	int rawInputChannels;
 	int rawInputSampleRate;
 	std::string rawInputBitFormat;
+	bool bRawOutput;
+	bool bStreamInput; // input is stdin ("-i -")
+	bool bStreamOutput; // output is stdout ("-o -")
 	bool bDemodulateIQ;
 	ModulationType IQModulationType;
     DeEmphasisType IQDeEmphasisType;
@@ -111,6 +140,10 @@ bool getCmdlineParam(char** begin, char** end, const std::string& option, T& par
 bool getCmdlineParam(char** begin, char** end, const std::string& option, std::string& parameter); // fetch a string parameter
 bool getCmdlineParam(char** begin, char** end, const std::string& option, std::vector<std::string>& parameters); // fetch a vector of strings
 bool getCmdlineParam(char** begin, char** end, const std::string& option); // detect presence of command-line switch only
+std::vector<std::vector<std::string>> getOutputTargets(int argc, char** argv); // split args into one set of args per output target
+std::vector<std::vector<std::string>> getBatchJobs(int argc, char** argv); // get one set of args per job of a batch (--batch)
+bool getRequestArgs(const std::string& request, std::vector<std::string>& args, std::string& cwd); // get args from a server request (--server)
+std::vector<std::string> getMergeInputs(int argc, char** argv); // get filenames of shards to be merged (--merge)
 int getDefaultNoiseShape(int sampleRate);
 
 static_assert(std::is_copy_constructible<ConversionInfo>::value,
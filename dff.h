@@ -22,6 +22,7 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #define DFF_MAX_CHANNELS 6 
 #define DFF_FORMAT 0x00300000 // note: take care to make sure this doesn't clash with future libsndfile formats (unlikely)
@@ -183,6 +184,7 @@ public:
 
 			bufferSize = blockSize * numChannels;
 			inputBuffer = new uint8_t[bufferSize];
+			idleRun.assign(numChannels, 0);
 			totalBytesRead = 0;
 			endOfBlock = bufferSize;
 			bufferIndex = endOfBlock; // empty (zero -> full)
@@ -261,7 +263,11 @@ public:
 				bufferIndex = 0;
 			}
 
-			buffer[i] = samplTbl[inputBuffer[bufferIndex + currentChannel]][currentBit];
+			const uint8_t byte = inputBuffer[bufferIndex + currentChannel];
+			if (currentBit == 0) { // (count consecutive idle bytes of channel)
+				idleRun[currentChannel] = (byte == idleByte) ? std::min(idleRun[currentChannel] + 1, minIdleRun + 1) : 0;
+			}
+			buffer[i] = (idleRun[currentChannel] > minIdleRun) ? static_cast<FloatType>(0.0) : static_cast<FloatType>(samplTbl[byte][currentBit]);
 			++samplesRead;
 
 			// cycle through channels, then bits, then bufferIndex
@@ -302,6 +308,7 @@ public:
 		bufferIndex = endOfBlock; // empty (zero -> full)
 		currentBit = 0;
 		currentChannel = 0;
+		std::fill(idleRun.begin(), idleRun.end(), 0);
 
 		// rewind file pointer
 		file.clear(); // in case of eof
@@ -331,6 +338,12 @@ private:
 	uint64_t startOfData{};
 	double samplTbl[256][8]{};
 
+	// DSD idle (silence) pattern: once a channel has had more than minIdleRun consecutive idle bytes (0x69),
+	// they are read as exact zeros, so that the converter's silence fast path (see FIRFilter) applies. (See also DsfFile)
+	static constexpr uint32_t minIdleRun = 16;
+	static constexpr uint8_t idleByte = 0x69;
+	std::vector<uint32_t> idleRun;
+
 	void getChunkHeader(dffChunkHeader* chunkHeader)
 	{
 		chunkHeader->ckID = bigEndianRead32();
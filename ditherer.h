@@ -268,6 +268,25 @@ public:
 //
 
 FloatType dither(FloatType inSample)
+{
+	return reciprocalSignalMagnitude * quantize(inSample);
+} // ends function: dither()
+
+// ditherToInt() : same as dither(), but returns the quantized sample as an integer
+// (in units of the target format's LSB; ie unnormalized)
+
+long ditherToInt(FloatType inSample)
+{
+	return std::lrint(quantize(inSample));
+} // ends function: ditherToInt()
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+private:
+
+// quantize() : dither, noise-shape and quantize inSample, returning an (integral) number of LSBs
+
+FloatType quantize(FloatType inSample)
 {
 	// Auto-Blanking
 	if (bAutoBlankingEnabled) {
@@ -291,14 +310,12 @@ FloatType dither(FloatType inSample)
 	FloatType preDither = bUseErrorFeedback ? inSample - (this->*noiseShapingFilter)(Z1) : inSample;
 	FloatType preQuantize, postQuantize;
 	preQuantize = masterVolume * (preDither + noise);
-	postQuantize = reciprocalSignalMagnitude * round(maxSignalMagnitude * preQuantize); // quantize
+	FloatType quantized = round(maxSignalMagnitude * preQuantize); // quantize
+	postQuantize = reciprocalSignalMagnitude * quantized;
 	Z1 = (postQuantize - preDither);
-	return postQuantize;
-} // ends function: dither()
+	return quantized;
+} // ends function: quantize()
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-private:
 	int oldRandom;
 	int seed;
 	FloatType Z1;				// last Quantization error
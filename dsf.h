@@ -215,7 +215,11 @@ namespace ReSampler {
 					bufferIndex = 0;
 				}
 
-				buffer[i] = static_cast<FloatType>(samplTbl[channelBuffer[currentChannel][bufferIndex]][currentBit]);
+				const uint8_t byte = channelBuffer[currentChannel][bufferIndex];
+				if (currentBit == 0) { // (count consecutive idle bytes of channel)
+					idleRun[currentChannel] = (byte == idleByte) ? std::min(idleRun[currentChannel] + 1, minIdleRun + 1) : 0;
+				}
+				buffer[i] = (idleRun[currentChannel] > minIdleRun) ? static_cast<FloatType>(0.0) : static_cast<FloatType>(samplTbl[byte][currentBit]);
 
 				++samplesRead;
 
@@ -258,6 +262,7 @@ namespace ReSampler {
 			bufferIndex = blockSize; // empty (zero -> full)
 			currentBit = 0;
 			currentChannel = 0;
+			std::fill(std::begin(idleRun), std::end(idleRun), 0);
 
 			// seek:
 			file.clear();
@@ -287,6 +292,13 @@ namespace ReSampler {
 		uint64_t endOfData;
 		double samplTbl[256][8];
 
+		// DSD idle (silence) pattern: 0x69, in MSB-first order. Once a channel has had more than minIdleRun consecutive idle bytes,
+		// they are read as exact zeros (rather than as a pattern which the lowpass filter reduces to almost nothing anyway),
+		// so that the converter's silence fast path (see FIRFilter) applies.
+		static constexpr uint32_t minIdleRun = 16;
+		uint8_t idleByte{0x69};
+		uint32_t idleRun[6]{};
+
 		void assertSizes()
 		{
 			static_assert(sizeof(dsfDSDChunk) == 28, "");
@@ -403,6 +415,7 @@ namespace ReSampler {
 					samplTbl[i][j] = (i & mask) ? 1.0 : -1.0;
 				}
 			}
+			idleByte = (dsfFmtChunk.bitOrder == 8) ? 0x69 : 0x96; // (0x69 with bits reversed, if LSB-first)
 		}
 	};
 
@@ -14,6 +14,7 @@
 
 #include <vector>
 #include <memory>
+#include <memory_resource>
 
 namespace ReSampler {
 
@@ -21,6 +22,15 @@ template <typename FloatType>
 class Effect
 {
 public:
+	Effect() = default;
+	Effect(const Effect&) = delete;
+	Effect& operator=(const Effect&) = delete;
+
+	virtual ~Effect()
+	{
+		freeOutputBuffer();
+	}
+
 	virtual const FloatType* process(const FloatType* inputBuffer, int sampleCount) = 0;
 
 	// getters
@@ -45,10 +55,13 @@ public:
 		channelCount = value;
 	}
 
-	void setBufferSize(int value)
+	// setBufferSize() : (re)allocate outputBuffer, from memory if given (eg an Arena), otherwise from the heap
+	void setBufferSize(int value, std::pmr::memory_resource* memory = nullptr)
 	{
+		freeOutputBuffer();
 		outputBufferSize = value;
-		outputBuffer.reset(new FloatType[outputBufferSize]);
+		outputBufferMemory = (memory == nullptr) ? std::pmr::get_default_resource() : memory;
+		outputBuffer = static_cast<FloatType*>(outputBufferMemory->allocate(outputBufferSize * sizeof(FloatType), alignof(FloatType)));
 	}
 
     void setSampleRate(int value)
@@ -58,10 +71,21 @@ public:
 
 protected:
     // each effect owns an outputBuffer
-    std::unique_ptr<FloatType> outputBuffer;
-	int outputBufferSize;
+    FloatType* outputBuffer{nullptr};
+	int outputBufferSize{0};
 	int channelCount;
     int sampleRate;
+
+private:
+	std::pmr::memory_resource* outputBufferMemory{nullptr};
+
+	void freeOutputBuffer()
+	{
+		if (outputBuffer != nullptr) {
+			outputBufferMemory->deallocate(outputBuffer, outputBufferSize * sizeof(FloatType), alignof(FloatType));
+			outputBuffer = nullptr;
+		}
+	}
 };
 
 } // namespace ReSampler
@@ -15,6 +15,7 @@
 
 
 #include "effect.h"
+#include <memory_resource>
 #include <vector>
 
 namespace ReSampler {
@@ -36,7 +37,7 @@ public:
 	// add() : adds an effect to the chain
 	void add(Effect<FloatType>* effect)
 	{
-		effect->setBufferSize(outputBufferSize);
+		effect->setBufferSize(outputBufferSize, memory);
 		effect->setChannelCount(channelCount);
 		effects.push_back(effect);
 	}
@@ -88,11 +89,18 @@ public:
 		takeOwnership = value;
 	}
 
+	// setMemoryResource() : where the output buffers of effects added from now on are allocated (nullptr: heap)
+	void setMemoryResource(std::pmr::memory_resource* value)
+	{
+		memory = value;
+	}
+
 private:
 	std::vector<Effect<FloatType>*> effects;
 	int outputBufferSize;
 	int channelCount;
 	bool takeOwnership{true};
+	std::pmr::memory_resource* memory{nullptr};
 };
 
 } // namespace ReSampler
@@ -30,7 +30,7 @@ class FadeEffect : public Effect<FloatType>
 public:
     virtual const FloatType* process(const FloatType* inputBuffer, int sampleCount)
     {
-        FloatType* p = Effect<FloatType>::outputBuffer.get();
+        FloatType* p = Effect<FloatType>::outputBuffer;
 
 		if(fadeType == FadeTypeNone) {
 			// bypass
@@ -0,0 +1,165 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// incremental.h : state for incremental re-conversion (--incremental)
+
+// IncrementalState records, alongside an output file (in <output>.rsinc), what the output was converted from:
+// the conversion key (options and version), the shape of the input, a hash of each block of input samples,
+// and the size and modification time of the output (so that an output which has since been changed by something else isn't patched).
+// Comparing the block hashes of a new version of the input with the recorded ones gives the regions which have changed.
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H 1
+
+#include "mappedpcm.h"
+#include "sha256.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ReSampler {
+
+class IncrementalState
+{
+public:
+	static constexpr int64_t defaultBlockFrames = 16384;
+
+	std::string key;
+	int channels{0};
+	int64_t inputFrames{0};
+	int64_t blockFrames{defaultBlockFrames};
+	uintmax_t outputSize{0};
+	long long outputTime{0};
+	std::vector<std::string> blockHashes;
+
+	static std::string stateFilename(const std::string& outputFilename)
+	{
+		return outputFilename + ".rsinc";
+	}
+
+	bool load(const std::string& outputFilename)
+	{
+		std::ifstream file(stateFilename(outputFilename));
+		std::string magic;
+		size_t numBlocks = 0;
+		if (!(file >> magic >> key >> channels >> inputFrames >> blockFrames >> outputSize >> outputTime >> numBlocks) || magic != "ReSampler-incremental-1" || blockFrames <= 0) {
+			return false;
+		}
+		blockHashes.resize(numBlocks);
+		for (auto& h : blockHashes) {
+			if (!(file >> h)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool save(const std::string& outputFilename) const
+	{
+		const std::string filename = stateFilename(outputFilename);
+		const std::string tmp = filename + ".tmp";
+		{
+			std::ofstream file(tmp);
+			file << "ReSampler-incremental-1 " << key << " " << channels << " " << inputFrames << " " << blockFrames << " "
+				 << outputSize << " " << outputTime << " " << blockHashes.size() << "\n";
+			for (const auto& h : blockHashes) {
+				file << h << "\n";
+			}
+			if (!file) {
+				return false;
+			}
+		}
+		std::error_code ec;
+		std::filesystem::rename(tmp, filename, ec);
+		return !ec;
+	}
+
+	// remove() : remove state (eg when output is no longer known to correspond to it)
+	static void remove(const std::string& outputFilename)
+	{
+		std::error_code ec;
+		std::filesystem::remove(stateFilename(outputFilename), ec);
+	}
+
+	// setInput() : record shape and block hashes of input
+	void setInput(const MappedPcmFile& input)
+	{
+		channels = input.channels();
+		inputFrames = input.frames();
+		blockHashes = hashBlocks(input, blockFrames);
+	}
+
+	// setOutput() : record size and modification time of output file
+	bool setOutput(const std::string& outputFilename)
+	{
+		return getFileStamp(outputFilename, outputSize, outputTime);
+	}
+
+	// outputUnchanged() : true if output file still has the recorded size and modification time
+	bool outputUnchanged(const std::string& outputFilename) const
+	{
+		uintmax_t size = 0;
+		long long time = 0;
+		return getFileStamp(outputFilename, size, time) && size == outputSize && time == outputTime;
+	}
+
+	// getChangedRegions() : compare block hashes with newHashes, and return changed regions (first frame, end frame) of input
+	std::vector<std::pair<int64_t, int64_t>> getChangedRegions(const std::vector<std::string>& newHashes) const
+	{
+		std::vector<std::pair<int64_t, int64_t>> regions;
+		for (size_t b = 0; b < newHashes.size(); b++) {
+			if (b < blockHashes.size() && newHashes[b] == blockHashes[b]) {
+				continue;
+			}
+			const int64_t first = static_cast<int64_t>(b) * blockFrames;
+			const int64_t end = std::min(first + blockFrames, inputFrames);
+			if (!regions.empty() && regions.back().second == first) {
+				regions.back().second = end;
+			} else {
+				regions.emplace_back(first, end);
+			}
+		}
+		return regions;
+	}
+
+	// hashBlocks() : hash of the sample data of each block of blockFrames frames (128 bits, as hex)
+	static std::vector<std::string> hashBlocks(const MappedPcmFile& input, int64_t blockFrames)
+	{
+		std::vector<std::string> hashes;
+		const int64_t bytesPerFrame = input.bytesPerFrame();
+		for (int64_t first = 0; first < input.frames(); first += blockFrames) {
+			const int64_t frames = std::min(blockFrames, input.frames() - first);
+			Sha256 h;
+			h.update(input.data() + first * bytesPerFrame, static_cast<size_t>(frames * bytesPerFrame));
+			hashes.push_back(h.hexDigest().substr(0, 32));
+		}
+		return hashes;
+	}
+
+private:
+	static bool getFileStamp(const std::string& filename, uintmax_t& size, long long& time)
+	{
+		std::error_code ec;
+		size = std::filesystem::file_size(filename, ec);
+		if (ec) {
+			return false;
+		}
+		time = static_cast<long long>(std::filesystem::last_write_time(filename, ec).time_since_epoch().count());
+		return !ec;
+	}
+};
+
+} // namespace ReSampler
+
+#endif // INCREMENTAL_H
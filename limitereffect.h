@@ -0,0 +1,265 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// limitereffect.h : defines LimiterEffect Class
+// a lookahead peak limiter, with optional (4x oversampled) inter-sample peak detection.
+
+// The required gain for each frame (threshold / peak) is passed through a sliding minimum,
+// followed by a moving average of the same length, which ramps the gain down smoothly
+// and reaches the required gain no later than the frame containing the peak.
+// Release is exponential. Audio is delayed by getLatency() frames.
+
+#ifndef LIMITEREFFECT_H
+#define LIMITEREFFECT_H
+
+#include "effect.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+namespace ReSampler {
+
+template <typename FloatType>
+class LimiterEffect : public Effect<FloatType>
+{
+	using Effect<FloatType>::channelCount;
+	using Effect<FloatType>::sampleRate;
+
+public:
+	virtual const FloatType* process(const FloatType* inputBuffer, int sampleCount)
+	{
+		if (delayLine.empty()) {
+			initState();
+		}
+
+		FloatType* p = Effect<FloatType>::outputBuffer;
+		for (int i = 0; i < sampleCount; i += channelCount) {
+
+			// detect peak of incoming frame:
+			double peak = 0.0;
+			if (truePeak) {
+				peak = detectTruePeak(inputBuffer + i);
+			} else {
+				for (int ch = 0; ch < channelCount; ch++) {
+					peak = std::max(peak, static_cast<double>(std::abs(inputBuffer[i + ch])));
+				}
+			}
+
+			double requiredGain = (peak > threshold) ? threshold / peak : 1.0;
+
+			// sliding minimum (monotonic queue):
+			if (minCount > 0 && minPositions[minHead] + static_cast<int64_t>(windowLength) <= position) {
+				minHead = (minHead + 1) % windowLength; // expire oldest
+				minCount--;
+			}
+			while (minCount > 0 && minValues[(minHead + minCount - 1) % windowLength] >= requiredGain) {
+				minCount--;
+			}
+			size_t back = (minHead + minCount) % windowLength;
+			minValues[back] = requiredGain;
+			minPositions[back] = position;
+			minCount++;
+			double slidingMin = minValues[minHead];
+
+			// moving average:
+			size_t boxIndex = static_cast<size_t>(position % static_cast<int64_t>(windowLength));
+			boxSum += slidingMin - boxValues[boxIndex];
+			boxValues[boxIndex] = slidingMin;
+			double targetGain = boxSum / windowLength;
+
+			// attack immediately, release exponentially:
+			gain = (targetGain < gain) ? targetGain : targetGain + (gain - targetGain) * releaseCoefficient;
+
+			// push incoming frame into delay line, and output delayed frame with gain applied:
+			FloatType* d = delayLine.data() + delayIndex * channelCount;
+			for (int ch = 0; ch < channelCount; ch++) {
+				double y = d[ch] * gain;
+				p[i + ch] = static_cast<FloatType>(std::max(-threshold, std::min(y, threshold))); // guard against rounding
+				d[ch] = inputBuffer[i + ch];
+			}
+			delayIndex = (delayIndex + 1) % delayFrames;
+
+			// statistics:
+			if (gain < 1.0 && position >= latency) {
+				limitedFrames++;
+				minGain = std::min(minGain, gain);
+			}
+
+			position++;
+		}
+		return p;
+	}
+
+	// getLatency() : delay (in frames) between input and output
+	int getLatency() const
+	{
+		return lookaheadFrames() + (truePeak ? truePeakDelay : 0);
+	}
+
+	// getMaxGainReduction() : largest gain reduction applied so far, in dB (0 or negative)
+	double getMaxGainReduction() const
+	{
+		return 20 * std::log10(minGain);
+	}
+
+	// getLimitedFrames() : number of frames which have had gain reduction applied
+	int64_t getLimitedFrames() const
+	{
+		return limitedFrames;
+	}
+
+	double getThreshold() const
+	{
+		return threshold;
+	}
+
+	double getLookahead() const
+	{
+		return lookahead;
+	}
+
+	double getRelease() const
+	{
+		return release;
+	}
+
+	bool getTruePeak() const
+	{
+		return truePeak;
+	}
+
+	// setters (must be called prior to processing, after setSampleRate())
+	void setThreshold(double value)
+	{
+		threshold = value;
+	}
+
+	void setLookahead(double seconds)
+	{
+		lookahead = seconds;
+	}
+
+	void setRelease(double seconds)
+	{
+		release = seconds;
+	}
+
+	void setTruePeak(bool value)
+	{
+		truePeak = value;
+	}
+
+private:
+	static constexpr int truePeakTaps = 16;
+	static constexpr int truePeakPhases = 4;
+	static constexpr int truePeakCentre = truePeakTaps / 2 - 1; // position of centre sample in history
+	static constexpr int truePeakDelay = truePeakTaps - 1 - truePeakCentre;
+
+	double threshold{1.0};
+	double lookahead{0.005};
+	double release{0.1};
+	bool truePeak{false};
+
+	// state:
+	int64_t position{0};
+	int latency{0};
+	size_t windowLength{1};
+	size_t delayFrames{1};
+	size_t delayIndex{0};
+	std::vector<FloatType> delayLine;
+	std::vector<double> minValues;
+	std::vector<int64_t> minPositions;
+	size_t minHead{0};
+	size_t minCount{0};
+	std::vector<double> boxValues;
+	double boxSum{0.0};
+	double gain{1.0};
+	double releaseCoefficient{0.0};
+	std::vector<double> truePeakHistory;
+	std::vector<double> truePeakKernel;
+
+	// statistics:
+	double minGain{1.0};
+	int64_t limitedFrames{0};
+
+	int lookaheadFrames() const
+	{
+		return std::max(1, static_cast<int>(std::lround(lookahead * sampleRate)));
+	}
+
+	void initState()
+	{
+		latency = getLatency();
+		windowLength = static_cast<size_t>(lookaheadFrames()) + 1;
+		delayFrames = static_cast<size_t>(latency);
+		delayIndex = 0;
+		delayLine.assign(delayFrames * channelCount, 0.0);
+		minValues.assign(windowLength, 1.0);
+		minPositions.assign(windowLength, 0);
+		minHead = 0;
+		minCount = 0;
+		boxValues.assign(windowLength, 1.0);
+		boxSum = static_cast<double>(windowLength);
+		gain = 1.0;
+		releaseCoefficient = (release > 0.0) ? std::exp(-1.0 / (release * sampleRate)) : 0.0;
+		position = 0;
+
+		if (truePeak) {
+			truePeakHistory.assign(truePeakTaps * channelCount, 0.0);
+
+			// Hann-windowed sinc interpolation kernel for the in-between phases, normalized to unity gain:
+			truePeakKernel.assign((truePeakPhases - 1) * truePeakTaps, 0.0);
+			for (int phase = 1; phase < truePeakPhases; phase++) {
+				double* k = truePeakKernel.data() + (phase - 1) * truePeakTaps;
+				double sum = 0.0;
+				for (int n = 0; n < truePeakTaps; n++) {
+					double t = static_cast<double>(phase) / truePeakPhases - (n - truePeakCentre);
+					double w = 0.5 * (1.0 + std::cos(M_PI * t / (truePeakTaps / 2)));
+					k[n] = w * ((t == 0.0) ? 1.0 : std::sin(M_PI * t) / (M_PI * t));
+					sum += k[n];
+				}
+				for (int n = 0; n < truePeakTaps; n++) {
+					k[n] /= sum;
+				}
+			}
+		}
+	}
+
+	// detectTruePeak() : push frame into interpolator history,
+	// and return largest absolute value of (delayed) centre sample and interpolated values following it
+	double detectTruePeak(const FloatType* frame)
+	{
+		double peak = 0.0;
+		for (int ch = 0; ch < channelCount; ch++) {
+			double* h = truePeakHistory.data() + ch * truePeakTaps;
+			std::copy(h + 1, h + truePeakTaps, h);
+			h[truePeakTaps - 1] = frame[ch];
+			peak = std::max(peak, std::abs(h[truePeakCentre]));
+			for (int phase = 1; phase < truePeakPhases; phase++) {
+				const double* k = truePeakKernel.data() + (phase - 1) * truePeakTaps;
+				double acc = 0.0;
+				for (int n = 0; n < truePeakTaps; n++) {
+					acc += h[n] * k[n];
+				}
+				peak = std::max(peak, std::abs(acc));
+			}
+		}
+		return peak;
+	}
+};
+
+} // namespace ReSampler
+
+#endif // LIMITEREFFECT_H
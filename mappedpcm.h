@@ -0,0 +1,895 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// mappedpcm.h : defines MappedPcmFile class, which provides read-only, memory-mapped access
+// to the sample data of uncompressed PCM files (wav, rf64, w64, aiff / aifc),
+// and MappedPcmReader class, which uses it to read input files for conversion
+
+// Samples are decoded with the same scaling that libsndfile uses when reading integer formats as floating-point
+// (ie 1/0x80 for 8-bit, 1/0x8000 for 16-bit, 1/0x800000 for 24-bit, 1/0x80000000 for 32-bit)
+
+#ifndef MAPPEDPCM_H
+#define MAPPEDPCM_H 1
+
+#include "osspecific.h"
+#include "simdops.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sndfile.hh>
+
+#if !defined (_WIN32) && !defined (_WIN64)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ReSampler {
+
+enum MappedPcmSampleFormat
+{
+	MappedPcmNone,
+	MappedPcmU8,
+	MappedPcmS8,
+	MappedPcm16,
+	MappedPcm24,
+	MappedPcm32,
+	MappedPcmFloat,
+	MappedPcmDouble
+};
+
+class MappedPcmFile
+{
+public:
+	explicit MappedPcmFile(const std::string& path)
+	{
+		if (map(path)) {
+			valid = parseWav() || parseW64() || parseAiff();
+		}
+	}
+
+	~MappedPcmFile()
+	{
+		unmap();
+	}
+
+	MappedPcmFile(const MappedPcmFile&) = delete;
+	MappedPcmFile& operator=(const MappedPcmFile&) = delete;
+
+	bool isValid() const
+	{
+		return valid;
+	}
+
+	int channels() const
+	{
+		return numChannels;
+	}
+
+	int64_t frames() const
+	{
+		return numFrames;
+	}
+
+	int64_t samples() const
+	{
+		return numFrames * numChannels;
+	}
+
+	MappedPcmSampleFormat sampleFormat() const
+	{
+		return format;
+	}
+
+	bool isBigEndian() const
+	{
+		return bigEndian;
+	}
+
+	int bytesPerSample() const
+	{
+		return sampleBytes;
+	}
+
+	// data() : pointer to first byte of first sample
+	const uint8_t* data() const
+	{
+		return fileData + dataOffset;
+	}
+
+	// offset() : position of first byte of first sample, from start of file
+	int64_t offset() const
+	{
+		return dataOffset;
+	}
+
+	// peakChunkOffset() : position of the body of the PEAK chunk (if any) from start of file, otherwise -1.
+	// The body is: version, timestamp, then (value, position) for each channel; all 32-bit, in the byte order of headerIsBigEndian()
+	int64_t peakChunkOffset() const
+	{
+		return peakOffset;
+	}
+
+	// headerIsBigEndian() : byte order of header fields (aiff: big-endian, even when samples are little-endian)
+	bool headerIsBigEndian() const
+	{
+		return bigEndianHeader;
+	}
+
+	// bytesPerFrame() : size of one frame (one sample of every channel)
+	int bytesPerFrame() const
+	{
+		return sampleBytes * numChannels;
+	}
+
+	// adviseSequential() : hint to OS that data will be read sequentially
+	void adviseSequential() const
+	{
+#if !defined (_WIN32) && !defined (_WIN64)
+		if (fileData != nullptr) {
+			madvise(const_cast<uint8_t*>(fileData), static_cast<size_t>(fileSize), MADV_SEQUENTIAL);
+		}
+#endif
+	}
+
+	// sample() : decode a single (normalized) sample
+	template<typename FloatType>
+	FloatType sample(int64_t index) const
+	{
+		const uint8_t* b = data() + index * sampleBytes;
+		switch (format) {
+		case MappedPcmU8:
+			return static_cast<FloatType>(static_cast<int>(b[0]) - 128) * static_cast<FloatType>(1.0 / 0x80);
+		case MappedPcmS8:
+			return static_cast<FloatType>(static_cast<int8_t>(b[0])) * static_cast<FloatType>(1.0 / 0x80);
+		case MappedPcm16:
+			return static_cast<FloatType>(int16At(b)) * static_cast<FloatType>(1.0 / 0x8000);
+		case MappedPcm24:
+			return static_cast<FloatType>(int24At(b)) * static_cast<FloatType>(1.0 / 0x800000);
+		case MappedPcm32:
+			return static_cast<FloatType>(int32At(b)) * static_cast<FloatType>(1.0 / 0x80000000);
+		case MappedPcmFloat:
+			return static_cast<FloatType>(floatAt(b));
+		case MappedPcmDouble:
+			return static_cast<FloatType>(doubleAt(b));
+		default:
+			return 0.0;
+		}
+	}
+
+	// decode() : decode (normalized) samples in the range [first, first + count) into out
+	template<typename FloatType>
+	void decode(int64_t first, size_t count, FloatType* out) const
+	{
+		const uint8_t* b = data() + first * sampleBytes;
+		const bool nativeOrder = !bigEndian && isLittleEndianHost();
+
+		switch (format) {
+		case MappedPcm16:
+			if (nativeOrder) {
+				SimdOps::decodeInt16(b, out, count, static_cast<FloatType>(1.0 / 0x8000));
+				return;
+			}
+			break;
+
+		case MappedPcm24:
+			if (nativeOrder) {
+				SimdOps::decodeInt24(b, out, count, static_cast<FloatType>(1.0 / 0x800000));
+				return;
+			}
+			for (size_t i = 0; i < count; i++) {
+				out[i] = static_cast<FloatType>(int24At(b + 3 * i)) * static_cast<FloatType>(1.0 / 0x800000);
+			}
+			return;
+
+		case MappedPcm32:
+			if (nativeOrder) {
+				SimdOps::decodeInt32(b, out, count, static_cast<FloatType>(1.0 / 0x80000000));
+				return;
+			}
+			break;
+
+		case MappedPcmFloat:
+			if (nativeOrder) {
+				for (size_t i = 0; i < count; i++) {
+					float f;
+					std::memcpy(&f, b + 4 * i, 4);
+					out[i] = static_cast<FloatType>(f);
+				}
+				return;
+			}
+			break;
+
+		case MappedPcmDouble:
+			if (nativeOrder) {
+				for (size_t i = 0; i < count; i++) {
+					double d;
+					std::memcpy(&d, b + 8 * i, 8);
+					out[i] = static_cast<FloatType>(d);
+				}
+				return;
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			out[i] = sample<FloatType>(first + static_cast<int64_t>(i));
+		}
+	}
+
+	// maxAbs() : return largest absolute (normalized) sample value in the range [first, first + count)
+	template<typename FloatType>
+	FloatType maxAbs(int64_t first, int64_t count) const
+	{
+		const uint8_t* b = data() + first * sampleBytes;
+		const auto n = static_cast<size_t>(count);
+		int64_t m = 0;
+
+		switch (format) {
+		case MappedPcmU8:
+			for (size_t i = 0; i < n; i++) {
+				m = std::max<int64_t>(m, std::abs(static_cast<int>(b[i]) - 128));
+			}
+			return static_cast<FloatType>(m) * static_cast<FloatType>(1.0 / 0x80);
+
+		case MappedPcmS8:
+			for (size_t i = 0; i < n; i++) {
+				m = std::max<int64_t>(m, std::abs(static_cast<int>(static_cast<int8_t>(b[i]))));
+			}
+			return static_cast<FloatType>(m) * static_cast<FloatType>(1.0 / 0x80);
+
+		case MappedPcm16:
+		{
+			int32_t m32 = 0; // (32-bit accumulator, for vectorisation)
+			for (size_t i = 0; i < n; i++) {
+				m32 = std::max(m32, std::abs(static_cast<int32_t>(int16At(b + 2 * i))));
+			}
+			return static_cast<FloatType>(m32) * static_cast<FloatType>(1.0 / 0x8000);
+		}
+
+		case MappedPcm24:
+			for (size_t i = 0; i < n; i++) {
+				m = std::max<int64_t>(m, std::abs(int24At(b + 3 * i)));
+			}
+			return static_cast<FloatType>(m) * static_cast<FloatType>(1.0 / 0x800000);
+
+		case MappedPcm32:
+			for (size_t i = 0; i < n; i++) {
+				m = std::max<int64_t>(m, std::abs(static_cast<int64_t>(int32At(b + 4 * i))));
+			}
+			return static_cast<FloatType>(m) * static_cast<FloatType>(1.0 / 0x80000000);
+
+		case MappedPcmFloat:
+			if (!bigEndian && isLittleEndianHost()) {
+				return static_cast<FloatType>(SimdOps::maxAbs(reinterpret_cast<const float*>(b), n));
+			} else {
+				float mf = 0.0f;
+				for (size_t i = 0; i < n; i++) {
+					mf = std::max(mf, std::abs(floatAt(b + 4 * i)));
+				}
+				return static_cast<FloatType>(mf);
+			}
+
+		case MappedPcmDouble:
+			if (!bigEndian && isLittleEndianHost()) {
+				return static_cast<FloatType>(SimdOps::maxAbs(reinterpret_cast<const double*>(b), n));
+			} else {
+				double md = 0.0;
+				for (size_t i = 0; i < n; i++) {
+					md = std::max(md, std::abs(doubleAt(b + 8 * i)));
+				}
+				return static_cast<FloatType>(md);
+			}
+
+		default:
+			return 0.0;
+		}
+	}
+
+	// find() : return index of first sample in range [first, first + count) having an absolute value of (at least) value, or -1 if not found
+	template<typename FloatType>
+	int64_t find(FloatType value, int64_t first, int64_t count) const
+	{
+		for (int64_t i = first; i < first + count; i++) {
+			if (std::abs(sample<FloatType>(i)) >= value) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+private:
+	const uint8_t* fileData{nullptr};
+	int64_t fileSize{0};
+	int64_t dataOffset{0};
+	int64_t numFrames{0};
+	int numChannels{0};
+	int sampleBytes{0};
+	MappedPcmSampleFormat format{MappedPcmNone};
+	bool bigEndian{false};
+	bool bigEndianHeader{false};
+	int64_t peakOffset{-1};
+	bool valid{false};
+
+#if defined (_WIN32) || defined (_WIN64)
+	HANDLE hFile{INVALID_HANDLE_VALUE};
+	HANDLE hMapping{nullptr};
+#endif
+
+	bool map(const std::string& path)
+	{
+#if defined (_WIN32) || defined (_WIN64)
+		hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0) {
+			return false;
+		}
+		hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (hMapping == nullptr) {
+			return false;
+		}
+		fileData = static_cast<const uint8_t*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+		fileSize = size.QuadPart;
+		return fileData != nullptr;
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return false;
+		}
+		struct stat st;
+		if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+			close(fd);
+			return false;
+		}
+		void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		close(fd); // (mapping remains valid)
+		if (p == MAP_FAILED) {
+			return false;
+		}
+		fileData = static_cast<const uint8_t*>(p);
+		fileSize = st.st_size;
+		return true;
+#endif
+	}
+
+	void unmap()
+	{
+#if defined (_WIN32) || defined (_WIN64)
+		if (fileData != nullptr) {
+			UnmapViewOfFile(fileData);
+		}
+		if (hMapping != nullptr) {
+			CloseHandle(hMapping);
+		}
+		if (hFile != INVALID_HANDLE_VALUE) {
+			CloseHandle(hFile);
+		}
+#else
+		if (fileData != nullptr) {
+			munmap(const_cast<uint8_t*>(fileData), static_cast<size_t>(fileSize));
+		}
+#endif
+		fileData = nullptr;
+	}
+
+	// header parsing
+
+	bool parseWav()
+	{
+		if (fileSize < 12 || std::memcmp(fileData + 8, "WAVE", 4) != 0) {
+			return false;
+		}
+		bool rf64 = (std::memcmp(fileData, "RF64", 4) == 0) || (std::memcmp(fileData, "BW64", 4) == 0);
+		if (!rf64 && std::memcmp(fileData, "RIFF", 4) != 0) {
+			return false;
+		}
+
+		bool haveFmt = false;
+		int formatTag = 0;
+		int bits = 0;
+		int blockAlign = 0;
+		int64_t ds64DataSize = -1;
+		int64_t peakChunk = -1;
+		int64_t peakChunkSize = 0;
+
+		for (int64_t pos = 12; pos + 8 <= fileSize; ) {
+			const uint8_t* chunk = fileData + pos;
+			int64_t chunkSize = le32(chunk + 4);
+
+			if (std::memcmp(chunk, "ds64", 4) == 0 && pos + 8 + 16 <= fileSize) {
+				ds64DataSize = static_cast<int64_t>(le64(chunk + 8 + 8));
+			}
+
+			else if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && pos + 8 + chunkSize <= fileSize) {
+				formatTag = le16(chunk + 8);
+				numChannels = le16(chunk + 10);
+				blockAlign = le16(chunk + 20);
+				bits = le16(chunk + 22);
+				if (formatTag == 0xFFFE && chunkSize >= 40) { // WAVE_FORMAT_EXTENSIBLE: take format from SubFormat GUID
+					formatTag = le16(chunk + 32);
+				}
+				haveFmt = true;
+			}
+
+			else if (std::memcmp(chunk, "PEAK", 4) == 0 && chunkSize >= 8 && pos + 8 + chunkSize <= fileSize) {
+				peakChunk = pos + 8;
+				peakChunkSize = chunkSize;
+			}
+
+			else if (std::memcmp(chunk, "data", 4) == 0) {
+				if (!haveFmt) {
+					return false;
+				}
+				if (rf64 && chunkSize == 0xFFFFFFFF && ds64DataSize >= 0) {
+					chunkSize = ds64DataSize;
+				}
+				return (formatTag == 1 || formatTag == 3) && setFormat(formatTag == 3, bits, false) && setData(pos + 8, chunkSize, blockAlign) &&
+						setPeakChunk(peakChunk, peakChunkSize, false);
+			}
+
+			pos += 8 + chunkSize + (chunkSize & 1);
+		}
+		return false;
+	}
+
+	bool parseW64()
+	{
+		static const uint8_t riffGuid[16] {'r', 'i', 'f', 'f', 0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00};
+		static const uint8_t waveGuidTail[12] {0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A}; // common to "wave", "fmt " and "data" GUIDs
+
+		if (fileSize < 40 || std::memcmp(fileData, riffGuid, 16) != 0 ||
+				std::memcmp(fileData + 24, "wave", 4) != 0 || std::memcmp(fileData + 28, waveGuidTail, 12) != 0) {
+			return false;
+		}
+
+		bool haveFmt = false;
+		int formatTag = 0;
+		int bits = 0;
+		int blockAlign = 0;
+
+		for (int64_t pos = 40; pos + 24 <= fileSize; ) {
+			const uint8_t* chunk = fileData + pos;
+			auto chunkSize = static_cast<int64_t>(le64(chunk + 16)); // (includes 24-byte chunk header)
+			if (chunkSize < 24) {
+				return false;
+			}
+			bool known = std::memcmp(chunk + 4, waveGuidTail, 12) == 0;
+
+			if (known && std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 24 + 16 && pos + chunkSize <= fileSize) {
+				formatTag = le16(chunk + 24);
+				numChannels = le16(chunk + 26);
+				blockAlign = le16(chunk + 36);
+				bits = le16(chunk + 38);
+				if (formatTag == 0xFFFE && chunkSize >= 24 + 40) {
+					formatTag = le16(chunk + 48);
+				}
+				haveFmt = true;
+			}
+
+			else if (known && std::memcmp(chunk, "data", 4) == 0) {
+				return haveFmt && (formatTag == 1 || formatTag == 3) && setFormat(formatTag == 3, bits, false) && setData(pos + 24, chunkSize - 24, blockAlign);
+			}
+
+			pos += (chunkSize + 7) & ~int64_t(7); // chunks are 8-byte aligned
+		}
+		return false;
+	}
+
+	bool parseAiff()
+	{
+		if (fileSize < 12 || std::memcmp(fileData, "FORM", 4) != 0) {
+			return false;
+		}
+		bool aifc = std::memcmp(fileData + 8, "AIFC", 4) == 0;
+		if (!aifc && std::memcmp(fileData + 8, "AIFF", 4) != 0) {
+			return false;
+		}
+
+		bool haveComm = false;
+		int bits = 0;
+		bool isFloat = false;
+		bool littleEndian = false;
+		int64_t commFrames = 0;
+		int64_t peakChunk = -1;
+		int64_t peakChunkSize = 0;
+
+		for (int64_t pos = 12; pos + 8 <= fileSize; ) {
+			const uint8_t* chunk = fileData + pos;
+			int64_t chunkSize = be32(chunk + 4);
+
+			if (std::memcmp(chunk, "COMM", 4) == 0 && chunkSize >= 18 && pos + 8 + chunkSize <= fileSize) {
+				numChannels = be16(chunk + 8);
+				commFrames = be32(chunk + 10);
+				bits = be16(chunk + 14);
+				if (aifc && chunkSize >= 22) {
+					const uint8_t* compressionType = chunk + 26;
+					if (std::memcmp(compressionType, "sowt", 4) == 0) {
+						littleEndian = true;
+					} else if (std::memcmp(compressionType, "fl32", 4) == 0 || std::memcmp(compressionType, "FL32", 4) == 0) {
+						isFloat = true;
+						bits = 32;
+					} else if (std::memcmp(compressionType, "fl64", 4) == 0 || std::memcmp(compressionType, "FL64", 4) == 0) {
+						isFloat = true;
+						bits = 64;
+					} else if (std::memcmp(compressionType, "NONE", 4) != 0 && std::memcmp(compressionType, "twos", 4) != 0) {
+						return false; // compressed
+					}
+				}
+				haveComm = true;
+			}
+
+			else if (std::memcmp(chunk, "PEAK", 4) == 0 && chunkSize >= 8 && pos + 8 + chunkSize <= fileSize) {
+				peakChunk = pos + 8;
+				peakChunkSize = chunkSize;
+			}
+
+			else if (std::memcmp(chunk, "SSND", 4) == 0 && chunkSize >= 8) {
+				if (!haveComm || !setFormat(isFloat, bits, !littleEndian)) {
+					return false;
+				}
+				if (format == MappedPcmU8) {
+					format = MappedPcmS8; // aiff 8-bit is signed
+				}
+				int64_t offset = be32(chunk + 8);
+				int64_t blockAlign = numChannels * sampleBytes;
+				return setData(pos + 16 + offset, std::min(chunkSize - 8 - offset, commFrames * blockAlign), static_cast<int>(blockAlign)) &&
+						setPeakChunk(peakChunk, peakChunkSize, true);
+			}
+
+			pos += 8 + chunkSize + (chunkSize & 1);
+		}
+		return false;
+	}
+
+	// setPeakChunk() : record position of PEAK chunk body (ignored unless it has an entry for every channel). Always returns true
+	bool setPeakChunk(int64_t offset, int64_t size, bool isBigEndian)
+	{
+		bigEndianHeader = isBigEndian;
+		if (offset >= 0 && size >= 8 + 8 * static_cast<int64_t>(numChannels)) {
+			peakOffset = offset;
+		}
+		return true;
+	}
+
+	bool setFormat(bool isFloat, int bits, bool isBigEndian)
+	{
+		bigEndian = isBigEndian;
+		if (isFloat) {
+			format = (bits == 32) ? MappedPcmFloat : (bits == 64) ? MappedPcmDouble : MappedPcmNone;
+		} else {
+			switch (bits) {
+			case 8:
+				format = MappedPcmU8;
+				break;
+			case 16:
+				format = MappedPcm16;
+				break;
+			case 24:
+				format = MappedPcm24;
+				break;
+			case 32:
+				format = MappedPcm32;
+				break;
+			default:
+				format = MappedPcmNone;
+			}
+		}
+		sampleBytes = bits / 8;
+		return format != MappedPcmNone && numChannels > 0;
+	}
+
+	bool setData(int64_t offset, int64_t size, int blockAlign)
+	{
+		if (blockAlign != numChannels * sampleBytes || offset < 0 || offset > fileSize || size < 0) {
+			return false;
+		}
+		dataOffset = offset;
+		numFrames = std::min(size, fileSize - offset) / blockAlign; // (allow for truncated files)
+		return true;
+	}
+
+	// byte-order helpers
+
+	static bool isLittleEndianHost()
+	{
+		const uint16_t one = 1;
+		uint8_t b;
+		std::memcpy(&b, &one, 1);
+		return b == 1;
+	}
+
+	static int le16(const uint8_t* b)
+	{
+		return b[0] | (b[1] << 8);
+	}
+
+	static int64_t le32(const uint8_t* b)
+	{
+		return static_cast<int64_t>(static_cast<uint32_t>(b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<uint32_t>(b[3]) << 24)));
+	}
+
+	static uint64_t le64(const uint8_t* b)
+	{
+		return static_cast<uint64_t>(le32(b)) | (static_cast<uint64_t>(le32(b + 4)) << 32);
+	}
+
+	static int be16(const uint8_t* b)
+	{
+		return (b[0] << 8) | b[1];
+	}
+
+	static int64_t be32(const uint8_t* b)
+	{
+		return static_cast<int64_t>((static_cast<uint32_t>(b[0]) << 24) | (b[1] << 16) | (b[2] << 8) | b[3]);
+	}
+
+	int16_t int16At(const uint8_t* b) const
+	{
+		return static_cast<int16_t>(bigEndian ? ((b[0] << 8) | b[1]) : (b[0] | (b[1] << 8)));
+	}
+
+	int32_t int24At(const uint8_t* b) const
+	{
+		uint32_t u = bigEndian ? ((static_cast<uint32_t>(b[0]) << 24) | (b[1] << 16) | (b[2] << 8)) :
+								 ((static_cast<uint32_t>(b[2]) << 24) | (b[1] << 16) | (b[0] << 8));
+		return static_cast<int32_t>(u) >> 8; // sign-extend
+	}
+
+	int32_t int32At(const uint8_t* b) const
+	{
+		return static_cast<int32_t>(bigEndian ? static_cast<uint32_t>(be32(b)) : static_cast<uint32_t>(le32(b)));
+	}
+
+	float floatAt(const uint8_t* b) const
+	{
+		uint32_t u = static_cast<uint32_t>(int32At(b));
+		float f;
+		std::memcpy(&f, &u, 4);
+		return f;
+	}
+
+	double doubleAt(const uint8_t* b) const
+	{
+		uint64_t u = bigEndian ? ((static_cast<uint64_t>(be32(b)) << 32) | static_cast<uint64_t>(be32(b + 4))) : le64(b);
+		double d;
+		std::memcpy(&d, &u, 8);
+		return d;
+	}
+};
+
+// MappedPcmReader : a FileReader (see convert()) which reads sample data directly from a memory-map of the input file.
+// libsndfile is still used to open the file, and for header information and metadata.
+// If the file can't be mapped (or libsndfile disagrees about the layout), reads go through libsndfile instead.
+
+class MappedPcmReader
+{
+public:
+	explicit MappedPcmReader(const std::string& fileName) : sndfileHandle(fileName)
+	{
+		open(fileName, 0);
+	}
+
+	MappedPcmReader(const std::string& fileName, int infileMode, int infileFormat, int infileChannels, int infileRate)
+		: sndfileHandle(fileName, infileMode, infileFormat, infileChannels, infileRate)
+	{
+		open(fileName, infileFormat);
+	}
+
+	int error()
+	{
+		return sndfileHandle.error();
+	}
+
+	int channels()
+	{
+		return sndfileHandle.channels();
+	}
+
+	int samplerate()
+	{
+		return sndfileHandle.samplerate();
+	}
+
+	sf_count_t frames()
+	{
+		return sndfileHandle.frames();
+	}
+
+	int format()
+	{
+		return sndfileHandle.format();
+	}
+
+	// read() : read count interleaved samples into buffer; returns number of samples read
+	template<typename FloatType>
+	sf_count_t read(FloatType* buffer, sf_count_t count)
+	{
+		if (!mapped) {
+			return sndfileHandle.read(buffer, count);
+		}
+
+		const int nChannels = mapped->channels();
+		const sf_count_t n = std::min<sf_count_t>(count / nChannels, mapped->frames() - position);
+		mapped->decode(position * nChannels, static_cast<size_t>(n * nChannels), buffer);
+		position += n;
+		return n * nChannels;
+	}
+
+	// readPlanar() : read up to count frames, straight into separate channel buffers; returns number of frames read
+	template<typename FloatType>
+	sf_count_t readPlanar(FloatType* const* buffers, sf_count_t count)
+	{
+		const int nChannels = channels();
+		if (!mapped) {
+			std::vector<FloatType>& scratch = scratchBuffer(static_cast<FloatType*>(nullptr));
+			scratch.resize(static_cast<size_t>(count * nChannels));
+			const sf_count_t n = sndfileHandle.read(scratch.data(), count * nChannels) / nChannels;
+			SimdOps::deinterleave(scratch.data(), buffers, nChannels, static_cast<size_t>(n));
+			return n;
+		}
+
+		const sf_count_t n = std::min<sf_count_t>(count, mapped->frames() - position);
+		if (nChannels == 1) {
+			mapped->decode(position, static_cast<size_t>(n), buffers[0]);
+		} else {
+			// decode (cache-sized) sub-blocks, and de-interleave each one into channel buffers:
+			std::vector<FloatType>& scratch = scratchBuffer(static_cast<FloatType*>(nullptr));
+			scratch.resize(scratchFrames * nChannels);
+			std::vector<FloatType*>& channelPointers = channelPointerBuffer(static_cast<FloatType*>(nullptr));
+			channelPointers.assign(buffers, buffers + nChannels);
+			for (sf_count_t done = 0; done < n; done += scratchFrames) {
+				const auto frames = static_cast<size_t>(std::min<sf_count_t>(scratchFrames, n - done));
+				mapped->decode((position + done) * nChannels, frames * nChannels, scratch.data());
+				SimdOps::deinterleave(scratch.data(), channelPointers.data(), nChannels, frames);
+				for (auto& p : channelPointers) {
+					p += frames;
+				}
+			}
+		}
+		position += n;
+		return n;
+	}
+
+	// seek() : set read position (in frames); returns new position, or -1 on error
+	sf_count_t seek(sf_count_t frames, int whence)
+	{
+		if (!mapped) {
+			return sndfileHandle.seek(frames, whence);
+		}
+
+		sf_count_t newPosition = (whence == SEEK_CUR) ? position + frames :
+								 (whence == SEEK_END) ? mapped->frames() + frames : frames;
+		if (newPosition < 0 || newPosition > mapped->frames()) {
+			return -1;
+		}
+		position = newPosition;
+		return position;
+	}
+
+	int command(int cmd, void* data, int datasize)
+	{
+		return sndfileHandle.command(cmd, data, datasize);
+	}
+
+	const char* getString(int str_type) const
+	{
+		return sndfileHandle.getString(str_type);
+	}
+
+	bool isMapped() const
+	{
+		return mapped != nullptr;
+	}
+
+	const MappedPcmFile& mappedFile() const
+	{
+		return *mapped;
+	}
+
+	SndfileHandle& sndfile()
+	{
+		return sndfileHandle;
+	}
+
+	// isConsistent() : returns true if libsndfile agrees with mapped file on layout and sample format
+	static bool isConsistent(const MappedPcmFile& mapped, SndfileHandle& sndfileHandle)
+	{
+		if (!mapped.isValid() || mapped.channels() != sndfileHandle.channels() || mapped.frames() != sndfileHandle.frames()) {
+			return false;
+		}
+
+		int subFormat;
+		switch (mapped.sampleFormat()) {
+		case MappedPcmU8:
+			subFormat = SF_FORMAT_PCM_U8;
+			break;
+		case MappedPcmS8:
+			subFormat = SF_FORMAT_PCM_S8;
+			break;
+		case MappedPcm16:
+			subFormat = SF_FORMAT_PCM_16;
+			break;
+		case MappedPcm24:
+			subFormat = SF_FORMAT_PCM_24;
+			break;
+		case MappedPcm32:
+			subFormat = SF_FORMAT_PCM_32;
+			break;
+		case MappedPcmFloat:
+			subFormat = SF_FORMAT_FLOAT;
+			break;
+		case MappedPcmDouble:
+			subFormat = SF_FORMAT_DOUBLE;
+			break;
+		default:
+			return false;
+		}
+		return subFormat == (sndfileHandle.format() & SF_FORMAT_SUBMASK);
+	}
+
+private:
+	static constexpr sf_count_t scratchFrames = 1024;
+	SndfileHandle sndfileHandle;
+	std::unique_ptr<MappedPcmFile> mapped;
+	sf_count_t position{0};
+	std::vector<float> scratchFloat;
+	std::vector<double> scratchDouble;
+	std::vector<float*> channelPointersFloat;	// (readPlanar()'s write positions in the channel buffers)
+	std::vector<double*> channelPointersDouble;
+
+	void open(const std::string& fileName, int infileFormat)
+	{
+		if (sndfileHandle.error() != SF_ERR_NO_ERROR || (infileFormat & SF_FORMAT_TYPEMASK) == SF_FORMAT_RAW) {
+			return;
+		}
+		mapped.reset(new MappedPcmFile(fileName));
+		if (!isConsistent(*mapped, sndfileHandle)) {
+			mapped.reset();
+			return;
+		}
+		mapped->adviseSequential();
+	}
+
+	std::vector<float>& scratchBuffer(float*)
+	{
+		return scratchFloat;
+	}
+
+	std::vector<double>& scratchBuffer(double*)
+	{
+		return scratchDouble;
+	}
+
+	std::vector<float*>& channelPointerBuffer(float*)
+	{
+		return channelPointersFloat;
+	}
+
+	std::vector<double*>& channelPointerBuffer(double*)
+	{
+		return channelPointersDouble;
+	}
+};
+
+} // namespace ReSampler
+
+#endif // MAPPEDPCM_H
@@ -0,0 +1,190 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// outputcache.h : content-addressed cache of conversion results (--cache <dir>)
+
+// Each result is stored under a key, which is the SHA-256 hash of:
+// the program version, the SHA-256 hash of the input file's contents, the (canonical) conversion options, and the output format.
+// Cache layout:
+//   <dir>/objects/<first 2 digits of key>/<key> : output files
+//   <dir>/index/<hash of input path> : "size modification-time content-hash" of input files hashed previously,
+//   so that an unchanged input file doesn't need to be read again, just to find its hash.
+
+#ifndef OUTPUTCACHE_H
+#define OUTPUTCACHE_H 1
+
+#include "conversioninfo.h"
+#include "sha256.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ReSampler {
+
+class OutputCache
+{
+public:
+	explicit OutputCache(const std::string& dir) : dir(dir) {}
+
+	// getInputHash() : hash of input file's contents (empty if it can't be read).
+	// The hash is read from the index if the file's size and modification time haven't changed since it was last hashed
+	std::string getInputHash(const std::string& filename)
+	{
+		namespace fs = std::filesystem;
+		std::error_code ec;
+		const fs::path path = fs::absolute(filename, ec);
+		const auto size = fs::file_size(path, ec);
+		if (ec) {
+			return {};
+		}
+		const auto mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+		if (ec) {
+			return {};
+		}
+
+		Sha256 pathHash;
+		pathHash.update(path.string());
+		const fs::path indexFile = fs::path(dir) / "index" / pathHash.hexDigest();
+
+		// look up index:
+		std::ifstream index(indexFile);
+		uintmax_t indexedSize = 0;
+		long long indexedTime = 0;
+		std::string indexedHash;
+		if (index >> indexedSize >> indexedTime >> indexedHash && indexedSize == size && indexedTime == static_cast<long long>(mtime) && indexedHash.size() == 64) {
+			return indexedHash;
+		}
+		index.close();
+
+		// hash the file:
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			return {};
+		}
+		Sha256 contentHash;
+		std::vector<char> buffer(1 << 20);
+		while (file) {
+			file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			contentHash.update(buffer.data(), static_cast<size_t>(file.gcount()));
+		}
+		const std::string hash = contentHash.hexDigest();
+
+		// record in index:
+		const fs::path tmp = tempName(indexFile);
+		fs::create_directories(indexFile.parent_path(), ec);
+		{
+			std::ofstream out(tmp);
+			out << size << " " << static_cast<long long>(mtime) << " " << hash << "\n";
+		}
+		fs::rename(tmp, indexFile, ec);
+		if (ec) {
+			fs::remove(tmp, ec);
+		}
+		return hash;
+	}
+
+	// makeKey() : key for the result of converting input (with the given content hash), with the options and output format of ci
+	static std::string makeKey(const std::string& version, const std::string& inputHash, const ConversionInfo& ci)
+	{
+		std::string ext = std::filesystem::path(ci.outputFilename).extension().string();
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		std::ostringstream s;
+		s << "ReSampler " << version << "\n"
+		  << "input " << inputHash << "\n"
+		  << "options " << ci.cacheOptions << "\n"
+		  << "output " << ci.outputSampleRate << " " << ci.outputFormat << " " << ci.outBitFormat << " " << ext << "\n";
+		Sha256 key;
+		key.update(s.str());
+		return key.hexDigest();
+	}
+
+	// fetch() : if a result is cached under key, place it at outputFilename (as a hard link if link is true and possible, otherwise a copy).
+	// A linked output shares the (read-only) cached object's inode, so conversions call detachOutput() before writing to an output file
+	bool fetch(const std::string& key, const std::string& outputFilename, bool link, bool& linked)
+	{
+		namespace fs = std::filesystem;
+		std::error_code ec;
+		const fs::path object = objectPath(key);
+		linked = false;
+		if (!fs::is_regular_file(object, ec)) {
+			return false;
+		}
+		fs::remove(outputFilename, ec);
+		if (link) {
+			fs::create_hard_link(object, outputFilename, ec);
+			linked = !ec;
+		}
+		if (!linked) {
+			ec.clear();
+			if (!fs::copy_file(object, outputFilename, fs::copy_options::overwrite_existing, ec) || ec) {
+				return false;
+			}
+			fs::permissions(outputFilename, fs::perms::owner_write, fs::perm_options::add, ec); // (a copy is an ordinary, writable file)
+		}
+		return !ec;
+	}
+
+	// store() : store a copy of outputFilename in the cache, under key.
+	// (Always a copy: an object linked to the output file would be overwritten by a later conversion to the same output file)
+	bool store(const std::string& key, const std::string& outputFilename)
+	{
+		namespace fs = std::filesystem;
+		std::error_code ec;
+		const fs::path object = objectPath(key);
+		fs::create_directories(object.parent_path(), ec);
+		const fs::path tmp = tempName(object);
+		bool ok = fs::copy_file(outputFilename, tmp, fs::copy_options::overwrite_existing, ec) && !ec;
+		if (ok) {
+			fs::permissions(tmp, fs::perms::owner_read | fs::perms::group_read | fs::perms::others_read, ec);
+			fs::rename(tmp, object, ec); // (atomic: concurrent readers see either no object, or a complete one)
+			ok = !ec;
+		}
+		if (!ok) {
+			fs::remove(tmp, ec);
+		}
+		return ok;
+	}
+
+	// detachOutput() : if outputFilename is one of several hard links to a file (eg a cached result fetched with --cacheLink),
+	// remove it, so that writing the output creates a new file, instead of overwriting the file in place.
+	// (Read-only permissions alone can't guarantee that, eg when running as root)
+	static void detachOutput(const std::string& outputFilename)
+	{
+		namespace fs = std::filesystem;
+		std::error_code ec;
+		if (fs::is_regular_file(outputFilename, ec) && fs::hard_link_count(outputFilename, ec) > 1 && !ec) {
+			fs::remove(outputFilename, ec);
+		}
+	}
+
+private:
+	std::string dir;
+
+	std::filesystem::path objectPath(const std::string& key) const
+	{
+		return std::filesystem::path(dir) / "objects" / key.substr(0, 2) / key;
+	}
+
+	// tempName() : unique name alongside path (for writing, before renaming to path)
+	static std::filesystem::path tempName(const std::filesystem::path& path)
+	{
+		std::random_device r;
+		return path.string() + ".tmp." + std::to_string(r()) + std::to_string(r());
+	}
+};
+
+} // namespace ReSampler
+
+#endif // OUTPUTCACHE_H
@@ -0,0 +1,612 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// pcmwriter.h : defines PcmFileWriter class, a native writer for uncompressed wav, rf64, w64 and (headerless) raw files
+// (8/16/24/32-bit integer, 32/64-bit floating-point).
+
+// The predicted size of the file is preallocated up-front (to reduce fragmentation of large files),
+// and samples are encoded into a large aligned buffer, which is written out with (positioned) writes.
+// In wav / rf64 files, a JUNK chunk pads the header, so that the sample data (and therefore every write) starts on a page boundary.
+// The header is written with placeholder sizes when the file is opened, and patched with the final sizes on close.
+// Conversion from floating-point is the same as libsndfile's (no clipping).
+
+// A path of "-" streams a wav or raw file to stdout (which libsndfile can't do for wav).
+// In that case, nothing is preallocated or patched: the riff and data sizes are written as 0xFFFFFFFF ("unknown length"),
+// and there is no PEAK chunk or JUNK padding.
+
+#ifndef PCMWRITER_H
+#define PCMWRITER_H 1
+
+#include "alignedmalloc.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <sndfile.hh>
+
+#if defined (_WIN32) || defined (_WIN64)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace ReSampler {
+
+class PcmFileWriter
+{
+public:
+	// expectedFrames : predicted length of file (for preallocation). addPeakChunk : write PEAK chunk (floating-point formats only)
+	PcmFileWriter(const std::string& path, int format, int channels, int sampleRate, int64_t expectedFrames, bool addPeakChunk)
+		: format(format), nChannels(channels), sampleRate(sampleRate),
+		  peaks(static_cast<size_t>(std::max(channels, 1)))
+	{
+		if (!isSupported(format) || channels <= 0 || sampleRate <= 0) {
+			err = SF_ERR_UNSUPPORTED_ENCODING;
+			return;
+		}
+
+		const int majorFormat = format & SF_FORMAT_TYPEMASK;
+		streaming = (path == "-");
+		if (streaming && majorFormat != SF_FORMAT_WAV && majorFormat != SF_FORMAT_RAW) {
+			err = SF_ERR_UNSUPPORTED_ENCODING;
+			return;
+		}
+
+		const int subFormat = format & SF_FORMAT_SUBMASK;
+		isFloat = (subFormat == SF_FORMAT_FLOAT || subFormat == SF_FORMAT_DOUBLE);
+		bytesPerSample = (subFormat == SF_FORMAT_PCM_U8 || subFormat == SF_FORMAT_PCM_S8) ? 1 : (subFormat == SF_FORMAT_PCM_16) ? 2 :
+						 (subFormat == SF_FORMAT_PCM_24) ? 3 : (subFormat == SF_FORMAT_DOUBLE) ? 8 : 4;
+		hasPeakChunk = addPeakChunk && isFloat && !streaming && majorFormat != SF_FORMAT_W64 && majorFormat != SF_FORMAT_RAW;
+
+		bufferSize = static_cast<size_t>(bytesPerSample) << 20; // (multiple of both page size and sample size)
+		buffer = static_cast<uint8_t*>(aligned_malloc(bufferSize, pageSize));
+		if (buffer == nullptr || !openFile(path)) {
+			err = SF_ERR_SYSTEM;
+			return;
+		}
+
+		// write (provisional) header:
+		const std::vector<uint8_t> header = makeHeader();
+		dataOffset = static_cast<int64_t>(header.size());
+		if (!writeAt(0, header.data(), header.size())) {
+			return;
+		}
+
+		if (!streaming) {
+			preallocate(dataOffset + std::max<int64_t>(0, expectedFrames) * nChannels * bytesPerSample);
+		}
+	}
+
+	~PcmFileWriter()
+	{
+		close();
+		aligned_free(buffer);
+	}
+
+	PcmFileWriter(const PcmFileWriter&) = delete;
+	PcmFileWriter& operator=(const PcmFileWriter&) = delete;
+
+	// isSupported() : returns true if format can be written by PcmFileWriter
+	static bool isSupported(int format)
+	{
+		const int majorFormat = format & SF_FORMAT_TYPEMASK;
+		if (majorFormat != SF_FORMAT_WAV && majorFormat != SF_FORMAT_RF64 && majorFormat != SF_FORMAT_W64 && majorFormat != SF_FORMAT_RAW) {
+			return false;
+		}
+
+		if ((format & SF_FORMAT_ENDMASK) != SF_ENDIAN_FILE && (format & SF_FORMAT_ENDMASK) != SF_ENDIAN_LITTLE) {
+			return false; // (little-endian only)
+		}
+
+		switch (format & SF_FORMAT_SUBMASK) {
+		case SF_FORMAT_PCM_S8:
+			return majorFormat == SF_FORMAT_RAW;
+		case SF_FORMAT_PCM_U8:
+		case SF_FORMAT_PCM_16:
+		case SF_FORMAT_PCM_24:
+		case SF_FORMAT_PCM_32:
+		case SF_FORMAT_FLOAT:
+		case SF_FORMAT_DOUBLE:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	int error() const
+	{
+		return err;
+	}
+
+	const char* strError() const
+	{
+		return sf_error_number(err);
+	}
+
+	// write() : write count (normalized) floating-point samples. Returns number of samples written
+	template<typename FloatType>
+	sf_count_t write(const FloatType* data, sf_count_t count)
+	{
+		const int subFormat = format & SF_FORMAT_SUBMASK;
+		for (sf_count_t i = 0; i < count && err == SF_ERR_NO_ERROR; ) {
+			const auto n = static_cast<sf_count_t>(std::min<int64_t>(count - i, (bufferSize - bufferUsed) / bytesPerSample));
+			uint8_t* p = buffer + bufferUsed;
+			const FloatType* src = data + i;
+
+			switch (subFormat) {
+			case SF_FORMAT_PCM_U8:
+				for (sf_count_t s = 0; s < n; s++) {
+					p[s] = static_cast<uint8_t>(std::lrint(static_cast<FloatType>(0x7F) * src[s]) + 128);
+				}
+				break;
+			case SF_FORMAT_PCM_S8:
+				for (sf_count_t s = 0; s < n; s++) {
+					p[s] = static_cast<uint8_t>(std::lrint(static_cast<FloatType>(0x7F) * src[s]));
+				}
+				break;
+			case SF_FORMAT_PCM_16:
+				for (sf_count_t s = 0; s < n; s++) {
+					putLE(p + 2 * s, static_cast<uint32_t>(std::lrint(static_cast<FloatType>(0x7FFF) * src[s])), 2);
+				}
+				break;
+			case SF_FORMAT_PCM_24:
+				for (sf_count_t s = 0; s < n; s++) {
+					putLE(p + 3 * s, static_cast<uint32_t>(std::lrint(static_cast<FloatType>(0x7FFFFF) * src[s])), 3);
+				}
+				break;
+			case SF_FORMAT_PCM_32:
+				for (sf_count_t s = 0; s < n; s++) {
+					putLE(p + 4 * s, static_cast<uint32_t>(std::lrint(static_cast<FloatType>(0x7FFFFFFF) * src[s])), 4);
+				}
+				break;
+			case SF_FORMAT_FLOAT:
+				for (sf_count_t s = 0; s < n; s++) {
+					const auto f = static_cast<float>(src[s]);
+					std::memcpy(p + 4 * s, &f, 4);
+					trackPeak(s, std::abs(f));
+				}
+				break;
+			case SF_FORMAT_DOUBLE:
+				for (sf_count_t s = 0; s < n; s++) {
+					const auto d = static_cast<double>(src[s]);
+					std::memcpy(p + 8 * s, &d, 8);
+					trackPeak(s, std::abs(d));
+				}
+				break;
+			}
+
+			commit(n);
+			i += n;
+		}
+		return (err == SF_ERR_NO_ERROR) ? count : 0;
+	}
+
+	// write() : write count left-justified integer samples (as per sf_write_int()). Returns number of samples written
+	sf_count_t write(const int* data, sf_count_t count)
+	{
+		const int subFormat = format & SF_FORMAT_SUBMASK;
+		for (sf_count_t i = 0; i < count && err == SF_ERR_NO_ERROR; ) {
+			const auto n = static_cast<sf_count_t>(std::min<int64_t>(count - i, (bufferSize - bufferUsed) / bytesPerSample));
+			uint8_t* p = buffer + bufferUsed;
+			const int* src = data + i;
+
+			switch (subFormat) {
+			case SF_FORMAT_PCM_U8:
+				for (sf_count_t s = 0; s < n; s++) {
+					p[s] = static_cast<uint8_t>((src[s] >> 24) + 128);
+				}
+				break;
+			case SF_FORMAT_PCM_S8:
+				for (sf_count_t s = 0; s < n; s++) {
+					p[s] = static_cast<uint8_t>(src[s] >> 24);
+				}
+				break;
+			case SF_FORMAT_PCM_16:
+				for (sf_count_t s = 0; s < n; s++) {
+					putLE(p + 2 * s, static_cast<uint32_t>(src[s] >> 16), 2);
+				}
+				break;
+			case SF_FORMAT_PCM_24:
+				for (sf_count_t s = 0; s < n; s++) {
+					putLE(p + 3 * s, static_cast<uint32_t>(src[s] >> 8), 3);
+				}
+				break;
+			case SF_FORMAT_PCM_32:
+				for (sf_count_t s = 0; s < n; s++) {
+					putLE(p + 4 * s, static_cast<uint32_t>(src[s]), 4);
+				}
+				break;
+			case SF_FORMAT_FLOAT:
+				for (sf_count_t s = 0; s < n; s++) {
+					const float f = static_cast<float>(src[s]) * static_cast<float>(1.0 / 0x80000000);
+					std::memcpy(p + 4 * s, &f, 4);
+					trackPeak(s, std::abs(f));
+				}
+				break;
+			case SF_FORMAT_DOUBLE:
+				for (sf_count_t s = 0; s < n; s++) {
+					const double d = static_cast<double>(src[s]) * (1.0 / 0x80000000);
+					std::memcpy(p + 8 * s, &d, 8);
+					trackPeak(s, std::abs(d));
+				}
+				break;
+			}
+
+			commit(n);
+			i += n;
+		}
+		return (err == SF_ERR_NO_ERROR) ? count : 0;
+	}
+
+	// seek() : set write position (in frames). Only SEEK_SET is supported (eg for re-writing the file from the start), and not when streaming
+	sf_count_t seek(sf_count_t frames, int whence)
+	{
+		if (streaming || whence != SEEK_SET || frames < 0 || !flush()) {
+			return -1;
+		}
+		writePos = frames * nChannels * bytesPerSample;
+		samplesWritten = frames * nChannels;
+		if (frames == 0) {
+			std::fill(peaks.begin(), peaks.end(), Peak{});
+		}
+		return frames;
+	}
+
+	// close() : flush remaining samples, patch header, and trim preallocated space. Returns false on error
+	bool close()
+	{
+		if (!isOpen()) {
+			return err == SF_ERR_NO_ERROR;
+		}
+
+		if (flush() && !streaming) {
+			const int64_t dataBytes = dataEnd;
+			const std::vector<uint8_t> header = makeHeader(dataBytes);
+			const uint8_t padding[8] {};
+			const int64_t padBytes = paddingFor(dataBytes);
+			if (writeAt(0, header.data(), header.size()) && writeAt(dataOffset + dataBytes, padding, static_cast<size_t>(padBytes))) {
+				truncate(dataOffset + dataBytes + padBytes);
+			}
+		}
+		closeFile();
+		return err == SF_ERR_NO_ERROR;
+	}
+
+private:
+	static constexpr size_t pageSize = 4096;
+
+	struct Peak
+	{
+		double value{0.0};
+		int64_t position{0};
+	};
+
+	int format;
+	int nChannels;
+	int sampleRate;
+	int bytesPerSample{2};
+	bool isFloat{false};
+	bool hasPeakChunk{false};
+	bool streaming{false};
+	int err{SF_ERR_NO_ERROR};
+
+	uint8_t* buffer{nullptr};
+	size_t bufferSize{0};
+	size_t bufferUsed{0};
+	int64_t dataOffset{0};	// file offset of first sample
+	int64_t writePos{0};	// (data-relative) file offset of start of buffer
+	int64_t dataEnd{0};		// largest number of data bytes written so far
+	int64_t samplesWritten{0};
+	std::vector<Peak> peaks;
+
+#if defined (_WIN32) || defined (_WIN64)
+	std::FILE* file{nullptr};
+#else
+	int fd{-1};
+#endif
+
+	void trackPeak(sf_count_t s, double value)
+	{
+		if (hasPeakChunk) {
+			const int64_t sample = samplesWritten + s;
+			Peak& peak = peaks[static_cast<size_t>(sample % nChannels)];
+			if (value > peak.value) {
+				peak.value = value;
+				peak.position = sample / nChannels;
+			}
+		}
+	}
+
+	// commit() : account for n samples placed in buffer, and flush buffer if full
+	void commit(sf_count_t n)
+	{
+		bufferUsed += static_cast<size_t>(n * bytesPerSample);
+		samplesWritten += n;
+		if (bufferUsed == bufferSize) {
+			flush();
+		}
+	}
+
+	bool flush()
+	{
+		if (err != SF_ERR_NO_ERROR) {
+			return false;
+		}
+		if (bufferUsed > 0) {
+			if (!writeAt(dataOffset + writePos, buffer, bufferUsed)) {
+				return false;
+			}
+			writePos += static_cast<int64_t>(bufferUsed);
+			dataEnd = std::max(dataEnd, writePos);
+			bufferUsed = 0;
+		}
+		return true;
+	}
+
+	// header construction
+
+	int64_t paddingFor(int64_t dataBytes) const
+	{
+		const int majorFormat = format & SF_FORMAT_TYPEMASK;
+		return (majorFormat == SF_FORMAT_W64) ? (-dataBytes & 7) : (majorFormat == SF_FORMAT_RAW) ? 0 : (dataBytes & 1);
+	}
+
+	std::vector<uint8_t> makeHeader(int64_t dataBytes = 0) const
+	{
+		const int subFormat = format & SF_FORMAT_SUBMASK;
+		const int64_t frames = dataBytes / (nChannels * bytesPerSample);
+		const int blockAlign = nChannels * bytesPerSample;
+		const int formatTag = isFloat ? 3 : 1;
+		const int bits = (subFormat == SF_FORMAT_PCM_U8) ? 8 : 8 * bytesPerSample;
+
+		std::vector<uint8_t> fmt;
+		putLE(fmt, static_cast<uint32_t>(formatTag), 2);
+		putLE(fmt, static_cast<uint32_t>(nChannels), 2);
+		putLE(fmt, static_cast<uint32_t>(sampleRate), 4);
+		putLE(fmt, static_cast<uint32_t>(sampleRate * blockAlign), 4);
+		putLE(fmt, static_cast<uint32_t>(blockAlign), 2);
+		putLE(fmt, static_cast<uint32_t>(bits), 2);
+		if (isFloat) {
+			putLE(fmt, 0, 2); // cbSize
+		}
+
+		std::vector<uint8_t> h;
+		if ((format & SF_FORMAT_TYPEMASK) == SF_FORMAT_RAW) {
+			return h;
+		}
+
+		if ((format & SF_FORMAT_TYPEMASK) == SF_FORMAT_W64) {
+			putGuid(h, "riff");
+			putLE(h, 0, 8); // (file size: filled-in below)
+			putGuid(h, "wave");
+			putGuid(h, "fmt ");
+			putLE(h, 24 + fmt.size(), 8);
+			h.insert(h.end(), fmt.begin(), fmt.end());
+			h.resize((h.size() + 7) & ~size_t(7), 0);
+			if (isFloat) {
+				putGuid(h, "fact");
+				putLE(h, 24 + 8, 8);
+				putLE(h, static_cast<uint64_t>(frames), 8);
+			}
+			// (no junk chunk for page alignment: libsndfile doesn't skip w64 junk chunks correctly)
+			putGuid(h, "data");
+			putLE(h, static_cast<uint64_t>(24 + dataBytes), 8);
+			putLE(h.data() + 16, static_cast<uint64_t>(h.size() + dataBytes + paddingFor(dataBytes)), 8);
+			return h;
+		}
+
+		const bool rf64 = (format & SF_FORMAT_TYPEMASK) == SF_FORMAT_RF64;
+		put(h, rf64 ? "RF64" : "RIFF");
+		putLE(h, 0xFFFFFFFF, 4); // (riff size: filled-in below)
+		put(h, "WAVE");
+		if (rf64) {
+			put(h, "ds64");
+			putLE(h, 28, 4);
+			putLE(h, 0, 8); // (riff size: filled-in below)
+			putLE(h, static_cast<uint64_t>(dataBytes), 8);
+			putLE(h, static_cast<uint64_t>(frames), 8);
+			putLE(h, 0, 4); // table length
+		}
+		put(h, "fmt ");
+		putLE(h, fmt.size(), 4);
+		h.insert(h.end(), fmt.begin(), fmt.end());
+		if (isFloat) {
+			put(h, "fact");
+			putLE(h, 4, 4);
+			putLE(h, (rf64 || streaming) ? 0xFFFFFFFF : static_cast<uint32_t>(frames), 4);
+		}
+		if (hasPeakChunk) {
+			put(h, "PEAK");
+			putLE(h, static_cast<uint32_t>(8 + 8 * nChannels), 4);
+			putLE(h, 1, 4); // version
+			putLE(h, static_cast<uint32_t>(std::time(nullptr)), 4);
+			for (const Peak& peak : peaks) {
+				const auto value = static_cast<float>(peak.value);
+				uint32_t u;
+				std::memcpy(&u, &value, 4);
+				putLE(h, u, 4);
+				putLE(h, static_cast<uint32_t>(peak.position), 4);
+			}
+		}
+		if (streaming) { // (length unknown)
+			put(h, "data");
+			putLE(h, 0xFFFFFFFF, 4);
+			return h;
+		}
+		const size_t junkSize = junkFor(h.size() + 8 + 8, 8);
+		put(h, "JUNK");
+		putLE(h, junkSize - 8, 4);
+		h.resize(h.size() + junkSize - 8, 0);
+		put(h, "data");
+		putLE(h, rf64 ? 0xFFFFFFFF : static_cast<uint32_t>(dataBytes), 4);
+		const auto riffSize = static_cast<uint64_t>(h.size() - 8 + dataBytes + paddingFor(dataBytes));
+		if (rf64) {
+			putLE(h.data() + 20, riffSize, 8);
+		} else {
+			putLE(h.data() + 4, static_cast<uint32_t>(riffSize), 4);
+		}
+		return h;
+	}
+
+	// junkFor() : size of junk chunk (including its header), to bring headerSize up to a multiple of page size
+	static size_t junkFor(size_t headerSize, size_t minimum)
+	{
+		size_t junk = (pageSize - headerSize % pageSize) % pageSize;
+		return junk + minimum;
+	}
+
+	static void put(std::vector<uint8_t>& v, const char* id)
+	{
+		v.insert(v.end(), id, id + 4);
+	}
+
+	static void putGuid(std::vector<uint8_t>& v, const char* id)
+	{
+		static const uint8_t riffTail[12] {0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00};
+		static const uint8_t waveTail[12] {0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A};
+		put(v, id);
+		const uint8_t* tail = (std::memcmp(id, "riff", 4) == 0) ? riffTail : waveTail;
+		v.insert(v.end(), tail, tail + 12);
+	}
+
+	static void putLE(std::vector<uint8_t>& v, uint64_t value, int bytes)
+	{
+		for (int b = 0; b < bytes; b++) {
+			v.push_back(static_cast<uint8_t>(value >> (8 * b)));
+		}
+	}
+
+	static void putLE(uint8_t* p, uint64_t value, int bytes)
+	{
+		for (int b = 0; b < bytes; b++) {
+			p[b] = static_cast<uint8_t>(value >> (8 * b));
+		}
+	}
+
+	// file i/o
+
+#if defined (_WIN32) || defined (_WIN64)
+
+	bool openFile(const std::string& path)
+	{
+		if (streaming) {
+			std::fflush(stdout);
+			_setmode(_fileno(stdout), _O_BINARY);
+			file = stdout;
+		} else {
+			file = std::fopen(path.c_str(), "w+b");
+		}
+		return file != nullptr;
+	}
+
+	bool isOpen() const
+	{
+		return file != nullptr;
+	}
+
+	bool writeAt(int64_t offset, const void* data, size_t bytes)
+	{
+		if (bytes > 0 && ((!streaming && _fseeki64(file, offset, SEEK_SET) != 0) || std::fwrite(data, 1, bytes, file) != bytes)) {
+			err = SF_ERR_SYSTEM;
+			return false;
+		}
+		return true;
+	}
+
+	void preallocate(int64_t size)
+	{
+		(void)size;
+	}
+
+	void truncate(int64_t size)
+	{
+		std::fflush(file);
+		_chsize_s(_fileno(file), size);
+	}
+
+	void closeFile()
+	{
+		if ((streaming ? std::fflush(file) : std::fclose(file)) != 0) {
+			err = SF_ERR_SYSTEM;
+		}
+		file = nullptr;
+	}
+
+#else
+
+	bool openFile(const std::string& path)
+	{
+		if (streaming) {
+			std::fflush(stdout);
+			fd = STDOUT_FILENO;
+		} else {
+			fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+		}
+		return fd >= 0;
+	}
+
+	bool isOpen() const
+	{
+		return fd >= 0;
+	}
+
+	bool writeAt(int64_t offset, const void* data, size_t bytes)
+	{
+		auto p = static_cast<const uint8_t*>(data);
+		while (bytes > 0) {
+			ssize_t written = streaming ? ::write(fd, p, bytes) : pwrite(fd, p, bytes, static_cast<off_t>(offset));
+			if (written <= 0) {
+				err = SF_ERR_SYSTEM;
+				return false;
+			}
+			p += written;
+			offset += written;
+			bytes -= static_cast<size_t>(written);
+		}
+		return true;
+	}
+
+	void preallocate(int64_t size)
+	{
+#if defined (__linux__)
+		posix_fallocate(fd, 0, static_cast<off_t>(size)); // (not an error if unsupported by file system)
+#else
+		(void)size;
+#endif
+	}
+
+	void truncate(int64_t size)
+	{
+		if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+			err = SF_ERR_SYSTEM;
+		}
+	}
+
+	void closeFile()
+	{
+		if (!streaming && ::close(fd) != 0) {
+			err = SF_ERR_SYSTEM;
+		}
+		fd = -1;
+	}
+
+#endif
+};
+
+} // namespace ReSampler
+
+#endif // PCMWRITER_H
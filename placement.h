@@ -0,0 +1,222 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// placement.h : CPU / NUMA node placement of threads and memory (--pinThreads, --showPlacement)
+
+// On multi-socket machines, memory is attached to one NUMA node (socket), and is slower to reach from the CPUs of another.
+// These functions pin threads to CPUs, place memory on a node (mbind, preferred policy, moving any pages already present),
+// and report where threads and memory actually are. They use system calls directly (no libnuma), and do nothing except on Linux.
+
+#ifndef PLACEMENT_H
+#define PLACEMENT_H 1
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined (__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ReSampler {
+namespace Placement {
+
+using MemoryRegion = std::pair<const void*, size_t>; // (address, size in bytes)
+
+// getCpuNode() : NUMA node of cpu (0 if not known)
+inline int getCpuNode(int cpu)
+{
+	std::error_code ec;
+	for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/cpu/cpu" + std::to_string(cpu), ec)) {
+		const std::string name = entry.path().filename().string();
+		if (name.size() > 4 && name.compare(0, 4, "node") == 0 && std::isdigit(static_cast<unsigned char>(name[4]))) {
+			return std::atoi(name.c_str() + 4);
+		}
+	}
+	return 0;
+}
+
+// getNumNodes() : number of NUMA nodes (1 if not known)
+inline int getNumNodes()
+{
+	int n = 0;
+	std::error_code ec;
+	for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+		const std::string name = entry.path().filename().string();
+		if (name.size() > 4 && name.compare(0, 4, "node") == 0 && std::isdigit(static_cast<unsigned char>(name[4]))) {
+			n++;
+		}
+	}
+	return std::max(n, 1);
+}
+
+// getWorkerCpus() : CPUs which this process may run on, in the order in which workers should be pinned to them:
+// alternating between NUMA nodes, so that workers (and their memory) are spread across all nodes' CPUs and memory bandwidth
+inline std::vector<int> getWorkerCpus()
+{
+	std::vector<std::vector<int>> nodeCpus;
+#if defined (__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &set)) {
+				const auto node = static_cast<size_t>(getCpuNode(cpu));
+				if (node >= nodeCpus.size()) {
+					nodeCpus.resize(node + 1);
+				}
+				nodeCpus[node].push_back(cpu);
+			}
+		}
+	}
+#endif
+	std::vector<int> cpus;
+	for (size_t i = 0; ; i++) {
+		bool more = false;
+		for (const auto& c : nodeCpus) {
+			if (i < c.size()) {
+				cpus.push_back(c[i]);
+				more = true;
+			}
+		}
+		if (!more) {
+			break;
+		}
+	}
+	return cpus;
+}
+
+inline thread_local int pinnedCpu = -1; // (CPU to which pinThread() last pinned this thread; -1: not pinned)
+
+// pinThread() : restrict calling thread to cpu. Returns true if successful
+inline bool pinThread(int cpu)
+{
+#if defined (__linux__)
+	if (cpu == pinnedCpu) {
+		return true;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) == 0) { // (0: calling thread)
+		pinnedCpu = cpu;
+		return true;
+	}
+#else
+	(void)cpu;
+#endif
+	return false;
+}
+
+// AffinityGuard : restores the CPU affinity of the calling thread (as it was on construction) on destruction
+class AffinityGuard
+{
+public:
+	AffinityGuard()
+	{
+#if defined (__linux__)
+		CPU_ZERO(&saved);
+		valid = (sched_getaffinity(0, sizeof(saved), &saved) == 0);
+#endif
+	}
+
+	~AffinityGuard()
+	{
+#if defined (__linux__)
+		if (valid && pinnedCpu >= 0) {
+			sched_setaffinity(0, sizeof(saved), &saved);
+			pinnedCpu = -1;
+		}
+#endif
+	}
+
+	AffinityGuard(const AffinityGuard&) = delete;
+	AffinityGuard& operator=(const AffinityGuard&) = delete;
+
+private:
+#if defined (__linux__)
+	cpu_set_t saved;
+	bool valid{false};
+#endif
+};
+
+// getCurrentCpu() : CPU (and its node) on which calling thread is running. Returns false if not known
+inline bool getCurrentCpu(int& cpu, int& node)
+{
+#if defined (__linux__) && defined (SYS_getcpu)
+	unsigned c = 0;
+	unsigned n = 0;
+	if (syscall(SYS_getcpu, &c, &n, nullptr) == 0) {
+		cpu = static_cast<int>(c);
+		node = static_cast<int>(n);
+		return true;
+	}
+#endif
+	cpu = -1;
+	node = -1;
+	return false;
+}
+
+// bindToNode() : set preferred node of the whole pages within [p, p + bytes), moving any which are already elsewhere
+inline bool bindToNode(void* p, size_t bytes, int node)
+{
+#if defined (__linux__) && defined (SYS_mbind)
+	const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+	const uintptr_t first = (reinterpret_cast<uintptr_t>(p) + pageSize - 1) & ~(pageSize - 1);
+	const uintptr_t end = (reinterpret_cast<uintptr_t>(p) + bytes) & ~(pageSize - 1);
+	if (end <= first || node < 0 || node >= 1024) {
+		return false;
+	}
+	unsigned long nodeMask[1024 / (8 * sizeof(unsigned long))] = {};
+	nodeMask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+	const int mpolPreferred = 1;
+	const unsigned mpolMfMove = 1 << 1;
+	return syscall(SYS_mbind, first, end - first, mpolPreferred, nodeMask, 8 * sizeof(nodeMask) + 1, mpolMfMove) == 0;
+#else
+	(void)p; (void)bytes; (void)node;
+	return false;
+#endif
+}
+
+// getPageNodes() : count the pages within [p, p + bytes) on each node (index: node; last element: pages not present or not known)
+inline void getPageNodes(const void* p, size_t bytes, std::vector<size_t>& counts, int numNodes)
+{
+	counts.resize(static_cast<size_t>(numNodes) + 1, 0);
+#if defined (__linux__) && defined (SYS_move_pages)
+	const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+	const uintptr_t first = reinterpret_cast<uintptr_t>(p) & ~(pageSize - 1);
+	const uintptr_t end = reinterpret_cast<uintptr_t>(p) + bytes;
+	std::vector<void*> pages;
+	for (uintptr_t page = first; page < end; page += pageSize) {
+		pages.push_back(reinterpret_cast<void*>(page));
+	}
+	std::vector<int> status(pages.size(), -1);
+	if (!pages.empty() && syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) == 0) { // (nodes == nullptr: query only)
+		for (int s : status) {
+			counts[(s >= 0 && s < numNodes) ? static_cast<size_t>(s) : static_cast<size_t>(numNodes)]++;
+		}
+		return;
+	}
+	counts[static_cast<size_t>(numNodes)] += pages.size();
+#else
+	(void)p; (void)bytes;
+#endif
+}
+
+} // namespace Placement
+} // namespace ReSampler
+
+#endif // PLACEMENT_H
@@ -12,6 +12,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <chrono>
 
 // class RaiiTimer : starts a high-resolution timer upon construction and prints elapsed time to stdout upon destruction
@@ -35,9 +36,9 @@ public:
 		std::cout << "Time=" << duration << " ms";
 		if (msComparison != 0.0) {
 			double relativeSpeed = msComparison / duration;
-			auto ss = std::cout.precision();
-			std::cout << " [" << std::setprecision(1) << relativeSpeed << "x]" << std::setprecision(
-							 static_cast<int>(ss));
+			std::ostringstream speed; // (std::cout's format state is shared with other threads: leave it alone)
+			speed << " [" << std::fixed << std::setprecision(1) << relativeSpeed << "x]";
+			std::cout << speed.str();
 		}
 		std::cout << "\n" << std::endl;
 	}
@@ -0,0 +1,386 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// resampler_c.cpp : implementation of C interface (see resampler_c.h)
+
+#include "resampler_c.h"
+#include "resamplerstream.h"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+
+struct rs_resampler
+{
+	std::unique_ptr<ReSampler::ResamplerStream<float>> streamF;
+	std::unique_ptr<ReSampler::ResamplerStream<double>> streamD;
+};
+
+namespace {
+
+template<typename FloatType>
+ReSampler::ResamplerStream<FloatType>* getStream(rs_resampler* rs);
+
+template<>
+ReSampler::ResamplerStream<float>* getStream<float>(rs_resampler* rs)
+{
+	return rs == nullptr ? nullptr : rs->streamF.get();
+}
+
+template<>
+ReSampler::ResamplerStream<double>* getStream<double>(rs_resampler* rs)
+{
+	return rs == nullptr ? nullptr : rs->streamD.get();
+}
+
+// checkHandle() : RS_OK if rs has a stream of the requested precision
+template<typename FloatType>
+int checkHandle(rs_resampler* rs)
+{
+	if (rs == nullptr) {
+		return RS_ERR_INVALID_ARGUMENT;
+	}
+	return getStream<FloatType>(rs) == nullptr ? RS_ERR_WRONG_PRECISION : RS_OK;
+}
+
+void setResult(const ReSampler::ProcessResult& result, size_t* in_used, size_t* out_frames)
+{
+	if (in_used != nullptr) {
+		*in_used = result.inputFrames;
+	}
+	if (out_frames != nullptr) {
+		*out_frames = result.outputFrames;
+	}
+}
+
+template<typename FloatType>
+int process(rs_resampler* rs, const FloatType* in, size_t in_frames, size_t* in_used, FloatType* out, size_t out_capacity, size_t* out_frames)
+{
+	setResult({}, in_used, out_frames);
+	const int err = checkHandle<FloatType>(rs);
+	if (err != RS_OK) {
+		return err;
+	}
+	if ((in == nullptr && in_frames != 0) || (out == nullptr && out_capacity != 0)) {
+		return RS_ERR_INVALID_ARGUMENT;
+	}
+	setResult(getStream<FloatType>(rs)->process(in, in_frames, out, out_capacity), in_used, out_frames);
+	return RS_OK;
+}
+
+template<typename FloatType>
+int processPlanar(rs_resampler* rs, const FloatType* const* in, size_t in_frames, size_t* in_used, FloatType* const* out, size_t out_capacity, size_t* out_frames)
+{
+	setResult({}, in_used, out_frames);
+	const int err = checkHandle<FloatType>(rs);
+	if (err != RS_OK) {
+		return err;
+	}
+	if ((in == nullptr && in_frames != 0) || (out == nullptr && out_capacity != 0)) {
+		return RS_ERR_INVALID_ARGUMENT;
+	}
+	setResult(getStream<FloatType>(rs)->processPlanar(in, in_frames, out, out_capacity), in_used, out_frames);
+	return RS_OK;
+}
+
+template<typename FloatType>
+int flush(rs_resampler* rs, FloatType* out, size_t out_capacity, size_t* out_frames)
+{
+	setResult({}, nullptr, out_frames);
+	const int err = checkHandle<FloatType>(rs);
+	if (err != RS_OK) {
+		return err;
+	}
+	if (out == nullptr && out_capacity != 0) {
+		return RS_ERR_INVALID_ARGUMENT;
+	}
+	setResult(getStream<FloatType>(rs)->flush(out, out_capacity), nullptr, out_frames);
+	return RS_OK;
+}
+
+template<typename FloatType>
+int flushPlanar(rs_resampler* rs, FloatType* const* out, size_t out_capacity, size_t* out_frames)
+{
+	setResult({}, nullptr, out_frames);
+	const int err = checkHandle<FloatType>(rs);
+	if (err != RS_OK) {
+		return err;
+	}
+	if (out == nullptr && out_capacity != 0) {
+		return RS_ERR_INVALID_ARGUMENT;
+	}
+	setResult(getStream<FloatType>(rs)->flushPlanar(out, out_capacity), nullptr, out_frames);
+	return RS_OK;
+}
+
+// query() : call f with whichever stream the handle holds
+template<typename Result, typename Func>
+Result query(const rs_resampler* rs, Result fallback, Func f)
+{
+	if (rs == nullptr) {
+		return fallback;
+	}
+	if (rs->streamD) {
+		return f(*rs->streamD);
+	}
+	return rs->streamF ? f(*rs->streamF) : fallback;
+}
+
+// size of version 1 of rs_params (which ended with double_precision)
+constexpr size_t rsParamsSizeV1 = (offsetof(rs_params, max_filter_length) + alignof(rs_params) - 1) / alignof(rs_params) * alignof(rs_params);
+
+// hasMember() : true if a caller's rs_params of the given size includes the member at offset
+constexpr bool hasMember(size_t structSize, size_t offset, size_t size)
+{
+	return structSize >= offset + size;
+}
+
+// initParams() : fill the first structSize bytes' worth of members of params (rsParamsSizeV1 or sizeof(rs_params)) with default values
+void initParams(rs_params* params, size_t structSize)
+{
+	if (params == nullptr) {
+		return;
+	}
+
+	const ReSampler::ResamplerStreamParams defaults;
+	params->struct_size = structSize;
+	params->input_sample_rate = defaults.inputSampleRate;
+	params->output_sample_rate = defaults.outputSampleRate;
+	params->channels = defaults.channels;
+	params->max_block_size = defaults.maxBlockSize;
+	params->gain = defaults.gain;
+	params->lpf_cutoff = defaults.lpfCutoff;
+	params->lpf_transition_width = defaults.lpfTransitionWidth;
+	params->min_phase = defaults.minPhase ? 1 : 0;
+	params->multi_stage = defaults.multiStage ? 1 : 0;
+	params->max_stages = defaults.maxStages;
+	params->delay_trim = defaults.delayTrim ? 1 : 0;
+	params->double_precision = 0;
+
+	// version 2:
+	if (hasMember(structSize, offsetof(rs_params, max_filter_length), sizeof(params->max_filter_length))) {
+		params->max_filter_length = defaults.maxFilterLength;
+	}
+	if (hasMember(structSize, offsetof(rs_params, low_latency), sizeof(params->low_latency))) {
+		params->low_latency = defaults.lowLatency ? 1 : 0;
+	}
+}
+
+} // namespace
+
+extern "C" {
+
+int rs_api_version(void)
+{
+	return RS_API_VERSION;
+}
+
+const char* rs_version_string(void)
+{
+	return ReSampler::strVersion.c_str();
+}
+
+const char* rs_strerror(int error)
+{
+	switch (error) {
+	case RS_OK:
+		return "no error";
+	case RS_ERR_INVALID_ARGUMENT:
+		return "invalid argument";
+	case RS_ERR_OUT_OF_MEMORY:
+		return "out of memory";
+	case RS_ERR_WRONG_PRECISION:
+		return "function does not match precision of resampler";
+	case RS_ERR_INTERNAL:
+		return "internal error";
+	default:
+		return "unknown error";
+	}
+}
+
+#ifdef RS_SYMBOL_VERSIONING
+
+// rs_params_init@RESAMPLER_1 : for programs linked against version 1 of the library, whose rs_params has only version 1 members
+void rs_params_init_v1(rs_params* params)
+{
+	initParams(params, rsParamsSizeV1);
+}
+__asm__(".symver rs_params_init_v1, rs_params_init@RESAMPLER_1");
+
+// rs_params_init@@RESAMPLER_2 : (default for programs linked against this version)
+void rs_params_init_v2(rs_params* params)
+{
+	initParams(params, sizeof(rs_params));
+}
+__asm__(".symver rs_params_init_v2, rs_params_init@@RESAMPLER_2");
+
+#else
+
+void rs_params_init(rs_params* params)
+{
+	initParams(params, sizeof(rs_params));
+}
+
+#endif // RS_SYMBOL_VERSIONING
+
+rs_resampler* rs_create(const rs_params* params, int* error)
+{
+	auto fail = [error](int code) -> rs_resampler* {
+		if (error != nullptr) {
+			*error = code;
+		}
+		return nullptr;
+	};
+
+	if (params == nullptr || params->struct_size < rsParamsSizeV1) {
+		return fail(RS_ERR_INVALID_ARGUMENT);
+	}
+
+	// caller may have been compiled against an older (shorter) rs_params:
+	// only read the members it has (according to struct_size), and take defaults for the rest
+	rs_params p;
+	initParams(&p, sizeof(rs_params));
+	std::memcpy(&p, params, rsParamsSizeV1);
+	p.struct_size = sizeof(rs_params);
+	if (hasMember(params->struct_size, offsetof(rs_params, max_filter_length), sizeof(p.max_filter_length))) {
+		p.max_filter_length = params->max_filter_length;
+	}
+	if (hasMember(params->struct_size, offsetof(rs_params, low_latency), sizeof(p.low_latency))) {
+		p.low_latency = params->low_latency;
+	}
+
+	if (p.input_sample_rate <= 0 || p.output_sample_rate <= 0 ||
+		p.channels <= 0 || p.max_block_size == 0 ||
+		p.lpf_cutoff <= 0.0 || p.lpf_cutoff > 99.9 ||
+		p.lpf_transition_width <= 0.0 ||
+		p.max_stages < 1 || p.max_stages > 10 ||
+		p.max_filter_length < 0) {
+		return fail(RS_ERR_INVALID_ARGUMENT);
+	}
+
+	ReSampler::ResamplerStreamParams streamParams;
+	streamParams.inputSampleRate = p.input_sample_rate;
+	streamParams.outputSampleRate = p.output_sample_rate;
+	streamParams.channels = p.channels;
+	streamParams.maxBlockSize = p.max_block_size;
+	streamParams.gain = p.gain;
+	streamParams.lpfCutoff = p.lpf_cutoff;
+	streamParams.lpfTransitionWidth = p.lpf_transition_width;
+	streamParams.minPhase = (p.min_phase != 0);
+	streamParams.multiStage = (p.multi_stage != 0);
+	streamParams.maxStages = p.max_stages;
+	streamParams.delayTrim = (p.delay_trim != 0);
+	streamParams.maxFilterLength = p.max_filter_length;
+	streamParams.lowLatency = (p.low_latency != 0);
+
+	// (exceptions must not cross the C interface)
+	try {
+		auto rs = std::make_unique<rs_resampler>();
+		if (p.double_precision != 0) {
+			rs->streamD = std::make_unique<ReSampler::ResamplerStream<double>>(streamParams);
+		} else {
+			rs->streamF = std::make_unique<ReSampler::ResamplerStream<float>>(streamParams);
+		}
+		if (error != nullptr) {
+			*error = RS_OK;
+		}
+		return rs.release();
+	} catch (const std::bad_alloc&) {
+		return fail(RS_ERR_OUT_OF_MEMORY);
+	} catch (...) {
+		return fail(RS_ERR_INTERNAL);
+	}
+}
+
+void rs_destroy(rs_resampler* rs)
+{
+	delete rs;
+}
+
+int rs_process_f32(rs_resampler* rs, const float* in, size_t in_frames, size_t* in_used, float* out, size_t out_capacity, size_t* out_frames)
+{
+	return process<float>(rs, in, in_frames, in_used, out, out_capacity, out_frames);
+}
+
+int rs_process_f64(rs_resampler* rs, const double* in, size_t in_frames, size_t* in_used, double* out, size_t out_capacity, size_t* out_frames)
+{
+	return process<double>(rs, in, in_frames, in_used, out, out_capacity, out_frames);
+}
+
+int rs_process_planar_f32(rs_resampler* rs, const float* const* in, size_t in_frames, size_t* in_used, float* const* out, size_t out_capacity, size_t* out_frames)
+{
+	return processPlanar<float>(rs, in, in_frames, in_used, out, out_capacity, out_frames);
+}
+
+int rs_process_planar_f64(rs_resampler* rs, const double* const* in, size_t in_frames, size_t* in_used, double* const* out, size_t out_capacity, size_t* out_frames)
+{
+	return processPlanar<double>(rs, in, in_frames, in_used, out, out_capacity, out_frames);
+}
+
+int rs_flush_f32(rs_resampler* rs, float* out, size_t out_capacity, size_t* out_frames)
+{
+	return flush<float>(rs, out, out_capacity, out_frames);
+}
+
+int rs_flush_f64(rs_resampler* rs, double* out, size_t out_capacity, size_t* out_frames)
+{
+	return flush<double>(rs, out, out_capacity, out_frames);
+}
+
+int rs_flush_planar_f32(rs_resampler* rs, float* const* out, size_t out_capacity, size_t* out_frames)
+{
+	return flushPlanar<float>(rs, out, out_capacity, out_frames);
+}
+
+int rs_flush_planar_f64(rs_resampler* rs, double* const* out, size_t out_capacity, size_t* out_frames)
+{
+	return flushPlanar<double>(rs, out, out_capacity, out_frames);
+}
+
+int rs_reset(rs_resampler* rs)
+{
+	if (rs == nullptr) {
+		return RS_ERR_INVALID_ARGUMENT;
+	}
+	if (rs->streamD) {
+		rs->streamD->reset();
+	}
+	if (rs->streamF) {
+		rs->streamF->reset();
+	}
+	return RS_OK;
+}
+
+size_t rs_get_latency(const rs_resampler* rs)
+{
+	return query<size_t>(rs, 0, [](const auto& stream) { return stream.getLatency(); });
+}
+
+double rs_get_group_delay(const rs_resampler* rs)
+{
+	return query<double>(rs, 0.0, [](const auto& stream) { return stream.getGroupDelay(); });
+}
+
+double rs_get_algorithmic_latency(const rs_resampler* rs)
+{
+	return query<double>(rs, 0.0, [](const auto& stream) { return stream.getAlgorithmicLatency(); });
+}
+
+size_t rs_get_max_output_frames(const rs_resampler* rs, size_t in_frames)
+{
+	return query<size_t>(rs, 0, [in_frames](const auto& stream) { return stream.getMaxOutputFrames(in_frames); });
+}
+
+int rs_get_channels(const rs_resampler* rs)
+{
+	return query<int>(rs, 0, [](const auto& stream) { return stream.getChannels(); });
+}
+
+} // extern "C"
@@ -0,0 +1,133 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+/* resampler_c.h : C interface to the streaming conversion engine (ResamplerStream) in ReSamplerLib */
+
+/* The resampler is accessed through an opaque handle, created by rs_create() and released by rs_destroy().
+   Each handle is either single-precision (use the _f32 functions) or double-precision (use the _f64 functions),
+   according to rs_params.double_precision. All memory is allocated by rs_create().
+   A handle may be used from any thread, but not from more than one thread at a time.
+
+   Binary compatibility: each exported symbol carries the version tag of the interface version which introduced it
+   (RESAMPLER_1, RESAMPLER_2 ... see resampler_c.map).
+   New members of rs_params are only ever appended, and rs_params.struct_size tells the library
+   which version of the struct the caller was compiled against. Always initialize rs_params with rs_params_init(). */
+
+#ifndef RESAMPLER_C_H
+#define RESAMPLER_C_H 1
+
+#include <stddef.h>
+
+#if defined(_WIN32) && defined(RS_BUILD_DLL)
+#define RS_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define RS_API __attribute__((visibility("default")))
+#else
+#define RS_API
+#endif
+
+#define RS_API_VERSION 2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct rs_resampler rs_resampler;
+
+typedef struct rs_params
+{
+	size_t struct_size; /* set by rs_params_init() */
+	int input_sample_rate;
+	int output_sample_rate;
+	int channels;
+	size_t max_block_size; /* largest number of input frames converted at a time (larger blocks are split up internally) */
+	double gain; /* linear gain */
+	double lpf_cutoff; /* percentage of nyquist frequency */
+	double lpf_transition_width; /* percentage of nyquist frequency */
+	int min_phase; /* non-zero: minimum-phase filters */
+	int multi_stage; /* non-zero: multi-stage conversion */
+	int max_stages;
+	int delay_trim; /* non-zero: drop the group delay from the start of the output */
+	int double_precision; /* non-zero: use _f64 functions, otherwise _f32 */
+
+	/* version 2: */
+	int max_filter_length; /* upper limit on length of each stage's FIR filter (0: no limit) */
+	int low_latency; /* non-zero: real-time mode - minimum-phase filters, no delay-trimming (overrides min_phase and delay_trim) */
+} rs_params;
+
+enum rs_error
+{
+	RS_OK = 0,
+	RS_ERR_INVALID_ARGUMENT = -1,
+	RS_ERR_OUT_OF_MEMORY = -2,
+	RS_ERR_WRONG_PRECISION = -3, /* eg rs_process_f32() on a double-precision handle */
+	RS_ERR_INTERNAL = -4
+};
+
+/* rs_api_version() : version of the C interface implemented by the library (RS_API_VERSION) */
+RS_API int rs_api_version(void);
+
+/* rs_version_string() : ReSampler version string */
+RS_API const char* rs_version_string(void);
+
+/* rs_strerror() : description of an rs_error code */
+RS_API const char* rs_strerror(int error);
+
+/* rs_params_init() : fill params with default values (44.1kHz -> 48kHz stereo, single precision, not low-latency).
+   (Programs linked against version 1 get rs_params_init@RESAMPLER_1, which only initializes the version 1 members) */
+RS_API void rs_params_init(rs_params* params);
+
+/* rs_create() : create a resampler. Returns NULL on failure (in which case *error, if not NULL, receives the reason) */
+RS_API rs_resampler* rs_create(const rs_params* params, int* error);
+
+/* rs_destroy() : release a resampler (NULL is ignored) */
+RS_API void rs_destroy(rs_resampler* rs);
+
+/* rs_process_f32() / rs_process_f64() : convert interleaved audio.
+   Consumes up to in_frames of input, and writes up to out_capacity frames of output.
+   The number of frames actually consumed and produced are written to *in_used and *out_frames.
+   An output buffer of rs_get_max_output_frames(in_frames) frames guarantees that all input is consumed. */
+RS_API int rs_process_f32(rs_resampler* rs, const float* in, size_t in_frames, size_t* in_used, float* out, size_t out_capacity, size_t* out_frames);
+RS_API int rs_process_f64(rs_resampler* rs, const double* in, size_t in_frames, size_t* in_used, double* out, size_t out_capacity, size_t* out_frames);
+
+/* rs_process_planar_f32() / rs_process_planar_f64() : convert planar audio (in and out are arrays of one buffer per channel) */
+RS_API int rs_process_planar_f32(rs_resampler* rs, const float* const* in, size_t in_frames, size_t* in_used, float* const* out, size_t out_capacity, size_t* out_frames);
+RS_API int rs_process_planar_f64(rs_resampler* rs, const double* const* in, size_t in_frames, size_t* in_used, double* const* out, size_t out_capacity, size_t* out_frames);
+
+/* rs_flush_f32() / rs_flush_f64() : at end of input, retrieve remaining (delayed) output.
+   Call repeatedly until *out_frames is zero. */
+RS_API int rs_flush_f32(rs_resampler* rs, float* out, size_t out_capacity, size_t* out_frames);
+RS_API int rs_flush_f64(rs_resampler* rs, double* out, size_t out_capacity, size_t* out_frames);
+RS_API int rs_flush_planar_f32(rs_resampler* rs, float* const* out, size_t out_capacity, size_t* out_frames);
+RS_API int rs_flush_planar_f64(rs_resampler* rs, double* const* out, size_t out_capacity, size_t* out_frames);
+
+/* rs_reset() : clear all state, ready for a new stream */
+RS_API int rs_reset(rs_resampler* rs);
+
+/* rs_get_latency() : number of input frames by which output lags input */
+RS_API size_t rs_get_latency(const rs_resampler* rs);
+
+/* rs_get_group_delay() : group delay of the filters, in output frames */
+RS_API double rs_get_group_delay(const rs_resampler* rs);
+
+/* rs_get_algorithmic_latency() : delay between an input frame and the corresponding output frame, due to the filters (in output frames).
+   For minimum-phase filters, this is the position of the impulse response peak. (version 2) */
+RS_API double rs_get_algorithmic_latency(const rs_resampler* rs);
+
+/* rs_get_max_output_frames() : output buffer size (in frames) sufficient to consume in_frames of input in one call */
+RS_API size_t rs_get_max_output_frames(const rs_resampler* rs, size_t in_frames);
+
+/* rs_get_channels() : number of channels */
+RS_API int rs_get_channels(const rs_resampler* rs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RESAMPLER_C_H */
@@ -0,0 +1,317 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// resamplerstream.h : defines ResamplerStream class, for embedding the conversion engine in other applications.
+
+// Audio is pushed through process() (interleaved) or processPlanar() (one buffer per channel), in blocks of any size.
+// All memory is allocated by the constructor: process(), processPlanar(), flush() and reset() do no allocation,
+// and nothing is written to the console or to files.
+// Output is scaled the same way as the command-line converter's (unity gain, with no clipping protection or dither).
+
+// Usage:
+// 1. construct from a ResamplerStreamParams
+// 2. call process() / processPlanar() for each block of input
+// 3. at end of input, call flush() repeatedly until it returns 0 output frames
+// 4. call reset() before re-using the object for another stream
+
+// Low-latency (real-time) use:
+// set lowLatency (minimum-phase filters, no delay-trimming) and a small maxBlockSize (eg 64 - 512 frames),
+// and optionally limit the filter length with maxFilterLength. Each call to process() with a full block then produces
+// a steady amount of output, and the delay between input and output is getAlgorithmicLatency() output frames
+// (plus whatever buffering the host does - typically one block).
+
+#ifndef RESAMPLERSTREAM_H
+#define RESAMPLERSTREAM_H 1
+
+#include "srconvert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace ReSampler {
+
+struct ResamplerStreamParams
+{
+	int inputSampleRate{44100};
+	int outputSampleRate{48000};
+	int channels{2};
+	size_t maxBlockSize{4096}; // largest number of input frames converted at a time (larger blocks are split up internally)
+	double gain{1.0};
+	double lpfCutoff{100.0 * (10.0 / 11.0)}; // (percentage of nyquist frequency)
+	double lpfTransitionWidth{100.0 - lpfCutoff}; // (percentage of nyquist frequency)
+	bool minPhase{false};
+	bool multiStage{true};
+	int maxStages{3};
+	bool delayTrim{true}; // drop the group delay from start of output (so that output is aligned in time with input)
+	int maxFilterLength{0}; // upper limit on length of each stage's FIR filter (0: no limit)
+	bool lowLatency{false}; // real-time mode: minimum-phase filters, with no delay-trimming (overrides minPhase and delayTrim)
+	bool asrc{false}; // asynchronous conversion: ratio may be adjusted continuously with setRatioCorrection() (see asrc.h)
+};
+
+// ProcessResult : number of input frames consumed, and output frames produced, by a call to process(), processPlanar() or flush()
+struct ProcessResult
+{
+	size_t inputFrames{0};
+	size_t outputFrames{0};
+};
+
+template <typename FloatType>
+class ResamplerStream
+{
+public:
+	explicit ResamplerStream(const ResamplerStreamParams& streamParams)
+		: params(streamParams),
+		  nChannels(std::max(1, streamParams.channels)),
+		  blockSize(std::max<size_t>(1, streamParams.maxBlockSize))
+	{
+		if (params.lowLatency) {
+			params.minPhase = true;
+			params.delayTrim = false;
+		}
+
+		ConversionInfo ci{};
+		ci.inputSampleRate = params.inputSampleRate;
+		ci.outputSampleRate = params.outputSampleRate;
+		ci.lpfMode = custom;
+		ci.lpfCutoff = params.lpfCutoff;
+		ci.lpfTransitionWidth = params.lpfTransitionWidth;
+		ci.bMinPhase = params.minPhase;
+		ci.bMultiStage = params.multiStage;
+		ci.bSingleStage = !params.multiStage;
+		ci.maxStages = std::max(1, std::min(params.maxStages, 10));
+		ci.bDelayTrim = true; // (so that the converter reports its group delay. Trimming is done here, according to params.delayTrim)
+		ci.overSamplingFactor = 1;
+		ci.blockSize = static_cast<int>(blockSize);
+		ci.maxFilterLength = (params.maxFilterLength > 0) ? std::max(15, params.maxFilterLength) : 0;
+		ci.bAsrc = params.asrc;
+
+		converters.reserve(static_cast<size_t>(nChannels));
+		converters.emplace_back(ci);
+		for (int ch = 1; ch < nChannels; ch++) {
+			converters.push_back(converters[0]); // (copy, rather than designing the same filters again)
+		}
+
+		const Fraction fraction = getFractionFromSamplerates(params.inputSampleRate, params.outputSampleRate);
+		gain = static_cast<FloatType>(params.gain * converters[0].getGain() * fraction.numerator);
+		groupDelay = converters[0].getGroupDelay();
+		algorithmicLatency = converters[0].getLatency();
+		latency = static_cast<size_t>(std::ceil(groupDelay * params.inputSampleRate / params.outputSampleRate));
+		maxOutputBlockSize = converters[0].getMaxOutputSize(blockSize);
+
+		inputBuffers.assign(static_cast<size_t>(nChannels), std::vector<FloatType>(blockSize, 0.0));
+		outputBuffers.assign(static_cast<size_t>(nChannels), std::vector<FloatType>(maxOutputBlockSize, 0.0));
+		reset();
+	}
+
+	// process() : convert interleaved input. outCapacity is the size of the output buffer in frames.
+	// If outCapacity is less than getMaxOutputFrames(inFrames), not all of the input may be consumed
+	ProcessResult process(const FloatType* in, size_t inFrames, FloatType* out, size_t outCapacity)
+	{
+		return run(inFrames, outCapacity, [&](size_t offset, size_t frames) {
+			for (int ch = 0; ch < nChannels; ch++) {
+				FloatType* dest = inputBuffers[ch].data();
+				const FloatType* src = in + offset * nChannels + ch;
+				for (size_t f = 0; f < frames; f++) {
+					dest[f] = src[f * nChannels];
+				}
+			}
+		}, [&](size_t offset, size_t first, size_t frames) {
+			for (int ch = 0; ch < nChannels; ch++) {
+				const FloatType* src = outputBuffers[ch].data() + first;
+				FloatType* dest = out + offset * nChannels + ch;
+				for (size_t f = 0; f < frames; f++) {
+					dest[f * nChannels] = gain * src[f];
+				}
+			}
+		});
+	}
+
+	// processPlanar() : convert planar input (in and out are arrays of one buffer per channel)
+	ProcessResult processPlanar(const FloatType* const* in, size_t inFrames, FloatType* const* out, size_t outCapacity)
+	{
+		return run(inFrames, outCapacity, [&](size_t offset, size_t frames) {
+			for (int ch = 0; ch < nChannels; ch++) {
+				std::copy_n(in[ch] + offset, frames, inputBuffers[ch].data());
+			}
+		}, [&](size_t offset, size_t first, size_t frames) {
+			for (int ch = 0; ch < nChannels; ch++) {
+				const FloatType* src = outputBuffers[ch].data() + first;
+				FloatType* dest = out[ch] + offset;
+				for (size_t f = 0; f < frames; f++) {
+					dest[f] = gain * src[f];
+				}
+			}
+		});
+	}
+
+	// flush() : at end of input, retrieve the remaining (delayed) output, by feeding silence through the filters.
+	// Call repeatedly until the number of output frames is zero. (inputFrames of result is always zero)
+	ProcessResult flush(FloatType* out, size_t outCapacity)
+	{
+		return flushTail(outCapacity, [&](size_t offset, size_t first, size_t frames) {
+			for (int ch = 0; ch < nChannels; ch++) {
+				const FloatType* src = outputBuffers[ch].data() + first;
+				FloatType* dest = out + offset * nChannels + ch;
+				for (size_t f = 0; f < frames; f++) {
+					dest[f * nChannels] = gain * src[f];
+				}
+			}
+		});
+	}
+
+	// flushPlanar() : planar version of flush()
+	ProcessResult flushPlanar(FloatType* const* out, size_t outCapacity)
+	{
+		return flushTail(outCapacity, [&](size_t offset, size_t first, size_t frames) {
+			for (int ch = 0; ch < nChannels; ch++) {
+				const FloatType* src = outputBuffers[ch].data() + first;
+				FloatType* dest = out[ch] + offset;
+				for (size_t f = 0; f < frames; f++) {
+					dest[f] = gain * src[f];
+				}
+			}
+		});
+	}
+
+	// setRatioCorrection() : (asynchronous conversion only) adjust conversion ratio to follow drift of input clock,
+	// eg with a value from DriftTracker. correction is actual / nominal input rate (1.0: no drift)
+	void setRatioCorrection(double correction)
+	{
+		for (auto& converter : converters) {
+			converter.setRatioCorrection(correction);
+		}
+	}
+
+	// reset() : clear all state, ready for a new stream
+	void reset()
+	{
+		for (auto& converter : converters) {
+			converter.reset();
+		}
+		skipRemaining = params.delayTrim ? static_cast<size_t>(groupDelay) : 0;
+		tailRemaining = params.delayTrim ? latency : 0;
+		pendingFrames = 0;
+		pendingStart = 0;
+	}
+
+	// getGroupDelay() : group delay of the filters, in output frames (zero for minimum-phase filters).
+	// When params.delayTrim is set, this amount is dropped from the start of the output
+	double getGroupDelay() const
+	{
+		return groupDelay;
+	}
+
+	// getLatency() : number of input frames by which output lags input (ie number of input frames of silence fed in by flush())
+	size_t getLatency() const
+	{
+		return latency;
+	}
+
+	// getAlgorithmicLatency() : delay (in output frames) between an input frame and the corresponding output, due to the filters.
+	// For linear-phase filters, this is the group delay. For minimum-phase filters, it is the position of the impulse response peak.
+	// (This does not depend on delay-trimming, which only drops the start of the output)
+	double getAlgorithmicLatency() const
+	{
+		return algorithmicLatency;
+	}
+
+	// getMaxOutputFrames() : output buffer size (in frames) which guarantees that process() will consume all of inFrames
+	size_t getMaxOutputFrames(size_t inFrames) const
+	{
+		const size_t blocks = (inFrames + blockSize - 1) / blockSize;
+		return pendingFrames + blocks * maxOutputBlockSize;
+	}
+
+	int getChannels() const
+	{
+		return nChannels;
+	}
+
+private:
+	ResamplerStreamParams params;
+	int nChannels;
+	size_t blockSize;
+	size_t maxOutputBlockSize;
+	FloatType gain;
+	double groupDelay;
+	double algorithmicLatency;
+	size_t latency;
+	std::vector<Converter<FloatType>> converters;
+	std::vector<std::vector<FloatType>> inputBuffers;
+	std::vector<std::vector<FloatType>> outputBuffers;
+
+	// state:
+	size_t skipRemaining{0};	// output frames still to be dropped (delay trim)
+	size_t tailRemaining{0};	// input frames of silence still to be fed in by flush()
+	size_t pendingFrames{0};	// converted frames in outputBuffers, not yet delivered (due to insufficient output capacity)
+	size_t pendingStart{0};
+
+	// deliver() : deliver pending output, up to outCapacity frames. Returns number of frames delivered
+	template <typename WriteFunc>
+	size_t deliver(size_t offset, size_t outCapacity, WriteFunc write)
+	{
+		const size_t frames = std::min(pendingFrames, outCapacity - offset);
+		if (frames > 0) {
+			write(offset, pendingStart, frames);
+			pendingStart += frames;
+			pendingFrames -= frames;
+		}
+		return frames;
+	}
+
+	// convertBlock() : convert frames of input (already in inputBuffers), leaving result pending in outputBuffers
+	void convertBlock(size_t frames)
+	{
+		size_t outFrames = 0;
+		for (int ch = 0; ch < nChannels; ch++) {
+			converters[ch].convert(outputBuffers[ch].data(), outFrames, inputBuffers[ch].data(), frames);
+		}
+		const size_t skip = std::min(skipRemaining, outFrames);
+		skipRemaining -= skip;
+		pendingStart = skip;
+		pendingFrames = outFrames - skip;
+	}
+
+	template <typename ReadFunc, typename WriteFunc>
+	ProcessResult run(size_t inFrames, size_t outCapacity, ReadFunc read, WriteFunc write)
+	{
+		ProcessResult result;
+		result.outputFrames = deliver(0, outCapacity, write);
+		while (pendingFrames == 0 && result.inputFrames < inFrames) {
+			const size_t frames = std::min(blockSize, inFrames - result.inputFrames);
+			read(result.inputFrames, frames);
+			convertBlock(frames);
+			result.inputFrames += frames;
+			result.outputFrames += deliver(result.outputFrames, outCapacity, write);
+		}
+		return result;
+	}
+
+	template <typename WriteFunc>
+	ProcessResult flushTail(size_t outCapacity, WriteFunc write)
+	{
+		ProcessResult result;
+		result.outputFrames = deliver(0, outCapacity, write);
+		while (pendingFrames == 0 && tailRemaining > 0) {
+			const size_t frames = std::min(blockSize, tailRemaining);
+			for (auto& buffer : inputBuffers) {
+				std::fill_n(buffer.begin(), frames, static_cast<FloatType>(0.0));
+			}
+			convertBlock(frames);
+			tailRemaining -= frames;
+			result.outputFrames += deliver(result.outputFrames, outCapacity, write);
+		}
+		return result;
+	}
+};
+
+} // namespace ReSampler
+
+#endif // RESAMPLERSTREAM_H
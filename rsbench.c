@@ -0,0 +1,135 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+/* rsbench.c : benchmark for the C interface of ReSamplerLib (also serves as an example of its use)
+
+   usage: rsbench [inputRate] [outputRate] [channels] [seconds] [blockFrames] [f32|f64]
+   (defaults: 44100 48000 2 60 4096 f32)
+
+   Converts the given number of seconds of a test tone, one block at a time, and reports throughput. */
+
+#include "resampler_c.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void)
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+	rs_params params;
+	rs_params_init(&params);
+	params.input_sample_rate = argc > 1 ? atoi(argv[1]) : 44100;
+	params.output_sample_rate = argc > 2 ? atoi(argv[2]) : 48000;
+	params.channels = argc > 3 ? atoi(argv[3]) : 2;
+	double seconds = argc > 4 ? atof(argv[4]) : 60.0;
+	size_t blockFrames = argc > 5 ? (size_t)atol(argv[5]) : 4096;
+	params.double_precision = (argc > 6 && strcmp(argv[6], "f64") == 0);
+	params.max_block_size = blockFrames;
+
+	if (params.channels <= 0 || blockFrames == 0 || seconds <= 0.0) {
+		fprintf(stderr, "usage: rsbench [inputRate] [outputRate] [channels] [seconds] [blockFrames] [f32|f64]\n");
+		return 1;
+	}
+
+	printf("ReSampler %s (C interface version %d)\n", rs_version_string(), rs_api_version());
+
+	double t0 = now();
+	int err = RS_OK;
+	rs_resampler* rs = rs_create(&params, &err);
+	if (rs == NULL) {
+		fprintf(stderr, "rs_create() failed: %s\n", rs_strerror(err));
+		return 1;
+	}
+	double tCreate = now() - t0;
+
+	size_t channels = (size_t)params.channels;
+	size_t outCapacity = rs_get_max_output_frames(rs, blockFrames);
+	size_t sampleSize = params.double_precision ? sizeof(double) : sizeof(float);
+	void* in = malloc(blockFrames * channels * sampleSize);
+	void* out = malloc(outCapacity * channels * sampleSize);
+	if (in == NULL || out == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	/* fill input block with a 1kHz tone (the same block is used repeatedly) */
+	for (size_t f = 0; f < blockFrames; f++) {
+		double v = 0.5 * sin(2.0 * 3.14159265358979323846 * 1000.0 * f / params.input_sample_rate);
+		for (size_t ch = 0; ch < channels; ch++) {
+			if (params.double_precision) {
+				((double*)in)[f * channels + ch] = v;
+			} else {
+				((float*)in)[f * channels + ch] = (float)v;
+			}
+		}
+	}
+
+	size_t totalIn = (size_t)(seconds * params.input_sample_rate);
+	size_t inputDone = 0;
+	size_t outputDone = 0;
+	size_t blocks = 0;
+	double worstBlock = 0.0;
+
+	t0 = now();
+	while (inputDone < totalIn) {
+		size_t frames = totalIn - inputDone < blockFrames ? totalIn - inputDone : blockFrames;
+		size_t used = 0;
+		size_t produced = 0;
+		double tb = now();
+		err = params.double_precision ?
+			rs_process_f64(rs, (const double*)in, frames, &used, (double*)out, outCapacity, &produced) :
+			rs_process_f32(rs, (const float*)in, frames, &used, (float*)out, outCapacity, &produced);
+		tb = now() - tb;
+		if (err != RS_OK) {
+			fprintf(stderr, "rs_process() failed: %s\n", rs_strerror(err));
+			return 1;
+		}
+		if (tb > worstBlock) {
+			worstBlock = tb;
+		}
+		inputDone += used;
+		outputDone += produced;
+		blocks++;
+	}
+
+	for (;;) {
+		size_t produced = 0;
+		err = params.double_precision ?
+			rs_flush_f64(rs, (double*)out, outCapacity, &produced) :
+			rs_flush_f32(rs, (float*)out, outCapacity, &produced);
+		if (err != RS_OK || produced == 0) {
+			break;
+		}
+		outputDone += produced;
+	}
+	double elapsed = now() - t0;
+
+	printf("%d -> %d Hz, %d channel(s), %s precision, block size %zu frames\n",
+		   params.input_sample_rate, params.output_sample_rate, params.channels,
+		   params.double_precision ? "double" : "single", blockFrames);
+	printf("latency: %zu input frames (group delay %.1f output frames)\n", rs_get_latency(rs), rs_get_group_delay(rs));
+	printf("setup time: %.3f ms\n", tCreate * 1000.0);
+	printf("converted %zu -> %zu frames in %.3f s (%.1fx realtime, %.2f Mframes/s)\n",
+		   inputDone, outputDone, elapsed, seconds / elapsed, inputDone / elapsed * 1e-6);
+	printf("mean block time: %.1f us, worst block time: %.1f us\n", elapsed / (double)blocks * 1e6, worstBlock * 1e6);
+
+	free(in);
+	free(out);
+	rs_destroy(rs);
+	return 0;
+}
@@ -0,0 +1,162 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+/* rsclient.c : thin client for ReSampler's server mode (ReSampler --server)
+
+   usage: rsclient [--socket <path>] <ReSampler options>
+   eg:    rsclient -i input.wav -o output.wav -r 44100 -b 16
+
+   Sends the options (and the current directory, against which relative filenames are resolved) to the server,
+   relays the server's messages to stdout as they arrive, and exits with the conversion's exit code.
+   Socket: --socket <path>, or $RESAMPLER_SOCKET, or resampler.sock in $XDG_RUNTIME_DIR (or /tmp) - as for the server.
+   If no server is running, ReSampler is run directly instead (with the same options), so that scripts work either way. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* appendJsonString() : append s to buffer (growing it as necessary), as a quoted JSON string */
+static void appendJsonString(char** buffer, size_t* length, size_t* capacity, const char* s)
+{
+	size_t needed = *length + 6 * strlen(s) + 3;
+	if (needed > *capacity) {
+		*capacity = 2 * needed;
+		*buffer = (char*)realloc(*buffer, *capacity);
+		if (*buffer == NULL) {
+			fprintf(stderr, "rsclient: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	char* p = *buffer + *length;
+	*p++ = '"';
+	for (; *s != '\0'; s++) {
+		unsigned char c = (unsigned char)*s;
+		if (c == '"' || c == '\\') {
+			*p++ = '\\';
+			*p++ = (char)c;
+		} else if (c < 0x20) {
+			p += sprintf(p, "\\u%04x", c);
+		} else {
+			*p++ = (char)c;
+		}
+	}
+	*p++ = '"';
+	*p = '\0';
+	*length = (size_t)(p - *buffer);
+}
+
+static void appendText(char** buffer, size_t* length, size_t* capacity, const char* s)
+{
+	size_t n = strlen(s);
+	if (*length + n + 1 > *capacity) {
+		*capacity = 2 * (*length + n + 1);
+		*buffer = (char*)realloc(*buffer, *capacity);
+		if (*buffer == NULL) {
+			fprintf(stderr, "rsclient: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	memcpy(*buffer + *length, s, n + 1);
+	*length += n;
+}
+
+int main(int argc, char** argv)
+{
+	/* determine socket path */
+	char socketPath[sizeof(((struct sockaddr_un*)0)->sun_path)];
+	const char* env = getenv("RESAMPLER_SOCKET");
+	int firstArg = 1;
+	int pathLength;
+	if (argc > 2 && strcmp(argv[1], "--socket") == 0) {
+		pathLength = snprintf(socketPath, sizeof(socketPath), "%s", argv[2]);
+		firstArg = 3;
+	} else if (env != NULL && *env != '\0') {
+		pathLength = snprintf(socketPath, sizeof(socketPath), "%s", env);
+	} else {
+		env = getenv("XDG_RUNTIME_DIR");
+		pathLength = snprintf(socketPath, sizeof(socketPath), "%s/resampler.sock", (env != NULL && *env != '\0') ? env : "/tmp");
+	}
+	if (pathLength < 0 || (size_t)pathLength >= sizeof(socketPath)) { /* (truncated: would connect to the wrong socket) */
+		fprintf(stderr, "rsclient: socket path too long (maximum %zu characters)\n", sizeof(socketPath) - 1);
+		return EXIT_FAILURE;
+	}
+
+	/* connect (or run ReSampler directly, if there is no server) */
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	memcpy(address.sun_path, socketPath, (size_t)pathLength + 1);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		argv[firstArg - 1] = (char*)"ReSampler";
+		execvp("ReSampler", argv + firstArg - 1);
+		fprintf(stderr, "rsclient: no server listening on %s, and couldn't run ReSampler\n", socketPath);
+		return EXIT_FAILURE;
+	}
+
+	/* request: {"cwd": "...", "args": ["...", ...]} */
+	size_t length = 0;
+	size_t capacity = 0;
+	char* request = NULL;
+	char cwd[4096];
+	appendText(&request, &length, &capacity, "{\"cwd\": ");
+	appendJsonString(&request, &length, &capacity, (getcwd(cwd, sizeof(cwd)) != NULL) ? cwd : "");
+	appendText(&request, &length, &capacity, ", \"args\": [");
+	for (int i = firstArg; i < argc; i++) {
+		if (i > firstArg) {
+			appendText(&request, &length, &capacity, ", ");
+		}
+		appendJsonString(&request, &length, &capacity, argv[i]);
+	}
+	appendText(&request, &length, &capacity, "]}\n");
+
+	for (size_t sent = 0; sent < length;) {
+		ssize_t n = send(fd, request + sent, length - sent, 0);
+		if (n <= 0) {
+			fprintf(stderr, "rsclient: couldn't send request to %s\n", socketPath);
+			return EXIT_FAILURE;
+		}
+		sent += (size_t)n;
+	}
+	free(request);
+
+	/* relay messages until the terminating zero byte, which is followed by the exit code */
+	char buffer[4096];
+	char exitCode[16];
+	size_t exitCodeLength = 0;
+	int finished = 0;
+	ssize_t n;
+	while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+		for (ssize_t i = 0; i < n; i++) {
+			if (finished) {
+				if (exitCodeLength < sizeof(exitCode) - 1) {
+					exitCode[exitCodeLength++] = buffer[i];
+				}
+			} else if (buffer[i] == '\0') {
+				fwrite(buffer, 1, (size_t)i, stdout);
+				finished = 1;
+			}
+		}
+		if (!finished) {
+			fwrite(buffer, 1, (size_t)n, stdout);
+		}
+		fflush(stdout);
+	}
+	close(fd);
+
+	if (!finished) {
+		fprintf(stderr, "rsclient: connection to server lost\n");
+		return EXIT_FAILURE;
+	}
+	exitCode[exitCodeLength] = '\0';
+	return atoi(exitCode);
+}
@@ -0,0 +1,167 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+/* rsjitter.c : latency and jitter benchmark for low-latency (real-time) use of ReSamplerLib, via its C interface
+
+   usage: rsjitter [inputRate] [outputRate] [channels] [blockFrames] [seconds] [maxFilterLength] [f32|f64]
+   (defaults: 48000 44100 2 128 10 0 f32)
+
+   Converts a test tone in fixed-size blocks, as an audio callback would, timing every block.
+   Reports the latency of the conversion, the distribution of per-block processing times
+   (relative to the real-time deadline of one block), and the spread of output frames per block. */
+
+#include "resampler_c.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void)
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compareDoubles(const void* a, const void* b)
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+/* percentile() : value at given percentile of sorted array */
+static double percentile(const double* sorted, size_t count, double p)
+{
+	size_t i = (size_t)(p / 100.0 * (double)(count - 1) + 0.5);
+	return sorted[i < count ? i : count - 1];
+}
+
+int main(int argc, char** argv)
+{
+	rs_params params;
+	rs_params_init(&params);
+	params.input_sample_rate = argc > 1 ? atoi(argv[1]) : 48000;
+	params.output_sample_rate = argc > 2 ? atoi(argv[2]) : 44100;
+	params.channels = argc > 3 ? atoi(argv[3]) : 2;
+	size_t blockFrames = argc > 4 ? (size_t)atol(argv[4]) : 128;
+	double seconds = argc > 5 ? atof(argv[5]) : 10.0;
+	params.max_filter_length = argc > 6 ? atoi(argv[6]) : 0;
+	params.double_precision = (argc > 7 && strcmp(argv[7], "f64") == 0);
+	params.max_block_size = blockFrames;
+	params.low_latency = 1;
+
+	if (params.channels <= 0 || blockFrames == 0 || seconds <= 0.0 || params.input_sample_rate <= 0) {
+		fprintf(stderr, "usage: rsjitter [inputRate] [outputRate] [channels] [blockFrames] [seconds] [maxFilterLength] [f32|f64]\n");
+		return 1;
+	}
+
+	int err = RS_OK;
+	rs_resampler* rs = rs_create(&params, &err);
+	if (rs == NULL) {
+		fprintf(stderr, "rs_create() failed: %s\n", rs_strerror(err));
+		return 1;
+	}
+
+	size_t channels = (size_t)params.channels;
+	size_t outCapacity = rs_get_max_output_frames(rs, blockFrames);
+	size_t sampleSize = params.double_precision ? sizeof(double) : sizeof(float);
+	size_t numBlocks = (size_t)(seconds * params.input_sample_rate / (double)blockFrames);
+	if (numBlocks == 0) {
+		numBlocks = 1;
+	}
+
+	/* allocate everything up-front */
+	unsigned char* in = malloc(blockFrames * channels * sampleSize);
+	unsigned char* out = malloc(outCapacity * channels * sampleSize);
+	double* blockTimes = malloc(numBlocks * sizeof(double));
+	if (in == NULL || out == NULL || blockTimes == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	size_t minOut = (size_t)-1;
+	size_t maxOut = 0;
+	size_t phase = 0;
+	for (size_t b = 0; b < numBlocks; b++) {
+
+		/* next block of a 997Hz tone */
+		for (size_t f = 0; f < blockFrames; f++, phase++) {
+			double v = 0.5 * sin(2.0 * 3.14159265358979323846 * 997.0 * (double)phase / params.input_sample_rate);
+			for (size_t ch = 0; ch < channels; ch++) {
+				if (params.double_precision) {
+					((double*)in)[f * channels + ch] = v;
+				} else {
+					((float*)in)[f * channels + ch] = (float)v;
+				}
+			}
+		}
+
+		size_t used = 0;
+		size_t produced = 0;
+		double t = now();
+		err = params.double_precision ?
+			rs_process_f64(rs, (const double*)in, blockFrames, &used, (double*)out, outCapacity, &produced) :
+			rs_process_f32(rs, (const float*)in, blockFrames, &used, (float*)out, outCapacity, &produced);
+		blockTimes[b] = now() - t;
+
+		if (err != RS_OK || used != blockFrames) {
+			fprintf(stderr, "rs_process() failed: %s\n", rs_strerror(err));
+			return 1;
+		}
+		if (produced < minOut) {
+			minOut = produced;
+		}
+		if (produced > maxOut) {
+			maxOut = produced;
+		}
+	}
+
+	qsort(blockTimes, numBlocks, sizeof(double), compareDoubles);
+	double total = 0.0;
+	for (size_t b = 0; b < numBlocks; b++) {
+		total += blockTimes[b];
+	}
+
+	double deadline = (double)blockFrames / params.input_sample_rate;
+	size_t overruns = 0;
+	for (size_t b = 0; b < numBlocks; b++) {
+		overruns += (blockTimes[b] > deadline);
+	}
+
+	double algorithmicLatency = rs_get_algorithmic_latency(rs);
+	double algorithmicMs = algorithmicLatency * 1000.0 / params.output_sample_rate;
+	double blockMs = deadline * 1000.0;
+
+	printf("%d -> %d Hz, %d channel(s), %s precision, %zu frames per block, max filter length: %d\n",
+		   params.input_sample_rate, params.output_sample_rate, params.channels,
+		   params.double_precision ? "double" : "single", blockFrames, params.max_filter_length);
+	printf("latency: algorithmic %.2f output frames (%.3f ms) + one block %zu input frames (%.3f ms) = %.3f ms\n",
+		   algorithmicLatency, algorithmicMs, blockFrames, blockMs, algorithmicMs + blockMs);
+	printf("output frames per block: %zu .. %zu\n", minOut, maxOut);
+	printf("blocks: %zu, deadline: %.1f us per block\n", numBlocks, deadline * 1e6);
+	printf("block time (us): mean %.2f, median %.2f, p99 %.2f, p99.9 %.2f, max %.2f\n",
+		   total / (double)numBlocks * 1e6,
+		   percentile(blockTimes, numBlocks, 50.0) * 1e6,
+		   percentile(blockTimes, numBlocks, 99.0) * 1e6,
+		   percentile(blockTimes, numBlocks, 99.9) * 1e6,
+		   blockTimes[numBlocks - 1] * 1e6);
+	printf("worst case: %.1f%% of deadline, jitter (max - median): %.2f us, overruns: %zu\n",
+		   blockTimes[numBlocks - 1] / deadline * 100.0,
+		   (blockTimes[numBlocks - 1] - percentile(blockTimes, numBlocks, 50.0)) * 1e6,
+		   overruns);
+
+	free(in);
+	free(out);
+	free(blockTimes);
+	rs_destroy(rs);
+	return overruns == 0 ? 0 : 2;
+}
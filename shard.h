@@ -0,0 +1,57 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// shard.h : description of one part of a sharded conversion (--shard k/N), for merging the parts (--merge)
+
+// ShardInfo is recorded alongside each shard file (in <shard>.rsshard):
+// the conversion key (options, version and input length, which must be the same for every part), the part number,
+// and the range of frames of the whole output which the shard file holds.
+
+#ifndef SHARD_H
+#define SHARD_H 1
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace ReSampler {
+
+class ShardInfo
+{
+public:
+	std::string key;
+	int index{0}; // (1 ... count)
+	int count{0};
+	int64_t outputStart{0};
+	int64_t outputFrames{0};
+
+	static std::string infoFilename(const std::string& shardFilename)
+	{
+		return shardFilename + ".rsshard";
+	}
+
+	bool load(const std::string& shardFilename)
+	{
+		std::ifstream file(infoFilename(shardFilename));
+		std::string magic;
+		return (file >> magic >> key >> index >> count >> outputStart >> outputFrames) && magic == "ReSampler-shard-1" &&
+				count > 0 && index >= 1 && index <= count && outputStart >= 0 && outputFrames >= 0;
+	}
+
+	bool save(const std::string& shardFilename) const
+	{
+		std::ofstream file(infoFilename(shardFilename));
+		file << "ReSampler-shard-1 " << key << " " << index << " " << count << " " << outputStart << " " << outputFrames << "\n";
+		return static_cast<bool>(file);
+	}
+};
+
+} // namespace ReSampler
+
+#endif // SHARD_H
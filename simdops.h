@@ -0,0 +1,614 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// simdops.h : small vectorised helper functions for bulk operations on sample buffers
+// (max-abs scanning, decoding of integer samples, quantization, and conversion between interleaved and planar layouts),
+// with scalar fallbacks for non-SIMD builds
+
+#ifndef SIMDOPS_H
+#define SIMDOPS_H 1
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(_M_X64) || defined(__x86_64__) || defined(USE_SSE2))
+#define SIMDOPS_USE_SSE2 1
+#include <immintrin.h>
+#endif
+
+namespace ReSampler {
+namespace SimdOps {
+
+// maxAbs() : return largest absolute value in buffer (no alignment requirements)
+
+inline float maxAbs(const float* p, size_t n)
+{
+	size_t i = 0;
+	float m = 0.0f;
+
+#if defined(USE_AVX)
+	const __m256 signMask8 = _mm256_set1_ps(-0.0f);
+	__m256 m8 = _mm256_setzero_ps();
+	for (; i + 8 <= n; i += 8) {
+		m8 = _mm256_max_ps(m8, _mm256_andnot_ps(signMask8, _mm256_loadu_ps(p + i)));
+	}
+	alignas(32) float r8[8];
+	_mm256_store_ps(r8, m8);
+	for (float v : r8) {
+		m = std::max(m, v);
+	}
+#elif defined(SIMDOPS_USE_SSE2)
+	const __m128 signMask4 = _mm_set1_ps(-0.0f);
+	__m128 m4 = _mm_setzero_ps();
+	for (; i + 4 <= n; i += 4) {
+		m4 = _mm_max_ps(m4, _mm_andnot_ps(signMask4, _mm_loadu_ps(p + i)));
+	}
+	alignas(16) float r4[4];
+	_mm_store_ps(r4, m4);
+	for (float v : r4) {
+		m = std::max(m, v);
+	}
+#endif
+
+	for (; i < n; i++) {
+		m = std::max(m, std::abs(p[i]));
+	}
+	return m;
+}
+
+inline double maxAbs(const double* p, size_t n)
+{
+	size_t i = 0;
+	double m = 0.0;
+
+#if defined(USE_AVX)
+	const __m256d signMask4 = _mm256_set1_pd(-0.0);
+	__m256d m4 = _mm256_setzero_pd();
+	for (; i + 4 <= n; i += 4) {
+		m4 = _mm256_max_pd(m4, _mm256_andnot_pd(signMask4, _mm256_loadu_pd(p + i)));
+	}
+	alignas(32) double r4[4];
+	_mm256_store_pd(r4, m4);
+	for (double v : r4) {
+		m = std::max(m, v);
+	}
+#elif defined(SIMDOPS_USE_SSE2)
+	const __m128d signMask2 = _mm_set1_pd(-0.0);
+	__m128d m2 = _mm_setzero_pd();
+	for (; i + 2 <= n; i += 2) {
+		m2 = _mm_max_pd(m2, _mm_andnot_pd(signMask2, _mm_loadu_pd(p + i)));
+	}
+	alignas(16) double r2[2];
+	_mm_store_pd(r2, m2);
+	for (double v : r2) {
+		m = std::max(m, v);
+	}
+#endif
+
+	for (; i < n; i++) {
+		m = std::max(m, std::abs(p[i]));
+	}
+	return m;
+}
+
+// decodeInt16() : convert little-endian 16-bit ints to floating-point, with scaling
+// decodeInt24() : convert packed little-endian 24-bit ints to floating-point, with scaling
+// decodeInt32() : convert little-endian 32-bit ints to floating-point, with scaling
+// (source needn't be aligned. SIMD paths assume a little-endian host)
+
+inline void decodeInt16(const uint8_t* in, float* out, size_t n, float scale)
+{
+	size_t i = 0;
+#ifdef SIMDOPS_USE_SSE2
+	const __m128 s4 = _mm_set1_ps(scale);
+	for (; i + 8 <= n; i += 8) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); // sign-extend
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), s4));
+		_mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s4));
+	}
+#endif
+	for (; i < n; i++) {
+		int16_t v;
+		std::memcpy(&v, in + 2 * i, 2);
+		out[i] = static_cast<float>(v) * scale;
+	}
+}
+
+inline void decodeInt16(const uint8_t* in, double* out, size_t n, double scale)
+{
+	size_t i = 0;
+#ifdef SIMDOPS_USE_SSE2
+	const __m128d s2 = _mm_set1_pd(scale);
+	for (; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + 2 * i));
+		__m128i v32 = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); // sign-extend
+		_mm_storeu_pd(out + i, _mm_mul_pd(_mm_cvtepi32_pd(v32), s2));
+		_mm_storeu_pd(out + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v32, 8)), s2));
+	}
+#endif
+	for (; i < n; i++) {
+		int16_t v;
+		std::memcpy(&v, in + 2 * i, 2);
+		out[i] = static_cast<double>(v) * scale;
+	}
+}
+
+namespace detail {
+
+#ifdef SIMDOPS_USE_SSE2
+// unpack24() : 4 packed 24-bit ints (the first 12 of 16 bytes loaded from p) to sign-extended 32-bit ints.
+// (shifting the whole register left by k + 1 bytes leaves sample k in the top 3 bytes of lane k)
+inline __m128i unpack24(const uint8_t* p)
+{
+	const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	const __m128i x = _mm_or_si128(
+				_mm_or_si128(_mm_and_si128(_mm_slli_si128(v, 1), _mm_setr_epi32(-1, 0, 0, 0)),
+							 _mm_and_si128(_mm_slli_si128(v, 2), _mm_setr_epi32(0, -1, 0, 0))),
+				_mm_or_si128(_mm_and_si128(_mm_slli_si128(v, 3), _mm_setr_epi32(0, 0, -1, 0)),
+							 _mm_and_si128(_mm_slli_si128(v, 4), _mm_setr_epi32(0, 0, 0, -1))));
+	return _mm_srai_epi32(x, 8); // sign-extend
+}
+#endif
+
+inline int32_t int24(const uint8_t* p)
+{
+	return static_cast<int32_t>((static_cast<uint32_t>(p[2]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[0]) << 8)) >> 8;
+}
+
+} // namespace detail
+
+inline void decodeInt24(const uint8_t* in, float* out, size_t n, float scale)
+{
+	size_t i = 0;
+#ifdef SIMDOPS_USE_SSE2
+	const __m128 s4 = _mm_set1_ps(scale);
+	for (; 3 * i + 16 <= 3 * n; i += 4) { // (each load reads 4 bytes beyond the 4 samples)
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(detail::unpack24(in + 3 * i)), s4));
+	}
+#endif
+	for (; i < n; i++) {
+		out[i] = static_cast<float>(detail::int24(in + 3 * i)) * scale;
+	}
+}
+
+inline void decodeInt24(const uint8_t* in, double* out, size_t n, double scale)
+{
+	size_t i = 0;
+#ifdef SIMDOPS_USE_SSE2
+	const __m128d s2 = _mm_set1_pd(scale);
+	for (; 3 * i + 16 <= 3 * n; i += 4) {
+		const __m128i v32 = detail::unpack24(in + 3 * i);
+		_mm_storeu_pd(out + i, _mm_mul_pd(_mm_cvtepi32_pd(v32), s2));
+		_mm_storeu_pd(out + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v32, 8)), s2));
+	}
+#endif
+	for (; i < n; i++) {
+		out[i] = static_cast<double>(detail::int24(in + 3 * i)) * scale;
+	}
+}
+
+inline void decodeInt32(const uint8_t* in, float* out, size_t n, float scale)
+{
+	size_t i = 0;
+#ifdef SIMDOPS_USE_SSE2
+	const __m128 s4 = _mm_set1_ps(scale);
+	for (; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4 * i));
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(v), s4));
+	}
+#endif
+	for (; i < n; i++) {
+		int32_t v;
+		std::memcpy(&v, in + 4 * i, 4);
+		out[i] = static_cast<float>(v) * scale;
+	}
+}
+
+inline void decodeInt32(const uint8_t* in, double* out, size_t n, double scale)
+{
+	size_t i = 0;
+#ifdef SIMDOPS_USE_SSE2
+	const __m128d s2 = _mm_set1_pd(scale);
+	for (; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4 * i));
+		_mm_storeu_pd(out + i, _mm_mul_pd(_mm_cvtepi32_pd(v), s2));
+		_mm_storeu_pd(out + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), s2));
+	}
+#endif
+	for (; i < n; i++) {
+		int32_t v;
+		std::memcpy(&v, in + 4 * i, 4);
+		out[i] = static_cast<double>(v) * scale;
+	}
+}
+
+// quantize() : multiply samples by gain, and round them to left-justified ints of the given bit depth (the undithered case of quantizeToInt()).
+// Returns largest absolute value of the samples after gain. (no alignment requirements)
+
+inline float quantize(const float* in, int32_t* out, size_t n, float gain, int bits)
+{
+	const auto shift = static_cast<uint32_t>(32 - bits);
+	const auto maxSignalMagnitude = static_cast<float>((1 << (bits - 1)) - 1);
+	size_t i = 0;
+	float m = 0.0f;
+
+#ifdef SIMDOPS_USE_SSE2
+	const __m128 signMask4 = _mm_set1_ps(-0.0f);
+	const __m128 g4 = _mm_set1_ps(gain);
+	const __m128 s4 = _mm_set1_ps(maxSignalMagnitude);
+	const __m128i shiftCount = _mm_cvtsi32_si128(static_cast<int>(shift));
+	__m128 m4 = _mm_setzero_ps();
+	for (; i + 4 <= n; i += 4) {
+		const __m128 v = _mm_mul_ps(g4, _mm_loadu_ps(in + i));
+		m4 = _mm_max_ps(m4, _mm_andnot_ps(signMask4, v));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_sll_epi32(_mm_cvtps_epi32(_mm_mul_ps(s4, v)), shiftCount)); // (rounds to nearest, like lrint)
+	}
+	alignas(16) float r4[4];
+	_mm_store_ps(r4, m4);
+	for (float v : r4) {
+		m = std::max(m, v);
+	}
+#endif
+
+	for (; i < n; i++) {
+		const float v = gain * in[i];
+		m = std::max(m, std::abs(v));
+		out[i] = static_cast<int32_t>(static_cast<uint32_t>(std::lrint(maxSignalMagnitude * v)) << shift);
+	}
+	return m;
+}
+
+inline double quantize(const double* in, int32_t* out, size_t n, double gain, int bits)
+{
+	const auto shift = static_cast<uint32_t>(32 - bits);
+	const auto maxSignalMagnitude = static_cast<double>((1 << (bits - 1)) - 1);
+	size_t i = 0;
+	double m = 0.0;
+
+#ifdef SIMDOPS_USE_SSE2
+	const __m128d signMask2 = _mm_set1_pd(-0.0);
+	const __m128d g2 = _mm_set1_pd(gain);
+	const __m128d s2 = _mm_set1_pd(maxSignalMagnitude);
+	const __m128i shiftCount = _mm_cvtsi32_si128(static_cast<int>(shift));
+	__m128d m2 = _mm_setzero_pd();
+	for (; i + 4 <= n; i += 4) {
+		const __m128d lo = _mm_mul_pd(g2, _mm_loadu_pd(in + i));
+		const __m128d hi = _mm_mul_pd(g2, _mm_loadu_pd(in + i + 2));
+		m2 = _mm_max_pd(m2, _mm_andnot_pd(signMask2, lo));
+		m2 = _mm_max_pd(m2, _mm_andnot_pd(signMask2, hi));
+		const __m128i q = _mm_unpacklo_epi64(_mm_cvtpd_epi32(_mm_mul_pd(s2, lo)), _mm_cvtpd_epi32(_mm_mul_pd(s2, hi)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_sll_epi32(q, shiftCount));
+	}
+	alignas(16) double r2[2];
+	_mm_store_pd(r2, m2);
+	for (double v : r2) {
+		m = std::max(m, v);
+	}
+#endif
+
+	for (; i < n; i++) {
+		const double v = gain * in[i];
+		m = std::max(m, std::abs(v));
+		out[i] = static_cast<int32_t>(static_cast<uint32_t>(std::lrint(maxSignalMagnitude * v)) << shift);
+	}
+	return m;
+}
+
+// deinterleave() : split frames of interleaved samples into separate channel buffers
+// interleave() : combine separate channel buffers into frames of interleaved samples
+// (1, 2, 6 and 8 channels have specialised versions)
+
+namespace detail {
+
+template<typename FloatType, int nChannels>
+inline void deinterleaveN(const FloatType* in, FloatType* const* out, size_t start, size_t frames)
+{
+	for (size_t f = start; f < frames; f++) {
+		for (int ch = 0; ch < nChannels; ch++) {
+			out[ch][f] = in[f * nChannels + ch];
+		}
+	}
+}
+
+template<typename FloatType, int nChannels>
+inline void interleaveN(const FloatType* const* in, FloatType* out, size_t start, size_t frames)
+{
+	for (size_t f = start; f < frames; f++) {
+		for (int ch = 0; ch < nChannels; ch++) {
+			out[f * nChannels + ch] = in[ch][f];
+		}
+	}
+}
+
+inline size_t deinterleave2(const float* in, float* const* out, size_t frames)
+{
+	size_t f = 0;
+#ifdef SIMDOPS_USE_SSE2
+	for (; f + 4 <= frames; f += 4) {
+		__m128 a = _mm_loadu_ps(in + 2 * f);     // L0 R0 L1 R1
+		__m128 b = _mm_loadu_ps(in + 2 * f + 4); // L2 R2 L3 R3
+		_mm_storeu_ps(out[0] + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(out[1] + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+#endif
+	return f;
+}
+
+inline size_t deinterleave2(const double* in, double* const* out, size_t frames)
+{
+	size_t f = 0;
+#ifdef SIMDOPS_USE_SSE2
+	for (; f + 2 <= frames; f += 2) {
+		__m128d a = _mm_loadu_pd(in + 2 * f);     // L0 R0
+		__m128d b = _mm_loadu_pd(in + 2 * f + 2); // L1 R1
+		_mm_storeu_pd(out[0] + f, _mm_unpacklo_pd(a, b));
+		_mm_storeu_pd(out[1] + f, _mm_unpackhi_pd(a, b));
+	}
+#endif
+	return f;
+}
+
+inline size_t interleave2(const float* const* in, float* out, size_t frames)
+{
+	size_t f = 0;
+#ifdef SIMDOPS_USE_SSE2
+	for (; f + 4 <= frames; f += 4) {
+		__m128 l = _mm_loadu_ps(in[0] + f);
+		__m128 r = _mm_loadu_ps(in[1] + f);
+		_mm_storeu_ps(out + 2 * f, _mm_unpacklo_ps(l, r));
+		_mm_storeu_ps(out + 2 * f + 4, _mm_unpackhi_ps(l, r));
+	}
+#endif
+	return f;
+}
+
+inline size_t interleave2(const double* const* in, double* out, size_t frames)
+{
+	size_t f = 0;
+#ifdef SIMDOPS_USE_SSE2
+	for (; f + 2 <= frames; f += 2) {
+		__m128d l = _mm_loadu_pd(in[0] + f);
+		__m128d r = _mm_loadu_pd(in[1] + f);
+		_mm_storeu_pd(out + 2 * f, _mm_unpacklo_pd(l, r));
+		_mm_storeu_pd(out + 2 * f + 2, _mm_unpackhi_pd(l, r));
+	}
+#endif
+	return f;
+}
+
+// 8-channel float versions : two 4x4 transposes per group of 4 frames
+
+inline size_t deinterleave8(const float* in, float* const* out, size_t frames)
+{
+	size_t f = 0;
+#ifdef SIMDOPS_USE_SSE2
+	for (; f + 4 <= frames; f += 4) {
+		const float* p = in + 8 * f;
+		for (int half = 0; half < 8; half += 4) {
+			__m128 r0 = _mm_loadu_ps(p + half);
+			__m128 r1 = _mm_loadu_ps(p + 8 + half);
+			__m128 r2 = _mm_loadu_ps(p + 16 + half);
+			__m128 r3 = _mm_loadu_ps(p + 24 + half);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(out[half] + f, r0);
+			_mm_storeu_ps(out[half + 1] + f, r1);
+			_mm_storeu_ps(out[half + 2] + f, r2);
+			_mm_storeu_ps(out[half + 3] + f, r3);
+		}
+	}
+#endif
+	return f;
+}
+
+// double versions (6 and 8 channels) : a 2x2 transpose for each pair of channels, per pair of frames
+
+template<int nChannels>
+inline size_t deinterleavePairs(const double* in, double* const* out, size_t frames)
+{
+	size_t f = 0;
+#ifdef SIMDOPS_USE_SSE2
+	for (; f + 2 <= frames; f += 2) {
+		const double* p = in + nChannels * f;
+		for (int ch = 0; ch < nChannels; ch += 2) {
+			__m128d a = _mm_loadu_pd(p + ch);             // frame 0: ch, ch + 1
+			__m128d b = _mm_loadu_pd(p + nChannels + ch); // frame 1: ch, ch + 1
+			_mm_storeu_pd(out[ch] + f, _mm_unpacklo_pd(a, b));
+			_mm_storeu_pd(out[ch + 1] + f, _mm_unpackhi_pd(a, b));
+		}
+	}
+#else
+	(void)in;
+	(void)out;
+#endif
+	return f;
+}
+
+template<int nChannels>
+inline size_t interleavePairs(const double* const* in, double* out, size_t frames)
+{
+	size_t f = 0;
+#ifdef SIMDOPS_USE_SSE2
+	for (; f + 2 <= frames; f += 2) {
+		double* p = out + nChannels * f;
+		for (int ch = 0; ch < nChannels; ch += 2) {
+			__m128d a = _mm_loadu_pd(in[ch] + f);
+			__m128d b = _mm_loadu_pd(in[ch + 1] + f);
+			_mm_storeu_pd(p + ch, _mm_unpacklo_pd(a, b));
+			_mm_storeu_pd(p + nChannels + ch, _mm_unpackhi_pd(a, b));
+		}
+	}
+#else
+	(void)in;
+	(void)out;
+#endif
+	return f;
+}
+
+inline size_t deinterleave8(const double* in, double* const* out, size_t frames)
+{
+	return deinterleavePairs<8>(in, out, frames);
+}
+
+inline size_t interleave8(const float* const* in, float* out, size_t frames)
+{
+	size_t f = 0;
+#ifdef SIMDOPS_USE_SSE2
+	for (; f + 4 <= frames; f += 4) {
+		float* p = out + 8 * f;
+		for (int half = 0; half < 8; half += 4) {
+			__m128 r0 = _mm_loadu_ps(in[half] + f);
+			__m128 r1 = _mm_loadu_ps(in[half + 1] + f);
+			__m128 r2 = _mm_loadu_ps(in[half + 2] + f);
+			__m128 r3 = _mm_loadu_ps(in[half + 3] + f);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(p + half, r0);
+			_mm_storeu_ps(p + 8 + half, r1);
+			_mm_storeu_ps(p + 16 + half, r2);
+			_mm_storeu_ps(p + 24 + half, r3);
+		}
+	}
+#endif
+	return f;
+}
+
+inline size_t interleave8(const double* const* in, double* out, size_t frames)
+{
+	return interleavePairs<8>(in, out, frames);
+}
+
+// 6-channel float versions : per group of 4 frames, a 4x4 transpose for channels 0-3, and another for channels 2-5
+// (of which only channels 4 and 5 are needed when de-interleaving; when interleaving, channels 2 and 3 are simply written twice)
+
+inline size_t deinterleave6(const float* in, float* const* out, size_t frames)
+{
+	size_t f = 0;
+#ifdef SIMDOPS_USE_SSE2
+	for (; f + 4 <= frames; f += 4) {
+		const float* p = in + 6 * f;
+		__m128 r0 = _mm_loadu_ps(p);
+		__m128 r1 = _mm_loadu_ps(p + 6);
+		__m128 r2 = _mm_loadu_ps(p + 12);
+		__m128 r3 = _mm_loadu_ps(p + 18);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(out[0] + f, r0);
+		_mm_storeu_ps(out[1] + f, r1);
+		_mm_storeu_ps(out[2] + f, r2);
+		_mm_storeu_ps(out[3] + f, r3);
+		r0 = _mm_loadu_ps(p + 2);
+		r1 = _mm_loadu_ps(p + 8);
+		r2 = _mm_loadu_ps(p + 14);
+		r3 = _mm_loadu_ps(p + 20);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(out[4] + f, r2);
+		_mm_storeu_ps(out[5] + f, r3);
+	}
+#endif
+	return f;
+}
+
+inline size_t deinterleave6(const double* in, double* const* out, size_t frames)
+{
+	return deinterleavePairs<6>(in, out, frames);
+}
+
+inline size_t interleave6(const float* const* in, float* out, size_t frames)
+{
+	size_t f = 0;
+#ifdef SIMDOPS_USE_SSE2
+	for (; f + 4 <= frames; f += 4) {
+		float* p = out + 6 * f;
+		__m128 r0 = _mm_loadu_ps(in[0] + f);
+		__m128 r1 = _mm_loadu_ps(in[1] + f);
+		__m128 r2 = _mm_loadu_ps(in[2] + f);
+		__m128 r3 = _mm_loadu_ps(in[3] + f);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(p, r0);
+		_mm_storeu_ps(p + 6, r1);
+		_mm_storeu_ps(p + 12, r2);
+		_mm_storeu_ps(p + 18, r3);
+		r0 = _mm_loadu_ps(in[2] + f);
+		r1 = _mm_loadu_ps(in[3] + f);
+		r2 = _mm_loadu_ps(in[4] + f);
+		r3 = _mm_loadu_ps(in[5] + f);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(p + 2, r0);
+		_mm_storeu_ps(p + 8, r1);
+		_mm_storeu_ps(p + 14, r2);
+		_mm_storeu_ps(p + 20, r3);
+	}
+#endif
+	return f;
+}
+
+inline size_t interleave6(const double* const* in, double* out, size_t frames)
+{
+	return interleavePairs<6>(in, out, frames);
+}
+
+} // namespace detail
+
+template<typename FloatType>
+inline void deinterleave(const FloatType* in, FloatType* const* out, int nChannels, size_t frames)
+{
+	switch (nChannels) {
+	case 1:
+		std::copy_n(in, frames, out[0]);
+		break;
+	case 2:
+		detail::deinterleaveN<FloatType, 2>(in, out, detail::deinterleave2(in, out, frames), frames);
+		break;
+	case 6:
+		detail::deinterleaveN<FloatType, 6>(in, out, detail::deinterleave6(in, out, frames), frames);
+		break;
+	case 8:
+		detail::deinterleaveN<FloatType, 8>(in, out, detail::deinterleave8(in, out, frames), frames);
+		break;
+	default:
+		for (size_t f = 0; f < frames; f++) {
+			for (int ch = 0; ch < nChannels; ch++) {
+				out[ch][f] = in[f * nChannels + ch];
+			}
+		}
+	}
+}
+
+template<typename FloatType>
+inline void interleave(const FloatType* const* in, FloatType* out, int nChannels, size_t frames)
+{
+	switch (nChannels) {
+	case 1:
+		std::copy_n(in[0], frames, out);
+		break;
+	case 2:
+		detail::interleaveN<FloatType, 2>(in, out, detail::interleave2(in, out, frames), frames);
+		break;
+	case 6:
+		detail::interleaveN<FloatType, 6>(in, out, detail::interleave6(in, out, frames), frames);
+		break;
+	case 8:
+		detail::interleaveN<FloatType, 8>(in, out, detail::interleave8(in, out, frames), frames);
+		break;
+	default:
+		for (size_t f = 0; f < frames; f++) {
+			for (int ch = 0; ch < nChannels; ch++) {
+				out[f * nChannels + ch] = in[ch][f];
+			}
+		}
+	}
+}
+
+} // namespace SimdOps
+} // namespace ReSampler
+
+#endif // SIMDOPS_H
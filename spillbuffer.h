@@ -0,0 +1,213 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// spillbuffer.h : defines SpillBuffer class, a raw (header-less) store for intermediate conversion results.
+
+// Samples are held in RAM (in fixed-size chunks) until a memory limit is reached,
+// after which everything is spilled to an anonymous temp file.
+// Usage: write() everything, then rewind() and read() it back (as many times as required).
+// read() is zero-copy: it hands back a pointer into either the RAM chunks, or a read-only memory-map of the temp file.
+
+#ifndef SPILLBUFFER_H
+#define SPILLBUFFER_H 1
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#if !defined (_WIN32) && !defined (_WIN64)
+#include <sys/mman.h>
+#include <unistd.h>
+#define SPILLBUFFER_USE_MMAP
+#endif
+
+namespace ReSampler {
+
+template <typename FloatType>
+class SpillBuffer
+{
+public:
+	SpillBuffer(int nChannels, size_t maxRamBytes)
+		: chunkSize(static_cast<size_t>(std::max(nChannels, 1)) * framesPerChunk),
+		  maxRamSamples(maxRamBytes / sizeof(FloatType))
+	{}
+
+	~SpillBuffer()
+	{
+		unmap();
+		if (file != nullptr) {
+			std::fclose(file);
+		}
+	}
+
+	SpillBuffer(const SpillBuffer&) = delete;
+	SpillBuffer& operator=(const SpillBuffer&) = delete;
+
+	// write() : append count samples. Returns false on error
+	bool write(const FloatType* data, int64_t count)
+	{
+		if (err || count <= 0) {
+			return !err;
+		}
+
+		if (file == nullptr && static_cast<size_t>(totalSamples + count) > maxRamSamples) {
+			if (!spill()) {
+				return false;
+			}
+		}
+
+		if (file != nullptr) {
+			if (std::fwrite(data, sizeof(FloatType), static_cast<size_t>(count), file) != static_cast<size_t>(count)) {
+				err = true;
+				return false;
+			}
+			totalSamples += count;
+			return true;
+		}
+
+		while (count > 0) {
+			if (chunks.empty() || chunks.back().size() == chunkSize) {
+				chunks.emplace_back();
+				chunks.back().reserve(chunkSize);
+			}
+			auto& chunk = chunks.back();
+			auto n = std::min(static_cast<size_t>(count), chunkSize - chunk.size());
+			chunk.insert(chunk.end(), data, data + n);
+			data += n;
+			count -= static_cast<int64_t>(n);
+			totalSamples += static_cast<int64_t>(n);
+		}
+		return true;
+	}
+
+	// rewind() : prepare for reading from the start
+	bool rewind()
+	{
+		readPos = 0;
+		if (err || file == nullptr) {
+			return !err;
+		}
+
+		if (std::fflush(file) != 0) {
+			err = true;
+			return false;
+		}
+
+#ifdef SPILLBUFFER_USE_MMAP
+		if (mapped == nullptr && totalSamples > 0) {
+			size_t bytes = static_cast<size_t>(totalSamples) * sizeof(FloatType);
+			void* p = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fileno(file), 0);
+			if (p != MAP_FAILED) {
+				madvise(p, bytes, MADV_SEQUENTIAL);
+				mapped = static_cast<FloatType*>(p);
+				mappedBytes = bytes;
+			}
+		}
+		if (mapped != nullptr) {
+			return true;
+		}
+#endif
+		// no memory-map: fall back to stdio reads
+		if (std::fseek(file, 0, SEEK_SET) != 0) {
+			err = true;
+			return false;
+		}
+		return true;
+	}
+
+	// read() : point data at up to count samples, starting at the read position.
+	// Returns the number of samples available at data (0 at end), which may be less than count at a chunk boundary.
+	// (Chunk boundaries always fall on a frame boundary)
+	int64_t read(const FloatType*& data, int64_t count)
+	{
+		count = std::min(count, totalSamples - readPos);
+		if (err || count <= 0) {
+			return 0;
+		}
+
+		if (file == nullptr) {
+			auto c = static_cast<size_t>(readPos) / chunkSize;
+			auto offset = static_cast<size_t>(readPos) % chunkSize;
+			count = std::min(count, static_cast<int64_t>(chunks[c].size() - offset));
+			data = chunks[c].data() + offset;
+		} else if (mapped != nullptr) {
+			data = mapped + readPos;
+		} else {
+			readBuffer.resize(static_cast<size_t>(count));
+			count = static_cast<int64_t>(std::fread(readBuffer.data(), sizeof(FloatType), static_cast<size_t>(count), file));
+			data = readBuffer.data();
+		}
+
+		readPos += count;
+		return count;
+	}
+
+	int64_t size() const
+	{
+		return totalSamples;
+	}
+
+	bool isSpilled() const
+	{
+		return file != nullptr;
+	}
+
+	bool error() const
+	{
+		return err;
+	}
+
+private:
+	static constexpr size_t framesPerChunk = 65536;
+	size_t chunkSize;
+	size_t maxRamSamples;
+	std::vector<std::vector<FloatType>> chunks;
+	int64_t totalSamples{0};
+	int64_t readPos{0};
+	std::FILE* file{nullptr};
+	FloatType* mapped{nullptr};
+	size_t mappedBytes{0};
+	std::vector<FloatType> readBuffer;
+	bool err{false};
+
+	// spill() : move contents of RAM chunks to a temp file, and release the RAM
+	bool spill()
+	{
+		file = std::tmpfile();
+		if (file == nullptr) {
+			err = true;
+			return false;
+		}
+
+		for (auto& chunk : chunks) {
+			if (std::fwrite(chunk.data(), sizeof(FloatType), chunk.size(), file) != chunk.size()) {
+				err = true;
+				return false;
+			}
+		}
+		std::vector<std::vector<FloatType>>().swap(chunks);
+		return true;
+	}
+
+	void unmap()
+	{
+#ifdef SPILLBUFFER_USE_MMAP
+		if (mapped != nullptr) {
+			munmap(mapped, mappedBytes);
+			mapped = nullptr;
+			mappedBytes = 0;
+		}
+#endif
+	}
+};
+
+} // namespace ReSampler
+
+#endif // SPILLBUFFER_H
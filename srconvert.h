@@ -16,15 +16,90 @@
 #define USE_LAZYGET_ON_INTERPOLATE_DECIMATE
 
 #include "FIRFilter.h"
+#include "asrc.h"
 #include "conversioninfo.h"
 #include "fraction.h"
 #include "ReSampler.h"
 
+#include <deque>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <utility>
+
 namespace ReSampler {
 
 static_assert(std::is_copy_constructible<ConversionInfo>::value, "ConversionInfo needs to be copy Constructible");
 static_assert(std::is_copy_assignable<ConversionInfo>::value, "ConversionInfo needs to be copy Assignable");
 
+// FilterDesignKey : parameters which completely determine the coefficients produced by makeFilterCoefficients()
+struct FilterDesignKey
+{
+	int filterSize;
+	double ft;
+	int sampFreq;
+	int sidelobeAtten;
+	bool minPhase;
+
+	bool operator<(const FilterDesignKey& other) const
+	{
+		return std::tie(filterSize, ft, sampFreq, sidelobeAtten, minPhase) < std::tie(other.filterSize, other.ft, other.sampFreq, other.sidelobeAtten, other.minPhase);
+	}
+};
+
+// FilterDesignCache : process-wide store of designed filters, so that conversions which run in the same process
+// (batch jobs, fan-out targets, channels) only design (and minimum-phase transform) each filter once.
+// Holds at most maxEntries designs (oldest are discarded first)
+template<typename FloatType>
+class FilterDesignCache
+{
+public:
+	static constexpr size_t maxEntries = 32;
+
+	static std::optional<std::vector<FloatType>> get(const FilterDesignKey& key)
+	{
+		std::lock_guard<std::mutex> lock(mutex());
+		auto it = entries().find(key);
+		if (it == entries().end()) {
+			return std::nullopt;
+		}
+		return it->second;
+	}
+
+	static void put(const FilterDesignKey& key, const std::vector<FloatType>& filterTaps)
+	{
+		std::lock_guard<std::mutex> lock(mutex());
+		if (entries().emplace(key, filterTaps).second) {
+			insertionOrder().push_back(key);
+			if (insertionOrder().size() > maxEntries) {
+				entries().erase(insertionOrder().front());
+				insertionOrder().pop_front();
+			}
+		}
+	}
+
+private:
+	static std::mutex& mutex()
+	{
+		static std::mutex m;
+		return m;
+	}
+
+	static std::map<FilterDesignKey, std::vector<FloatType>>& entries()
+	{
+		static std::map<FilterDesignKey, std::vector<FloatType>> e;
+		return e;
+	}
+
+	static std::deque<FilterDesignKey>& insertionOrder()
+	{
+		static std::deque<FilterDesignKey> o;
+		return o;
+	}
+};
+
 template<typename FloatType>
 std::vector<FloatType> makeFilterCoefficients(const ConversionInfo& ci, Fraction fraction)
 {
@@ -34,8 +109,12 @@ std::vector<FloatType> makeFilterCoefficients(const ConversionInfo& ci, Fraction
 	double steepness = 0.090909091 / (ci.lpfTransitionWidth / 100.0);
 
 	// determine filtersize
+	int filterSizeLimit = (ci.maxFilterLength > 0) ? std::min(ci.maxFilterLength, FILTERSIZE_LIMIT) : FILTERSIZE_LIMIT;
+	if (filterSizeLimit % 2 == 0) {
+		filterSizeLimit--; // (filter length is always odd)
+	}
 	int filterSize = static_cast<int>(
-		std::min<int>(FILTERSIZE_BASE * ci.overSamplingFactor * std::max(fraction.denominator, fraction.numerator) * steepness, FILTERSIZE_LIMIT)
+		std::min<int>(FILTERSIZE_BASE * ci.overSamplingFactor * std::max(fraction.denominator, fraction.numerator) * steepness, filterSizeLimit)
 		| 1 // ensure that filter length is always odd
 	);
 
@@ -44,8 +123,13 @@ std::vector<FloatType> makeFilterCoefficients(const ConversionInfo& ci, Fraction
 		195 :
 		160;
 
-	// Make some filter coefficients:
+	// Make some filter coefficients (or re-use a previous design with identical parameters):
 	int sampFreq = ci.overSamplingFactor * ci.inputSampleRate * fraction.numerator;
+	const FilterDesignKey key{filterSize, ft, sampFreq, sidelobeAtten, ci.bMinPhase};
+	if (auto cached = FilterDesignCache<FloatType>::get(key)) {
+		return *cached;
+	}
+
 	std::vector<FloatType> filterTaps(filterSize, 0);
 	FloatType* pFilterTaps = &filterTaps[0];
 	makeLPF<FloatType>(pFilterTaps, filterSize, ft, sampFreq);
@@ -57,15 +141,35 @@ std::vector<FloatType> makeFilterCoefficients(const ConversionInfo& ci, Fraction
 		//return makeMinPhase2<FloatType>(pFilterTaps, filterSize);
 	}
 
+	FilterDesignCache<FloatType>::put(key, filterTaps);
 	return filterTaps;
 }
 
+// getImpulseDelay() : delay (in samples) of a lowpass filter's impulse response.
+// For a linear-phase filter, this is the midpoint (ie the group delay). For a minimum-phase filter, the position of the peak is used.
+template<typename FloatType>
+double getImpulseDelay(const std::vector<FloatType>& filterTaps, bool minPhase)
+{
+	if (filterTaps.empty()) {
+		return 0.0;
+	}
+
+	if (!minPhase) {
+		return (filterTaps.size() - 1) / 2.0;
+	}
+
+	auto peak = std::max_element(filterTaps.begin(), filterTaps.end(), [](FloatType a, FloatType b) {
+		return std::abs(a) < std::abs(b);
+	});
+	return static_cast<double>(std::distance(filterTaps.begin(), peak));
+}
+
 template<typename FloatType>
 class ResamplingStage
 {
 public:
-	ResamplingStage(int L, int M, const FIRFilter<FloatType>& filter, bool bypassMode = false)
-		: L(L), M(M),  m(0), filter(filter), bypassMode(bypassMode)
+	ResamplingStage(int L, int M, FIRFilter<FloatType> filter, bool bypassMode = false)
+		: L(L), M(M),  m(0), filter(std::move(filter)), bypassMode(bypassMode)
 	{
 		SetConvertFunction();
 	}
@@ -84,6 +188,28 @@ public:
 		m = 0;
 	}
 
+	// setPosition() : reset, then set phase as though inputs samples had been converted (see Converter::setPosition()).
+	// Returns the number of output samples which those inputs would have produced
+	int64_t setPosition(int64_t inputs) {
+		reset();
+		if (bypassMode) {
+			return inputs;
+		}
+		const int64_t puts = inputs * L;
+		filter.setPosition(puts, L);
+		m = static_cast<int>(puts % M);
+		return (puts + M - 1) / M;
+	}
+
+	void getMemoryRegions(std::vector<Placement::MemoryRegion>& regions) const {
+		filter.getMemoryRegions(regions);
+	}
+
+	// getMaxOutputSize() : largest number of output samples that convert() can produce from inputSize input samples
+	size_t getMaxOutputSize(size_t inputSize) const {
+		return bypassMode ? inputSize : (inputSize * L + M - 1) / M;
+	}
+
 private:
 	int L;	// interpoLation factor
 	int M;	// deciMation factor
@@ -119,6 +245,13 @@ private:
 	{
 		size_t o = 0;
 		for (size_t i = 0; i < inBufferSize; ++i) {
+			if (inBuffer[i] == 0.0 && filter.isSilent()) { // silence in, silence out (without putting L zeros one at a time)
+				filter.skipZeros(L);
+				std::fill_n(outBuffer + o, L, static_cast<FloatType>(0.0));
+				o += L;
+				continue;
+			}
+
 			for(int l = 0; l < L; ++l) {
 
 #ifdef	USE_LAZYGET_ON_INTERPOLATE
@@ -158,6 +291,16 @@ private:
 		size_t o = 0;
 		int localm = m;
 		for (size_t i = 0; i < inBufferSize; ++i) {
+			if (inBuffer[i] == 0.0 && filter.isSilent()) { // silence in, silence out: skip the L steps, emitting a zero for each output step among them
+				const int firstOutputStep = (M - localm) % M;
+				const int outputs = (firstOutputStep < L) ? (L - 1 - firstOutputStep) / M + 1 : 0;
+				filter.skipZeros(L);
+				std::fill_n(outBuffer + o, outputs, static_cast<FloatType>(0.0));
+				o += outputs;
+				localm = static_cast<int>((static_cast<int64_t>(localm) + L) % M);
+				continue;
+			}
+
 			for(int l = 0; l < L; ++l) {
 
 #ifdef	USE_LAZYGET_ON_INTERPOLATE_DECIMATE
@@ -200,9 +343,16 @@ template <typename FloatType>
 class Converter
 {
 public:
-	explicit Converter(const ConversionInfo& ci)
-		: ci(ci), groupDelay(0.0), isBypassMode(false), gain(1.0)
+	// (filter state and intermediate buffers are allocated from memory, if given - eg an Arena, otherwise from the heap)
+	explicit Converter(const ConversionInfo& ci, std::pmr::memory_resource* memory = nullptr)
+		: ci(ci), groupDelay(0.0), memory(memory), isBypassMode(false), gain(1.0)
 	{
+		if (ci.bAsrc) { // (asynchronous conversion is never bypassed: rates are only nominally equal)
+			isMultistage = false;
+			initAsrc();
+			return;
+		}
+
 		if (ci.outputSampleRate == ci.inputSampleRate) {
 			isBypassMode = true;
 			Converter::ci.bSingleStage = true;
@@ -215,11 +365,18 @@ public:
 			isMultistage = true;
 			initMultistage();
 		}
+
+		startPosition = ci.inputPosition;
+		if (startPosition != 0) {
+			setPosition(startPosition);
+		}
 	}
 
 	void convert(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize)
 	{
-		if (isMultistage) {
+		if (asrc) {
+			asrc->convert(outBuffer, outBufferSize, inBuffer, inBufferSize);
+		} else if (isMultistage) {
 			const FloatType* in = inBuffer; // first stage reads directly from inBuffer. Subsequent stages read from output of previous stage
 			size_t inSize = inBufferSize;
 			size_t outSize = 0;
@@ -245,14 +402,139 @@ public:
 		return gain;
 	}
 
+	// isBypassed() : true if output rate is same as input rate, and samples are passed through unchanged
+	bool isBypassed() const
+	{
+		return isBypassMode;
+	}
+
+	// getLatency() : algorithmic latency (in output samples) - the delay between an input sample and the corresponding output.
+	// Unlike getGroupDelay(), this is reported regardless of delay-trimming, and is non-zero for minimum-phase filters
+	double getLatency() const
+	{
+		return latency;
+	}
+
+	// getBlockSize() : maximum number of input samples per call to convert()
+	size_t getBlockSize() const
+	{
+		return blockSize;
+	}
+
+	// setBlockSize() : set maximum number of input samples per call to convert(), and allocate intermediate buffers accordingly
+	void setBlockSize(size_t value)
+	{
+		blockSize = std::max<size_t>(1, value);
+		intermediateOutputBuffers.clear();
+		size_t size = blockSize;
+		for (int i = 0; i < indexOfLastStage; i++) {
+			size = convertStages[i].getMaxOutputSize(size);
+			intermediateOutputBuffers.emplace_back(size, 0.0, (memory == nullptr) ? std::pmr::get_default_resource() : memory);
+		}
+	}
+
+	// getMaxOutputSize() : largest number of output samples that convert() can produce from inputSize input samples
+	// (each stage is rounded up, since the decimation phase carries over from one call to the next)
+	size_t getMaxOutputSize(size_t inputSize) const
+	{
+		if (asrc) {
+			return asrc->getMaxOutputSize(inputSize);
+		}
+
+		size_t size = inputSize;
+		for (const auto& stage : convertStages) {
+			size = stage.getMaxOutputSize(size);
+		}
+		return size;
+	}
+
+	// getAutoBlockSize() : choose a block size (in samples per channel), such that the working set of one block
+	// (interleaved and per-channel input, stage outputs, per-channel and interleaved output) fits in cacheSize bytes, alongside the filters.
+	// Result is a power of 2, between minAutoBlockSize and maxAutoBlockSize
+	size_t getAutoBlockSize(int nChannels, size_t cacheSize) const
+	{
+		size_t filterBytes = 0;
+		for (int length : filterLengths) {
+			filterBytes += 3 * static_cast<size_t>(length) * sizeof(FloatType); // (kernel, plus double-length signal buffer)
+		}
+		filterBytes *= static_cast<size_t>(nChannels);
+
+		const double ratio = static_cast<double>(getMaxOutputSize(1 << 20)) / (1 << 20);
+		const double stageRatio = static_cast<double>(stageOutputSize(1 << 20)) / (1 << 20);
+		const double bytesPerFrame = static_cast<double>(sizeof(FloatType)) * nChannels * (2.0 + stageRatio + 2.0 * ratio);
+		const size_t budget = std::max(cacheSize / 4, cacheSize - std::min(cacheSize, filterBytes));
+		const auto target = static_cast<size_t>(budget / bytesPerFrame);
+
+		size_t size = minAutoBlockSize;
+		while (size * 2 <= std::min(target, maxAutoBlockSize)) {
+			size *= 2;
+		}
+		return size;
+	}
+
+	// setRatioCorrection() : (asynchronous conversion only) adjust the conversion ratio, to follow drift of input clock. See AsrcEngine
+	void setRatioCorrection(double correction)
+	{
+		if (asrc) {
+			asrc->setRatioCorrection(correction);
+		}
+	}
+
 	void reset()
 	{
+		if (asrc) {
+			asrc->reset();
+			return;
+		}
+
 		for (int i = 0; i < numStages; i++) {
 			convertStages[i].reset();
 			if (i != indexOfLastStage) {
 				std::fill(intermediateOutputBuffers[i].begin(), intermediateOutputBuffers[i].end(), 0.0);
 			}
 		}
+
+		if (startPosition != 0) {
+			setPosition(startPosition);
+		}
+	}
+
+	// setPosition() : reset, and set the phase of every stage as though inputPosition samples had already been converted
+	// (with zero history). Used to convert a region of a longer input (starting at inputPosition), such that once the filters
+	// have filled (see getInputSpan()), the output is bit-identical to the corresponding part of a conversion of the whole input.
+	// Returns the (raw - ie before delay trimming) output position corresponding to inputPosition, or -1 if not supported (asrc)
+	int64_t setPosition(int64_t inputPosition)
+	{
+		if (asrc) {
+			return -1;
+		}
+		int64_t position = inputPosition;
+		for (auto& stage : convertStages) {
+			position = stage.setPosition(position);
+		}
+		for (auto& buffer : intermediateOutputBuffers) {
+			std::fill(buffer.begin(), buffer.end(), 0.0);
+		}
+		return position;
+	}
+
+	// getMemoryRegions() : filter state and intermediate buffers (for reporting placement)
+	std::vector<Placement::MemoryRegion> getMemoryRegions() const
+	{
+		std::vector<Placement::MemoryRegion> regions;
+		for (const auto& stage : convertStages) {
+			stage.getMemoryRegions(regions);
+		}
+		for (const auto& buffer : intermediateOutputBuffers) {
+			regions.emplace_back(buffer.data(), buffer.size() * sizeof(FloatType));
+		}
+		return regions;
+	}
+
+	// getInputSpan() : number of input samples (rounded up) which contribute to each output sample (ie length of the overall impulse response, in input samples)
+	int getInputSpan() const
+	{
+		return static_cast<int>(std::ceil(inputSpan));
 	}
 
 private:
@@ -269,11 +551,38 @@ private:
 		f.numerator *= ci.overSamplingFactor;
 		f.denominator *= ci.overSamplingFactor;
 
-		FIRFilter<FloatType> firFilter(filterTaps.data(), static_cast<int>(filterTaps.size()));
-		convertStages.emplace_back(f.numerator, f.denominator, firFilter, isBypassMode);
+		FIRFilter<FloatType> firFilter(filterTaps.data(), static_cast<int>(filterTaps.size()), memory);
+		convertStages.emplace_back(f.numerator, f.denominator, std::move(firFilter), isBypassMode);
+		filterLengths.push_back(static_cast<int>(filterTaps.size()));
+		inputSpan = isBypassMode ? 0.0 : static_cast<double>(filterTaps.size()) / f.numerator;
 		groupDelay = (ci.bMinPhase || !ci.bDelayTrim) ? 0 : (filterTaps.size() - 1) / 2 / f.denominator;
+		latency = getImpulseDelay(filterTaps, ci.bMinPhase) / f.denominator;
 		if (isBypassMode) {
 			groupDelay = 0;
+			latency = 0.0;
+		}
+
+		if (ci.blockSize > 0) {
+			setBlockSize(static_cast<size_t>(ci.blockSize));
+		}
+	}
+
+	void initAsrc()
+	{
+		numStages = 1;
+		indexOfLastStage = 0;
+		asrc.emplace(ci.inputSampleRate, ci.outputSampleRate, ci.lpfCutoff, ci.lpfTransitionWidth, ci.maxFilterLength);
+		asrc->setRatioCorrection(1.0 + ci.asrcDrift * 1e-6);
+		asrc->reset(); // (start at the requested ratio)
+		filterLengths.push_back(asrc->getFilterLength());
+
+		// callers multiply by the interpolation factor (numerator) to compensate for zero-stuffing, which the ASRC doesn't do:
+		gain = 1.0 / getFractionFromSamplerates(ci.inputSampleRate, ci.outputSampleRate).numerator;
+		latency = asrc->getLatency();
+		groupDelay = ci.bDelayTrim ? std::floor(latency) : 0.0;
+
+		if (ci.blockSize > 0) {
+			setBlockSize(static_cast<size_t>(ci.blockSize));
 		}
 	}
 
@@ -287,6 +596,7 @@ private:
 		double lastStopFreq = stretch * inputRate / 2.0;
 		std::string stageInputName(ci.inputFilename);
 		double ft = ci.lpfCutoff / 100 * std::min(ci.inputSampleRate, ci.outputSampleRate) / 2.0;
+		double inputScale = 1.0; // samples of original input per input sample of current stage
 
 		for (int i = 0; i < numStages; i++) {
 
@@ -331,7 +641,7 @@ private:
 			// dumpFilter(filterTaps.data(), filterTaps.size());
 
 			// make the filter
-			FIRFilter<FloatType> firFilter(filterTaps.data(), static_cast<int>(filterTaps.size()));
+			FIRFilter<FloatType> firFilter(filterTaps.data(), static_cast<int>(filterTaps.size()), memory);
 
 			if (ci.bShowStages) { // dump stage parameters:
 				std::cout << "Stage: " << 1 + i << "\n";
@@ -367,37 +677,38 @@ private:
 			Fraction f = fractions[i];
 			f.numerator *= stageCi.overSamplingFactor;
 			f.denominator *= stageCi.overSamplingFactor;
-			convertStages.emplace_back(f.numerator, f.denominator, firFilter, false);
+			convertStages.emplace_back(f.numerator, f.denominator, std::move(firFilter), false);
+			filterLengths.push_back(static_cast<int>(filterTaps.size()));
+			inputSpan += static_cast<double>(filterTaps.size()) / f.numerator * inputScale; // (this stage's span, in samples of original input)
+			inputScale *= static_cast<double>(f.denominator) / f.numerator;
 
 			// add Group Delay:
 			groupDelay *= (static_cast<double>(f.numerator) / f.denominator); // scale previous delay according to conversion ratio
 			groupDelay += (ci.bMinPhase || !ci.bDelayTrim) ? 0 : (filterTaps.size() - 1) / 2 / f.denominator; // add delay introduced by this stage
 
-			// calculate size of output buffer for this stage:
-			double cumulativeNumerator = 1.0;
-			double cumulativeDenominator = 1.0;
-			for (int j = 0; j <= i; j++) {
-				cumulativeNumerator *= fractions[j].numerator;
-				cumulativeDenominator *= fractions[j].denominator;
-			}
-			size_t outBufferSize = static_cast<size_t>(std::ceil(BUFFERSIZE * cumulativeNumerator / cumulativeDenominator));
+			// same for latency:
+			latency *= (static_cast<double>(f.numerator) / f.denominator);
+			latency += getImpulseDelay(filterTaps, ci.bMinPhase) / f.denominator;
 
 			// conditionally show output buffer size
-			if (ci.bShowStages) {
-				//std::cout << cumulativeNumerator << " / " << cumulativeDenominator << "\n";
+			if (ci.bShowStages && ci.blockSize > 0) {
+				size_t outBufferSize = static_cast<size_t>(ci.blockSize);
+				for (int j = 0; j <= i; j++) {
+					outBufferSize = convertStages[j].getMaxOutputSize(outBufferSize);
+				}
 				std::cout << "Output Buffer Size: " << outBufferSize << "\n\n" << std::endl;
 			}
 
-			// make output buffer for this stage (last stage doesn't need one)
-			if (i != indexOfLastStage) {
-				intermediateOutputBuffers.emplace_back(std::vector<FloatType>(outBufferSize, 0.0));
-			}
-
 			// set input rate of next stage
 			inputRate = stageCi.outputSampleRate;
 
 		} // ends loop over i
 
+		// make output buffers for each stage (last stage doesn't need one). If block size is not yet known, setBlockSize() must be called later
+		if (ci.blockSize > 0) {
+			setBlockSize(static_cast<size_t>(ci.blockSize));
+		}
+
 		if (ci.bShowStages) {
 			std::cout << "Command lines to do this conversion in discreet steps:\n";
 			for (auto& cmdline : stageCommandLines) {
@@ -407,13 +718,35 @@ private:
 		}
 	} // initMultistage()
 
+	// stageOutputSize() : total size of intermediate (stage) outputs, for inputSize input samples
+	size_t stageOutputSize(size_t inputSize) const
+	{
+		size_t total = 0;
+		size_t size = inputSize;
+		for (int i = 0; i < indexOfLastStage; i++) {
+			size = convertStages[i].getMaxOutputSize(size);
+			total += size;
+		}
+		return total;
+	}
+
 private:
+	static constexpr size_t minAutoBlockSize = 1024;
+	static constexpr size_t maxAutoBlockSize = 65536;
+
 	ConversionInfo ci;
 	double groupDelay;
+	std::pmr::memory_resource* memory; // (nullptr: heap)
+	double latency{0.0};
+	double inputSpan{0.0};
+	int64_t startPosition{0}; // (see setPosition())
 	std::vector<ResamplingStage<FloatType>> convertStages;
+	std::optional<AsrcEngine<FloatType>> asrc; // (asynchronous conversion only - replaces convertStages)
 	int numStages{};
 	int indexOfLastStage{};
-	std::vector<std::vector<FloatType>> intermediateOutputBuffers;	// intermediate output buffer for each ConvertStage;
+	std::vector<std::pmr::vector<FloatType>> intermediateOutputBuffers;	// intermediate output buffer for each ConvertStage;
+	std::vector<int> filterLengths; // (for each stage)
+	size_t blockSize{0};
 	std::vector<std::string> stageCommandLines;
 	bool isMultistage;
 	bool isBypassMode;
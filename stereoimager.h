@@ -23,7 +23,7 @@ class StereoImager : public Effect<FloatType>
 public:
 	virtual const FloatType* process(const FloatType* inputBuffer, int sampleCount)
 	{
-		FloatType* p = Effect<FloatType>::outputBuffer.get();
+		FloatType* p = Effect<FloatType>::outputBuffer;
 		for(int i = 0; i < sampleCount; i += Effect<FloatType>::channelCount) {
 			double inL = inputBuffer[i];
 			double inR = inputBuffer[i + 1];
@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+
+# asynchronous sample rate conversion (--asrc) with synthetic clock drift
+
+# note: ensure ReSampler in your PATH
+resampler_path=ReSampler
+
+# specify folder locations
+input_path=./inputs
+output_path=./outputs
+
+# clear old outputs:
+rm $output_path/*.*
+rm $output_path/._*
+
+# reference: asynchronous conversion to 48kHz, with no drift
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/sweep-48k-reference.wav -r 48000 -b 64f --asrc --doubleprecision
+
+# make a synthetic drifting file: a recording made at 48002Hz, labelled as 48000Hz (ie input clock running 41.667ppm fast)
+# (48000/48002 - 1 = -41.665ppm, relative to the original)
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/sweep-48k-drifting-fast.wav -r 48000 -b 64f --asrc -41.6649 --doubleprecision
+
+# correct the drift (result should match the reference)
+$resampler_path -i $output_path/sweep-48k-drifting-fast.wav -o $output_path/sweep-48k-drift-corrected-fast.wav -r 48000 -b 64f --asrc 41.6667 --doubleprecision
+
+# same again, with input clock running 62.5ppm slow (recorded at 47997Hz)
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/sweep-48k-drifting-slow.wav -r 48000 -b 64f --asrc 62.5039 --doubleprecision
+$resampler_path -i $output_path/sweep-48k-drifting-slow.wav -o $output_path/sweep-48k-drift-corrected-slow.wav -r 48000 -b 64f --asrc -62.5 --doubleprecision
+
+# asynchronous conversion between nominal rates, and with limited filter length:
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/96khz_sweep-3dBFS_32f-to44k-asrc.wav -r 44100 -b 24 --asrc
+$resampler_path -i $input_path/44khz_sweep-3dBFS_32f.wav -o $output_path/44khz_sweep-3dBFS_32f-to48k-asrc-short.wav -r 48000 -b 24 --asrc --maxFilterLength 64
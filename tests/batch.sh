@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+
+# batch mode: many files converted by one process (manifest and wildcard pattern)
+
+# note: ensure ReSampler in your PATH
+resampler_path=ReSampler
+
+# specify folder locations
+input_path=./inputs
+output_path=./outputs
+
+# clear old outputs:
+rm -f $output_path/batch-*
+
+# manifest
+manifest=$output_path/batch-manifest.txt
+cat > $manifest <<MANIFEST
+# infile outfile [options]
+$input_path/96khz_sweep-3dBFS_32f.wav $output_path/batch-96k-to-44k.wav -r 44100
+$input_path/44khz_sweep-3dBFS_32f.wav $output_path/batch-44k-to-96k.wav -r 96000
+-i $input_path/48khz_sweep-3dBFS_32f.wav -o $output_path/batch-48k-to-44k-mp.wav -r 44100 --minphase
+MANIFEST
+$resampler_path --batch $manifest -b 24
+
+# wildcard pattern (all sweeps to 32kHz)
+$resampler_path --batch "$input_path/*_sweep-3dBFS_32f.wav" -o "$output_path/batch-*-to-32k.wav" -r 32000 -b 24
@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+
+# multiple output targets from one input (shared decode, peak scan and decimation stages)
+
+# note: ensure ReSampler in your PATH
+resampler_path=ReSampler
+
+# specify folder locations
+input_path=./inputs
+output_path=./outputs
+
+# clear old outputs:
+rm $output_path/*.*
+rm $output_path/._*
+
+# 96kHz master to 44.1kHz/16, 48kHz/24, 24kHz/24 and 96kHz/24 (48kHz and 24kHz share the initial 2:1 stage)
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -b 24 --dither --seed 1 -o $output_path/sweep-fanout-44k-16.wav -r 44100 -b 16 -o $output_path/sweep-fanout-48k-24.wav -r 48000 -o $output_path/sweep-fanout-24k-24.wav -r 24000 -o $output_path/sweep-fanout-96k-24.wav -r 96000
+
+# same targets, converted individually (outputs should match, except for 24kHz, which is converted via 48kHz)
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/sweep-single-44k-16.wav -r 44100 -b 16 --dither --seed 1
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/sweep-single-48k-24.wav -r 48000 -b 24 --dither --seed 1
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/sweep-single-24k-24.wav -r 24000 -b 24 --dither --seed 1
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/sweep-single-96k-24.wav -r 96000 -b 24 --dither --seed 1
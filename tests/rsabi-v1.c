@@ -0,0 +1,95 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+/* rsabi-v1.c : binary compatibility test for the C interface of ReSamplerLib (see resampler_c.h)
+
+   Behaves like a program compiled against version 1 of resampler_c.h, and linked against version 1 of the library:
+   its rs_params has only the version 1 members, and it calls rs_params_init@RESAMPLER_1.
+   Checks that rs_params_init() doesn't write past the end of the (shorter) struct,
+   and that rs_create() doesn't read past it (so garbage after the struct, or in its padding, doesn't matter).
+   Returns 0 on success. */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct rs_resampler rs_resampler;
+
+/* rs_params, as of version 1 of the interface */
+typedef struct rs_params_v1
+{
+	size_t struct_size;
+	int input_sample_rate;
+	int output_sample_rate;
+	int channels;
+	size_t max_block_size;
+	double gain;
+	double lpf_cutoff;
+	double lpf_transition_width;
+	int min_phase;
+	int multi_stage;
+	int max_stages;
+	int delay_trim;
+	int double_precision;
+} rs_params_v1;
+
+void rs_params_init(rs_params_v1* params);
+rs_resampler* rs_create(const rs_params_v1* params, int* error);
+void rs_destroy(rs_resampler* rs);
+int rs_process_f32(rs_resampler* rs, const float* in, size_t in_frames, size_t* in_used, float* out, size_t out_capacity, size_t* out_frames);
+const char* rs_strerror(int error);
+
+__asm__(".symver rs_params_init, rs_params_init@RESAMPLER_1");
+
+#define GUARD_BYTES 64
+#define FRAMES 4096
+
+int main(void)
+{
+	/* struct followed by guard bytes; 0xFF everywhere, including padding within the struct */
+	struct {
+		rs_params_v1 params;
+		unsigned char guard[GUARD_BYTES];
+	} s;
+	memset(&s, 0xFF, sizeof(s));
+
+	rs_params_init(&s.params);
+	for (size_t i = 0; i < GUARD_BYTES; i++) {
+		if (s.guard[i] != 0xFF) {
+			fprintf(stderr, "rsabi-v1: rs_params_init() wrote past the end of a version 1 rs_params\n");
+			return 1;
+		}
+	}
+	if (s.params.struct_size != sizeof(rs_params_v1)) {
+		fprintf(stderr, "rsabi-v1: rs_params_init() set struct_size to %zu (expected %zu)\n", s.params.struct_size, sizeof(rs_params_v1));
+		return 1;
+	}
+
+	s.params.max_block_size = FRAMES;
+	int err = 0;
+	rs_resampler* rs = rs_create(&s.params, &err);
+	if (rs == NULL) {
+		fprintf(stderr, "rsabi-v1: rs_create() failed: %s\n", rs_strerror(err));
+		return 1;
+	}
+
+	static float in[FRAMES * 2];
+	static float out[FRAMES * 4];
+	size_t inUsed = 0;
+	size_t outFrames = 0;
+	err = rs_process_f32(rs, in, FRAMES, &inUsed, out, FRAMES * 2, &outFrames);
+	rs_destroy(rs);
+	if (err != 0 || inUsed != FRAMES) {
+		fprintf(stderr, "rsabi-v1: rs_process_f32() failed: %s (%zu of %d frames consumed)\n", rs_strerror(err), inUsed, FRAMES);
+		return 1;
+	}
+
+	printf("rsabi-v1: ok\n");
+	return 0;
+}
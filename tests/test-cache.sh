@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+
+# output cache: second and third conversions should be cache hits, and all outputs identical
+
+# note: ensure ReSampler in your PATH
+resampler_path=ReSampler
+
+# specify folder locations
+input_path=./inputs
+output_path=./outputs
+cache_path=$output_path/cache
+
+# clear old outputs:
+rm -rf $cache_path
+rm -f $output_path/cache-*
+
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/cache-1.wav -r 44100 -b 16 --dither --seed 1 --cache $cache_path
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/cache-2.wav -r 44100 -b 16 --dither --seed 1 --cache $cache_path
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/cache-3.wav -r 44100 -b 16 --dither --seed 1 --cache $cache_path --cacheLink
+
+cmp $output_path/cache-1.wav $output_path/cache-2.wav && cmp $output_path/cache-1.wav $output_path/cache-3.wav && echo "outputs identical"
+
+# a later (uncached) conversion to a linked output must not change the cached result
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/cache-3.wav -r 48000
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/cache-4.wav -r 44100 -b 16 --dither --seed 1 --cache $cache_path
+cmp $output_path/cache-1.wav $output_path/cache-4.wav && echo "cached result unchanged"
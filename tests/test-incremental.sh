@@ -0,0 +1,37 @@
+#!/usr/bin/env bash
+
+# incremental conversion: edit a copy of the input, convert again with --incremental,
+# and check that the patched output is identical to a full conversion of the edited input
+
+# note: ensure ReSampler in your PATH
+resampler_path=ReSampler
+
+# specify folder locations
+input_path=./inputs
+output_path=./outputs
+
+# clear old outputs:
+rm -f $output_path/incremental-*
+
+cp $input_path/96khz_sweep-3dBFS_32f.wav $output_path/incremental-input.wav
+$resampler_path -i $output_path/incremental-input.wav -o $output_path/incremental-patched.wav -r 44100 -b 24 --incremental
+
+# edit: copy 4096 frames (8 bytes per frame) from one part of the input to another
+dd if=$output_path/incremental-input.wav of=$output_path/incremental-input.wav bs=8 skip=300000 seek=200000 count=4096 conv=notrunc 2>/dev/null
+
+$resampler_path -i $output_path/incremental-input.wav -o $output_path/incremental-patched.wav -r 44100 -b 24 --incremental
+$resampler_path -i $output_path/incremental-input.wav -o $output_path/incremental-full.wav -r 44100 -b 24
+
+cmp $output_path/incremental-patched.wav $output_path/incremental-full.wav && echo "outputs identical"
+
+# 32-bit float output: after patching, the PEAK chunk must agree with the actual peak of the (patched) output.
+# Make a quiet input, and patch a louder part into it, so that the peak of the output changes
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/incremental-quiet.wav -r 96000 -b 32f --gain 0.1 --noClippingProtection
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/incremental-loud.wav -r 96000 -b 32f
+$resampler_path -i $output_path/incremental-quiet.wav -o $output_path/incremental-patched-32f.wav -r 44100 -b 32f --incremental
+dd if=$output_path/incremental-loud.wav of=$output_path/incremental-quiet.wav bs=8 skip=300000 seek=300000 count=4096 conv=notrunc 2>/dev/null
+$resampler_path -i $output_path/incremental-quiet.wav -o $output_path/incremental-patched-32f.wav -r 44100 -b 32f --incremental
+
+peak_chunk=$($resampler_path -i $output_path/incremental-patched-32f.wav -o $output_path/incremental-check.wav -r 48000 | grep "Peak input sample" | cut -d ' ' -f 4)
+peak_actual=$($resampler_path -i $output_path/incremental-patched-32f.wav -o $output_path/incremental-check.wav -r 48000 --ignorePeakChunk | grep "Peak input sample" | cut -d ' ' -f 4)
+[ -n "$peak_chunk" ] && [ "$peak_chunk" = "$peak_actual" ] && echo "PEAK chunk matches peak of patched output ($peak_actual)"
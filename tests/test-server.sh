@@ -0,0 +1,27 @@
+#!/usr/bin/env bash
+
+# server mode: conversions sent to a running server with rsclient (outputs should match direct conversions)
+
+# note: ensure ReSampler and rsclient in your PATH
+resampler_path=ReSampler
+client_path=rsclient
+
+# specify folder locations
+input_path=./inputs
+output_path=./outputs
+
+# clear old outputs:
+rm -f $output_path/server-* $output_path/direct-*
+
+export RESAMPLER_SOCKET=/tmp/resampler-test.sock
+$resampler_path --server &
+sleep 1
+
+for rate in 44100 48000 96000; do
+	$client_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/server-sweep-$rate.wav -r $rate -b 24
+	$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/direct-sweep-$rate.wav -r $rate -b 24 > /dev/null
+	cmp $output_path/server-sweep-$rate.wav $output_path/direct-sweep-$rate.wav && echo "$rate: same"
+done
+
+$client_path --stopServer
+wait
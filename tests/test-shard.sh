@@ -0,0 +1,24 @@
+#!/usr/bin/env bash
+
+# sharded conversion: convert 4 parts of the input in parallel, merge them,
+# and check that the merged output is identical to a conversion of the whole input
+
+# note: ensure ReSampler in your PATH
+resampler_path=ReSampler
+
+# specify folder locations
+input_path=./inputs
+output_path=./outputs
+
+# clear old outputs:
+rm -f $output_path/shard-*
+
+for k in 1 2 3 4; do
+	$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/shard-part$k.wav -r 44100 -b 24 --shard $k/4 &
+done
+wait
+
+$resampler_path --merge $output_path/shard-part1.wav $output_path/shard-part2.wav $output_path/shard-part3.wav $output_path/shard-part4.wav -o $output_path/shard-merged.wav
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o $output_path/shard-full.wav -r 44100 -b 24
+
+cmp $output_path/shard-merged.wav $output_path/shard-full.wav && echo "outputs identical"
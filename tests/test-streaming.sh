@@ -0,0 +1,24 @@
+#!/usr/bin/env bash
+
+# note: ensure ReSampler in your PATH
+resampler_path=ReSampler
+
+# specify folder locations
+input_path=./inputs
+output_path=./outputs
+
+# clear old outputs:
+rm $output_path/*.*
+rm $output_path/._*
+
+# stdin to stdout (wav)
+cat $input_path/96khz_sweep-3dBFS_32f.wav | $resampler_path -i - -o - -r 44100 -b 24 > $output_path/96khz_sweep-3dBFS_32f-to44k24-piped.wav
+
+# stdin to stdout (wav), with limiter
+cat $input_path/96khz_sweep-3dBFS_32f.wav | $resampler_path -i - -o - -r 44100 -b 16 --gain 2 --limiter --dither > $output_path/96khz_sweep-3dBFS_32f-to44k16-limited-piped.wav
+
+# file to stdout (raw), then raw stdin back to wav file
+$resampler_path -i $input_path/96khz_sweep-3dBFS_32f.wav -o - --raw-output -r 44100 -b 32f | $resampler_path -i - -o $output_path/96khz_sweep-3dBFS_44k32f-from-raw-pipe.wav -r 44100 -b 32f --raw-input 44100 32f
+
+# chain of conversions
+cat $input_path/96khz_sweep-3dBFS_32f.wav | $resampler_path -i - -o - -r 48000 -b 32f | $resampler_path -i - -o - -r 44100 -b 16 > $output_path/96khz_sweep-3dBFS_32f-to48k-to44k16-piped.wav
@@ -0,0 +1,328 @@
+/*
+* Copyright (C) 2016 - 2026 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// threadbudget.h : how many threads ReSampler should run at once
+
+// ThreadBudget combines:
+// - the number of CPUs this process may run on (sched_getaffinity),
+// - the CPU quota of its cgroup (cgroup v2 cpu.max, or v1 cpu.cfs_quota_us / cpu.cfs_period_us), rounded up,
+// - the GNU make jobserver (when run from make -j): the process has one implicit job slot, and each additional thread
+//   must hold a token, read from the jobserver (without waiting) when there is work for it, and written back when it is done,
+//   so that all the jobs of a build share the -j limit.
+// Under make -j without access to the jobserver (recipe not marked with '+'), ReSampler runs one thread at a time, as make does.
+
+#ifndef THREADBUDGET_H
+#define THREADBUDGET_H 1
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined (_WIN32) && !defined (_WIN64)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined (__linux__)
+#include <sched.h>
+#endif
+
+namespace ReSampler {
+
+class ThreadBudget
+{
+public:
+	// instance() : the budget for this process
+	static ThreadBudget& instance()
+	{
+		static ThreadBudget budget;
+		return budget;
+	}
+
+	ThreadBudget(const ThreadBudget&) = delete;
+	ThreadBudget& operator=(const ThreadBudget&) = delete;
+
+	~ThreadBudget()
+	{
+#if !defined (_WIN32) && !defined (_WIN64)
+		for (char token : heldTokens) { // (return any tokens still held)
+			writeToken(token);
+		}
+		if (readFd >= 0 && ownReadFd) {
+			close(readFd);
+		}
+		if (writeFd >= 0 && ownWriteFd) {
+			close(writeFd);
+		}
+#endif
+	}
+
+	// maxThreads() : most threads worth running at once (CPUs available to this process, within its cgroup quota)
+	int maxThreads() const
+	{
+		return maxCpus;
+	}
+
+	// jobserverMode() : 0 : no jobserver, 1 : make jobserver, -1 : make -j, but jobserver not accessible (run one thread)
+	int jobserverMode() const
+	{
+		return jobserver;
+	}
+
+	// tryAcquire() : try to obtain permission to run one more thread (besides the implicit one). Doesn't wait.
+	bool tryAcquire()
+	{
+		if (jobserver == 0) {
+			return true;
+		}
+#if !defined (_WIN32) && !defined (_WIN64)
+		if (jobserver > 0) {
+			char token;
+			if (read(readFd, &token, 1) == 1) {
+				std::lock_guard<std::mutex> lock(mutex);
+				heldTokens.push_back(token);
+				return true;
+			}
+		}
+#endif
+		return false;
+	}
+
+	// release() : give back permission obtained by tryAcquire()
+	void release()
+	{
+#if !defined (_WIN32) && !defined (_WIN64)
+		if (jobserver > 0) {
+			char token;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (heldTokens.empty()) {
+					return;
+				}
+				token = heldTokens.back();
+				heldTokens.pop_back();
+			}
+			writeToken(token);
+		}
+#endif
+	}
+
+	// describe() : summary of budget (for messages)
+	std::string describe() const
+	{
+		std::ostringstream s;
+		s << "up to " << maxCpus << " thread" << (maxCpus == 1 ? "" : "s") << " (" << affinityCpus << " CPU" << (affinityCpus == 1 ? "" : "s");
+		if (quotaCpus > 0.0) {
+			s << ", cgroup quota " << quotaCpus << " CPU" << (quotaCpus == 1.0 ? "" : "s");
+		}
+		s << ")";
+		if (jobserver > 0) {
+			s << ", sharing make jobserver";
+		} else if (jobserver < 0) {
+			s << ", one thread: make jobserver not accessible";
+		}
+		return s.str();
+	}
+
+private:
+	int maxCpus{1};
+	int affinityCpus{1};
+	double quotaCpus{0.0}; // (0: no quota)
+	int jobserver{0};
+	int readFd{-1};
+	int writeFd{-1};
+	bool ownReadFd{false};
+	bool ownWriteFd{false};
+	std::vector<char> heldTokens;
+	std::mutex mutex;
+
+	ThreadBudget()
+	{
+		affinityCpus = getAffinityCpus();
+		quotaCpus = getCgroupQuota();
+		maxCpus = affinityCpus;
+		if (quotaCpus > 0.0) {
+			maxCpus = std::max(1, std::min(maxCpus, static_cast<int>(std::ceil(quotaCpus))));
+		}
+		openJobserver();
+	}
+
+	static int getAffinityCpus()
+	{
+#if defined (__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+			return std::max(1, CPU_COUNT(&set));
+		}
+#endif
+		return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	// getCgroupQuota() : CPU quota (in CPUs) of this process's cgroup, or of its most restrictive ancestor (0: no quota)
+	static double getCgroupQuota()
+	{
+		double quota = 0.0;
+#if defined (__linux__)
+		auto applyQuota = [&quota](double q) {
+			if (q > 0.0 && (quota == 0.0 || q < quota)) {
+				quota = q;
+			}
+		};
+
+		std::ifstream cgroups("/proc/self/cgroup");
+		std::string line;
+		while (std::getline(cgroups, line)) { // lines: hierarchy-ID:controllers:path
+			const auto colon1 = line.find(':');
+			const auto colon2 = line.find(':', colon1 + 1);
+			if (colon1 == std::string::npos || colon2 == std::string::npos) {
+				continue;
+			}
+			const std::string controllers = line.substr(colon1 + 1, colon2 - colon1 - 1);
+			std::string path = line.substr(colon2 + 1);
+
+			std::vector<std::string> roots;
+			if (controllers.empty()) { // v2
+				roots = {"/sys/fs/cgroup"};
+			} else if (("," + controllers + ",").find(",cpu,") != std::string::npos) { // v1
+				roots = {"/sys/fs/cgroup/cpu,cpuacct", "/sys/fs/cgroup/cpu"};
+			} else {
+				continue;
+			}
+
+			for (const auto& root : roots) {
+				for (std::string p = path;; p = p.substr(0, p.find_last_of('/'))) { // (this cgroup, and its ancestors)
+					if (controllers.empty()) {
+						std::ifstream cpuMax(root + p + "/cpu.max"); // "max 100000" or "<quota> <period>"
+						std::string q;
+						double period = 0.0;
+						if (cpuMax >> q >> period && q != "max" && period > 0.0) {
+							applyQuota(std::atof(q.c_str()) / period);
+						}
+					} else {
+						std::ifstream quotaFile(root + p + "/cpu.cfs_quota_us");
+						std::ifstream periodFile(root + p + "/cpu.cfs_period_us");
+						double q = 0.0;
+						double period = 0.0;
+						if (quotaFile >> q && periodFile >> period && q > 0.0 && period > 0.0) {
+							applyQuota(q / period);
+						}
+					}
+					if (p.empty() || p == "/") {
+						break;
+					}
+				}
+			}
+		}
+#endif
+		return quota;
+	}
+
+	// openJobserver() : find jobserver from MAKEFLAGS (--jobserver-auth=R,W or fifo:PATH; older makes: --jobserver-fds=R,W)
+	void openJobserver()
+	{
+		const char* env = std::getenv("MAKEFLAGS");
+		if (env == nullptr) {
+			return;
+		}
+		std::istringstream flags(env);
+		std::string flag;
+		std::string auth;
+		while (flags >> flag) {
+			for (const std::string prefix : {"--jobserver-auth=", "--jobserver-fds="}) {
+				if (flag.compare(0, prefix.size(), prefix) == 0) {
+					auth = flag.substr(prefix.size()); // (last one applies)
+				}
+			}
+		}
+		if (auth.empty()) {
+			return;
+		}
+
+#if !defined (_WIN32) && !defined (_WIN64)
+		if (auth.compare(0, 5, "fifo:") == 0) {
+			readFd = open(auth.c_str() + 5, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+			writeFd = open(auth.c_str() + 5, O_WRONLY | O_CLOEXEC);
+			ownReadFd = ownWriteFd = true;
+		} else {
+			const auto comma = auth.find(',');
+			const int r = std::atoi(auth.c_str());
+			const int w = (comma == std::string::npos) ? -1 : std::atoi(auth.c_str() + comma + 1);
+			struct stat st;
+			if (r >= 0 && w >= 0 && fstat(r, &st) == 0 && S_ISFIFO(st.st_mode) && fcntl(w, F_GETFD) != -1) {
+				// read through a separate (non-blocking) open file description, so as not to change the mode of the shared one:
+				readFd = open(("/proc/self/fd/" + std::to_string(r)).c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+				ownReadFd = (readFd >= 0);
+				writeFd = w;
+			}
+		}
+		jobserver = (readFd >= 0 && writeFd >= 0) ? 1 : -1;
+#else
+		jobserver = -1;
+#endif
+	}
+
+	void writeToken(char token)
+	{
+#if !defined (_WIN32) && !defined (_WIN64)
+		while (write(writeFd, &token, 1) != 1) {
+			if (errno != EINTR && errno != EAGAIN) {
+				break;
+			}
+		}
+#else
+		(void)token;
+#endif
+	}
+};
+
+// ThreadTokens : permission to run up to wanted threads besides the calling one, for the lifetime of the object
+// (obtained from the ThreadBudget without waiting, so count() may be anywhere from 0 to wanted)
+class ThreadTokens
+{
+public:
+	explicit ThreadTokens(int wanted)
+	{
+		auto& budget = ThreadBudget::instance();
+		while (n < wanted && budget.tryAcquire()) {
+			n++;
+		}
+	}
+
+	~ThreadTokens()
+	{
+		auto& budget = ThreadBudget::instance();
+		for (; n > 0; n--) {
+			budget.release();
+		}
+	}
+
+	ThreadTokens(const ThreadTokens&) = delete;
+	ThreadTokens& operator=(const ThreadTokens&) = delete;
+
+	int count() const
+	{
+		return n;
+	}
+
+private:
+	int n{0};
+};
+
+} // namespace ReSampler
+
+#endif // THREADBUDGET_H